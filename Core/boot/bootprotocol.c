@@ -6,67 +6,191 @@
  */
 
 #include "bootprotocol.h"
+#include "NuMicro.h"
 #include "boot_system.h"
 #include "commuch.h"
+#include "crc32.h"
+#include "delta.h"
 #include "device.h"
 #include "flash.h"
+#include "slot.h"
+#include "unpack.h"
+#include "w25q128jv.h"
 
 #include "lfs.h"
 #include "lfs_port.h"
 
-#define BUFFERSIZE 516
-static uint8_t bl_buffer[BUFFERSIZE] = {0};
+#define BL_PACKET_TIMEOUT_MS 500  // inter-byte timeout within a packet
+
+#define BUFFERSIZE 516  // /boot record: ADDR | 512 bytes page
+
+#define W25Q128JV_SECTOR 4096
+#define W25Q128JV_BLOCK  65536
+
+#define PACKETSIZE (BL_DATA_MAX + 4)  // and the CRC-32 of a reply
+
+#if (BL_DATA_MAX != 8 + FMC_FLASH_PAGE_SIZE)
+#error "BL_DATA_MAX must hold a windowed write of a FMC page"
+#endif
+static uint8_t bl_buffer[PACKETSIZE] __attribute__((__aligned__(4))) = {0};
+
+/* The other half of the ping-pong, see bl_command_process(). */
+static uint8_t bl_buffer_ahead[PACKETSIZE] __attribute__((__aligned__(4)));
+
+static uint8_t win_size;      // granted window size
+static uint16_t win_base;     // oldest sequence number not programmed yet
+static uint32_t win_received; // bit n: win_base + n programmed
+static uint32_t win_nacked;   // bit n: win_base + n reported missing
 
 /*******************************************************************************
  * Basic Operation
  ******************************************************************************/
 
-uint8_t get_packet(bl_packet_t *packet)
+static RAMFUNC uint16_t trailer_size(bl_packet_t *packet)
 {
-    uint8_t cmd;
-    uint8_t len_h, len_l;
-    uint8_t chksum = 0;
+    return (packet->version == BL_PROTOCOL_V2) ? 4 : 1;
+}
+
+/**
+ * @brief Receive the header of a packet whose first byte arrives within
+ *        timeout_ms, the payload goes to packet->data.
+ */
+static RAMFUNC uint8_t receive_header(bl_packet_t *packet, uint32_t timeout_ms)
+{
+    uint8_t head[6];  // HEADER * 3 | CMD | LEN_H | LEN_L
 
-    if (com_channel_getc() != HEADER)
+    // the header byte selects the framing
+    if (com_channel_read(head, 1, timeout_ms) != 1 ||
+        (head[0] != HEADER && head[0] != HEADER_V2))
         return FAILED;
-    if (com_channel_getc() != HEADER)
+    for (uint8_t i = 1; i < 3; i++) {
+        if (com_channel_read(head + i, 1, BL_PACKET_TIMEOUT_MS) != 1 ||
+            head[i] != head[0])
+            return FAILED;
+    }
+    if (com_channel_read(head + 3, 3, BL_PACKET_TIMEOUT_MS) != 3)
         return FAILED;
-    if (com_channel_getc() != HEADER)
+
+    packet->version = (head[0] == HEADER_V2) ? BL_PROTOCOL_V2 : BL_PROTOCOL_V1;
+    packet->cmd = head[3];
+    packet->length = (head[4] << 8) | head[5];
+
+    // the previous reply may still be on its way out of the same buffer
+    com_channel_flush();
+
+    // too long for the buffer, drop it together with its checksum
+    if (packet->length > BL_DATA_MAX) {
+        uint32_t left = packet->length + trailer_size(packet);
+        while (left) {
+            uint32_t n = (left > PACKETSIZE) ? PACKETSIZE : left;
+            if (com_channel_read(packet->data, n, BL_PACKET_TIMEOUT_MS) != n)
+                break;
+            left -= n;
+        }
         return FAILED;
+    }
+    return SUCCESSED;
+}
 
-    cmd = com_channel_getc();
-    len_h = com_channel_getc();
-    len_l = com_channel_getc();
+/**
+ * @brief Check the payload and the checksum received at data[length].
+ */
+static RAMFUNC uint8_t check_payload(bl_packet_t *packet)
+{
+    uint8_t chksum = 0;
 
-    packet->cmd = cmd;
-    packet->length = (len_h << 8) | len_l;
+    if (packet->version == BL_PROTOCOL_V2) {
+        uint8_t head[6] = {HEADER_V2, HEADER_V2, HEADER_V2, packet->cmd,
+                           packet->length >> 8, packet->length & 0xFF};
+        uint32_t crc;
+        memcpy(&crc, packet->data + packet->length, 4);
+        if (crc32_update(crc32_update(0, head, 6), packet->data,
+                         packet->length) != crc)
+            return FAILED;
+        return SUCCESSED;
+    }
 
-    for (uint16_t i = 0; i < packet->length; i++) {
-        packet->data[i] = com_channel_getc();
+    for (uint16_t i = 0; i < packet->length; i++)
         chksum += packet->data[i];
-    }
-    if (com_channel_getc() != chksum)
+    if (packet->data[packet->length] != chksum)
         return FAILED;
 
     return SUCCESSED;
 }
 
-uint8_t put_packet(bl_packet_t *packet)
+/**
+ * @brief Receive a packet whose first byte arrives within timeout_ms.
+ */
+static RAMFUNC uint8_t receive_packet(bl_packet_t *packet, uint32_t timeout_ms)
 {
-    uint8_t chksum = 0;
+    uint32_t n;
+
+    if (receive_header(packet, timeout_ms))
+        return FAILED;
 
-    com_channel_putc(HEADER);
-    com_channel_putc(HEADER);
-    com_channel_putc(HEADER);
-    com_channel_putc(packet->cmd);
-    com_channel_putc(packet->length >> 8);
-    com_channel_putc(packet->length & 0xFF);
+    // a stalled programmer must not leave us waiting inside a packet
+    n = packet->length + trailer_size(packet);
+    if (com_channel_read(packet->data, n, BL_PACKET_TIMEOUT_MS) != n)
+        return FAILED;
 
-    for (uint16_t i = 0; i < packet->length; i++) {
-        com_channel_putc(packet->data[i]);
-        chksum += packet->data[i];
+    return check_payload(packet);
+}
+
+/**
+ * @brief Start receiving the next packet in the background, if its header is
+ *        on the wire already. Nothing is waited for.
+ */
+static RAMFUNC uint8_t receive_ahead(bl_packet_t *packet)
+{
+    if (com_channel_available() < 6 || receive_header(packet, 0))
+        return FAILED;
+
+    com_channel_read_async(packet->data, packet->length + trailer_size(packet));
+    return SUCCESSED;
+}
+
+/**
+ * @brief Complete a packet started by receive_ahead().
+ */
+static RAMFUNC uint8_t receive_ahead_wait(bl_packet_t *packet)
+{
+    if (com_channel_read_wait(BL_PACKET_TIMEOUT_MS) !=
+        packet->length + trailer_size(packet))
+        return FAILED;
+
+    return check_payload(packet);
+}
+
+RAMFUNC uint8_t get_packet(bl_packet_t *packet)
+{
+    return receive_packet(packet, COM_CHANNEL_WAIT_FOREVER);
+}
+
+RAMFUNC uint8_t put_packet(bl_packet_t *packet)
+{
+    uint8_t head[6] = {HEADER, HEADER, HEADER, packet->cmd,
+                       packet->length >> 8, packet->length & 0xFF};
+    uint16_t trailer;
+
+    if (packet->version == BL_PROTOCOL_V2)
+        head[0] = head[1] = head[2] = HEADER_V2;
+    com_channel_write(head, sizeof(head));
+
+    // the header drains from the TX FIFO meanwhile
+    if (packet->version == BL_PROTOCOL_V2) {
+        uint32_t crc = crc32_update(crc32_update(0, head, 6), packet->data,
+                                    packet->length);
+        memcpy(packet->data + packet->length, &crc, 4);
+        trailer = 4;
+    } else {
+        uint8_t chksum = 0;
+        for (uint16_t i = 0; i < packet->length; i++)
+            chksum += packet->data[i];
+        packet->data[packet->length] = chksum;
+        trailer = 1;
     }
-    com_channel_putc(chksum);
+
+    com_channel_write_async(packet->data, packet->length + trailer, NULL);
     return SUCCESSED;
 }
 
@@ -84,6 +208,336 @@ void send_NACK(bl_packet_t *packet)
     put_packet(packet);
 }
 
+/*******************************************************************************
+ * Baud Rate Negotiation
+ ******************************************************************************/
+
+static void reply_protocol(bl_packet_t *packet)
+{
+    packet->length = 2;
+    packet->data[0] = SUCCESSED;        // ACK
+    packet->data[1] = packet->version;  // protocol version of the request
+    put_packet(packet);
+}
+
+/**
+ * @brief Wait for the CMD_CHK_PROTOCOL ping at the new rate.
+ */
+static uint8_t baud_confirm(bl_packet_t *packet)
+{
+    uint32_t tick = system_get_tick();
+    uint32_t elapsed;
+
+    while ((elapsed = system_get_tick() - tick) < BL_BAUD_CONFIRM_MS) {
+        // noise from the switch fails the checksum, keep listening
+        if (receive_packet(packet, BL_BAUD_CONFIRM_MS - elapsed))
+            continue;
+        if (packet->cmd != CMD_CHK_PROTOCOL)
+            break;
+        reply_protocol(packet);
+        return SUCCESSED;
+    }
+    return FAILED;
+}
+
+static void set_baud(bl_packet_t *packet)
+{
+    uint32_t baud = *(uint32_t *) packet->data;
+    uint8_t query = (packet->length == 5) && (packet->data[4] & 1);
+    uint32_t prev = com_channel_get_baud();
+    uint32_t actual = 0;
+    int32_t err = 0;
+    uint8_t res = NACK;
+
+    if ((packet->length == 4 || packet->length == 5) &&
+        baud >= COM_CHANNEL_BAUD_DEFAULT && baud <= BL_BAUD_MAX) {
+        actual = COM_CHANNEL_UART_CLK / com_channel_baud_divisor(baud);
+        err = ((int64_t) actual - baud) * 1000000 / baud;
+        if (err >= -BL_BAUD_ERR_PPM && err <= BL_BAUD_ERR_PPM)
+            res = ACK;
+    }
+
+    packet->length = 10;
+    packet->data[0] = res;
+    packet->data[1] = (res == ACK) && (COM_CHANNEL_UART_CLK % baud == 0);
+    memcpy(packet->data + 2, &actual, 4);
+    memcpy(packet->data + 6, &err, 4);
+    put_packet(packet);
+
+    if (res != ACK || query)
+        return;
+
+    com_channel_set_baud(baud);
+    if (baud_confirm(packet))
+        com_channel_set_baud(prev);
+}
+
+/*******************************************************************************
+ * Windowed Flash Write
+ ******************************************************************************/
+
+static void window_reply(bl_packet_t *packet, uint8_t res, uint16_t seq)
+{
+    packet->length = 3;
+    packet->data[0] = res;
+    packet->data[1] = seq & 0xFF;
+    packet->data[2] = seq >> 8;
+    put_packet(packet);
+}
+
+/**
+ * @brief NACK the missing sequence numbers in [win_base, win_base + count).
+ * @param again also report the ones already NACKed.
+ */
+static void window_report_gaps(bl_packet_t *packet, uint16_t count, uint8_t again)
+{
+    uint8_t cmd = packet->cmd;
+
+    packet->cmd = CMD_FLASH_WINDOW_WRITE;
+    for (uint16_t i = 0; i < count && i < BL_WINDOW_MAX; i++) {
+        uint32_t bit = 1UL << i;
+        if ((win_received & bit) || (!again && (win_nacked & bit)))
+            continue;
+        win_nacked |= bit;
+        window_reply(packet, NACK, win_base + i);
+    }
+    packet->cmd = cmd;
+}
+
+static void window_open(bl_packet_t *packet)
+{
+    win_size = packet->data[0];
+    if (win_size == 0 || win_size > BL_WINDOW_MAX)
+        win_size = BL_WINDOW_MAX;
+    win_base = 0;
+    win_received = 0;
+    win_nacked = 0;
+
+    packet->length = 2;
+    packet->data[0] = ACK;
+    packet->data[1] = win_size;
+    put_packet(packet);
+}
+
+static void window_write(bl_packet_t *packet)
+{
+    uint16_t seq = packet->data[0] | (packet->data[1] << 8);
+    uint32_t addr = *(uint32_t *) (packet->data + 4);
+    uint16_t ofs = seq - win_base;
+
+    if (ofs >= 0x8000) {  // already programmed and slid out of the window
+        window_reply(packet, ACK, seq);
+        return;
+    }
+    if (ofs >= win_size) {
+        window_reply(packet, NACK, seq);
+        return;
+    }
+    if (win_received & (1UL << ofs)) {  // retransmitted, ACK got lost
+        window_reply(packet, ACK, seq);
+        return;
+    }
+    if ((packet->length != 8 + flash_get_pgsz()) || (addr <= BOOTLOADER_END) ||
+        flash_write_app_page(addr, packet->data + 8)) {
+        window_reply(packet, NACK, seq);
+        return;
+    }
+
+    win_received |= 1UL << ofs;
+    window_reply(packet, ACK, seq);
+
+    // everything sent before this packet has arrived by now
+    window_report_gaps(packet, ofs, 0);
+
+    while (win_received & 1) {
+        win_received >>= 1;
+        win_nacked >>= 1;
+        win_base++;
+    }
+}
+
+static void window_sync(bl_packet_t *packet)
+{
+    uint16_t end = packet->data[0] | (packet->data[1] << 8);
+    uint16_t count = end - win_base;
+
+    if (count < 0x8000)
+        window_report_gaps(packet, count, 1);
+
+    packet->length = 3;
+    packet->data[0] = (count == 0 || count >= 0x8000) ? ACK : NACK;
+    packet->data[1] = win_base & 0xFF;
+    packet->data[2] = win_base >> 8;
+    put_packet(packet);
+}
+
+/*******************************************************************************
+ * Page Sync
+ ******************************************************************************/
+
+static void sync_pages(bl_packet_t *packet)
+{
+    uint32_t addr = *(uint32_t *) packet->data;
+    uint16_t count = (packet->length - 4) / 4;
+    uint8_t erased[(BL_SYNC_PAGES_MAX + 7) / 8] = {0};
+
+    if (packet->length < 8 || (packet->length & 3) ||
+        count > BL_SYNC_PAGES_MAX || (addr & (FMC_FLASH_PAGE_SIZE - 1)) ||
+        addr < USER_APP_START ||
+        addr + count * FMC_FLASH_PAGE_SIZE > USER_APP_SIZE) {
+        send_NACK(packet);
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++, addr += FMC_FLASH_PAGE_SIZE) {
+        uint32_t want = *(uint32_t *) (packet->data + 4 + i * 4);
+        uint32_t crc;
+
+        // the FMC engine reads the page, nothing crosses the bus
+        if (flash_checksum_app(addr, FMC_FLASH_PAGE_SIZE, &crc)) {
+            send_NACK(packet);
+            return;
+        }
+        if (crc == want)
+            continue;
+        if (flash_erase_app_page(addr)) {
+            send_NACK(packet);
+            return;
+        }
+        erased[i / 8] |= 1 << (i % 8);
+    }
+
+    packet->length = 1 + (count + 7) / 8;
+    packet->data[0] = ACK;
+    memcpy(packet->data + 1, erased, packet->length - 1);
+    put_packet(packet);
+}
+
+/*******************************************************************************
+ * External Flash Image Slots
+ ******************************************************************************/
+
+/**
+ * @brief Check a range inside the slots, with no filesystem over them.
+ */
+static uint8_t slot_range(uint32_t addr, uint32_t len)
+{
+    return lfs_port_layout() != LFS_PORT_CHIP &&
+           addr >= EXT_FLASH_SLOT_START && len &&
+           len <= EXT_FLASH_SLOT_COUNT * EXT_FLASH_SLOT_SIZE &&
+           addr - EXT_FLASH_SLOT_START <=
+               EXT_FLASH_SLOT_COUNT * EXT_FLASH_SLOT_SIZE - len;
+}
+
+static void slot_erase(bl_packet_t *packet)
+{
+    uint32_t addr = *(uint32_t *) packet->data;
+    uint32_t len = *(uint32_t *) (packet->data + 4);
+
+    if (packet->length != 8 || ((addr | len) & (W25Q128JV_SECTOR - 1)) ||
+        !slot_range(addr, len)) {
+        send_NACK(packet);
+        return;
+    }
+
+    // 64 KiB block erases where they fit, 4 KiB sector erases for the rest
+    while (len) {
+        if (!(addr & (W25Q128JV_BLOCK - 1)) && len >= W25Q128JV_BLOCK) {
+            w25q128jv_erase_block_async(addr / W25Q128JV_BLOCK);
+            addr += W25Q128JV_BLOCK;
+            len -= W25Q128JV_BLOCK;
+        } else {
+            w25q128jv_erase_sector_async(addr / W25Q128JV_SECTOR);
+            addr += W25Q128JV_SECTOR;
+            len -= W25Q128JV_SECTOR;
+        }
+    }
+    send_ACK(packet);
+}
+
+static void slot_write(bl_packet_t *packet)
+{
+    uint32_t addr = *(uint32_t *) packet->data;
+
+    if (packet->length <= 4 || !slot_range(addr, packet->length - 4)) {
+        send_NACK(packet);
+        return;
+    }
+    w25q128jv_write_bytes_async(packet->data + 4, addr, packet->length - 4);
+    send_ACK(packet);
+}
+
+/**
+ * @brief Check the vector table at the start of a slot.
+ * @param slot slot number.
+ * @param vectors the vector table in the SPIM window.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, no image linked for the slot or XIP not possible.
+ */
+static uint8_t slot_xip_vectors(uint8_t slot, uint32_t *vectors)
+{
+    uint32_t addr = slot_base(slot);
+    uint32_t xip = EXT_FLASH_XIP_BASE + addr;
+    uint32_t head[2];  // initial SP, Reset_Handler
+
+    if (slot >= EXT_FLASH_SLOT_COUNT || lfs_port_layout() == LFS_PORT_CHIP)
+        return FAILED;
+    if (!w25q128jv_on_qspi())
+        return FAILED;  // SPIM reaches QSPI0 pins only
+    w25q128jv_read_bytes((uint8_t *) head, addr, sizeof(head));
+    if (head[0] < SRAM_START || head[0] > SRAM_START + SRAM_SIZE ||
+        (head[0] & 7) || !(head[1] & 1) || head[1] < xip ||
+        head[1] >= xip + EXT_FLASH_SLOT_SIZE)
+        return FAILED;
+    *vectors = xip;
+    return SUCCESSED;
+}
+
+/**
+ * @brief File of the filesystem below the slots holding the slot to run in
+ *        place after reset, SLOT(1).
+ */
+#define XIP_SELECT_PATH "/xip"
+
+/**
+ * @brief Store or clear the slot boot_from_xip() runs.
+ * @param slot slot number, BL_XIP_NONE to boot from APROM.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, the slot cannot run in place or the filesystem is not
+ *         writable.
+ */
+static uint8_t slot_xip_select(uint8_t slot)
+{
+    uint32_t vectors;
+    uint8_t ret = FAILED;
+
+    if (slot == BL_XIP_NONE) {
+        if (lfs_port_mount())
+            return SUCCESSED;  // no filesystem, nothing selected
+        int err = lfs_remove(&lfs_w25q128jv, XIP_SELECT_PATH);
+        lfs_unmount(&lfs_w25q128jv);
+        return (err && err != LFS_ERR_NOENT) ? FAILED : SUCCESSED;
+    }
+
+    // a filesystem over the whole chip fails here, before it is written
+    if (slot_xip_vectors(slot, &vectors) ||
+        lfs_port_mount_write(XIP_SELECT_PATH))
+        return FAILED;
+    if (!lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv,
+                          XIP_SELECT_PATH,
+                          LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC,
+                          &lfs_file_cfg_w25q128jv)) {
+        if (lfs_file_write(&lfs_w25q128jv, &lfs_file_w25q128jv, &slot, 1) == 1)
+            ret = SUCCESSED;
+        if (lfs_file_close(&lfs_w25q128jv, &lfs_file_w25q128jv))
+            ret = FAILED;
+    }
+    lfs_unmount(&lfs_w25q128jv);
+    return ret;
+}
+
 /*******************************************************************************
  * Boot Protocol
  ******************************************************************************/
@@ -96,10 +550,7 @@ void establish_connection(void)
             continue;
 
         if (pac.cmd == CMD_CHK_PROTOCOL) {
-            pac.length = 2;
-            pac.data[0] = SUCCESSED;
-            pac.data[1] = 1;
-            put_packet(&pac);
+            reply_protocol(&pac);
             return;
         } else {
             send_NACK(&pac);
@@ -110,17 +561,31 @@ void establish_connection(void)
 void bl_command_process(void)
 {
     bl_packet_t pac = {.cmd = 0, .length = 0, .data = bl_buffer};
+    bl_packet_t next = {.cmd = 0, .length = 0, .data = bl_buffer_ahead};
+    uint8_t ahead = 0;
 
     while (1) {
-        if (get_packet(&pac))
+        if (ahead) {
+            // swap the buffers, the reply of the last packet may still be
+            // leaving the one that is free now
+            bl_packet_t done = pac;
+            pac = next;
+            next = done;
+            ahead = 0;
+            if (receive_ahead_wait(&pac))
+                continue;
+        } else if (get_packet(&pac)) {
             continue;
+        }
+
+        // a windowed writer keeps sending, the ISR takes the next packet into
+        // the other buffer while this page is programmed
+        if (pac.cmd == CMD_FLASH_WINDOW_WRITE)
+            ahead = !receive_ahead(&next);
 
         switch (pac.cmd) {
         case CMD_CHK_PROTOCOL: {
-            pac.length = 2;
-            pac.data[0] = SUCCESSED;  // ACK
-            pac.data[1] = 1;          // protocol vresion
-            put_packet(&pac);
+            reply_protocol(&pac);
             break;
         }
         case CMD_CHK_DEVICE: {
@@ -131,17 +596,49 @@ void bl_command_process(void)
             break;
         }
         case CMD_PROG_END: {
+            if (flash_erase_flush()) {
+                send_NACK(&pac);
+                break;
+            }
             send_ACK(&pac);
             return;
         }
         case CMD_PROG_EXT_FLASH_BOOT: {
-            boot_from_fs();
+            if (boot_from_fs())
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
+            break;
+        }
+        case CMD_SET_BAUD: {
+            set_baud(&pac);
+            break;
+        }
+        case CMD_PROG_EXT_FLASH_XIP: {
+            uint32_t vectors;
+            if (pac.length != 1 || slot_xip_vectors(pac.data[0], &vectors)) {
+                send_NACK(&pac);
+                break;
+            }
+            w25q128jv_flush();  // SPIM reads the flash from now on
             send_ACK(&pac);
+            system_jump_to_xip(vectors);
+            return;
+        }
+        case CMD_PROG_EXT_FLASH_SLOT: {
+            // both packet buffers take the chunks, one FMC page each, the
+            // next is read while the current one is programmed
+            com_channel_flush();  // a reply may still leave the other one
+            if (pac.length != 1 ||
+                slot_install(pac.data[0], pac.data, next.data,
+                             FMC_FLASH_PAGE_SIZE))
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
             break;
         }
         case CMD_FLASH_SET_PGSZ: {
-            // TODO: only support 512 byte page size.
-            if (flash_set_pgsz(*((uint16_t *) pac.data)))
+            if (pac.length != 2 || flash_set_pgsz(*((uint16_t *) pac.data)))
                 send_NACK(&pac);
             else
                 send_ACK(&pac);
@@ -155,7 +652,8 @@ void bl_command_process(void)
             break;
         }
         case CMD_FLASH_WRITE: {
-            if ((*(uint32_t *) pac.data <= BOOTLOADER_END) ||
+            if ((pac.length != 4 + flash_get_pgsz()) ||
+                (*(uint32_t *) pac.data <= BOOTLOADER_END) ||
                 flash_write_app_page(*(uint32_t *) pac.data,
                                      (uint8_t *) (pac.data + 4)))
                 send_NACK(&pac);
@@ -174,40 +672,115 @@ void bl_command_process(void)
             }
             break;
         }
-        case CMD_FLASH_VERIFY: {  // TODO:
-            send_NACK(&pac);
+        case CMD_FLASH_VERIFY: {
+            uint32_t crc;
+            if (pac.length != 8 ||
+                flash_checksum_app(*(uint32_t *) pac.data,
+                                   *(uint32_t *) (pac.data + 4), &crc)) {
+                send_NACK(&pac);
+            } else {
+                pac.length = 5;
+                pac.data[0] = SUCCESSED;  // ACK
+                memcpy(pac.data + 1, &crc, 4);
+                put_packet(&pac);
+            }
             break;
         }
-        case CMD_FLASH_ERASE_SECTOR: {  // TODO:
-            send_NACK(&pac);
+        case CMD_FLASH_ERASE_SECTOR: {
+            if (pac.length != 8 ||
+                flash_erase_app_defer(*(uint32_t *) pac.data,
+                                      *(uint32_t *) (pac.data + 4)))
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
             break;
         }
         case CMD_FLASH_ERASE_ALL: {
-            if (flash_erase_app_all())
+            if (flash_erase_app_defer(USER_APP_START,
+                                      USER_APP_SIZE - USER_APP_START))
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
+            break;
+        }
+        case CMD_FLASH_WINDOW_OPEN: {
+            window_open(&pac);
+            break;
+        }
+        case CMD_FLASH_WINDOW_WRITE: {
+            window_write(&pac);
+            break;
+        }
+        case CMD_FLASH_WINDOW_SYNC: {
+            window_sync(&pac);
+            break;
+        }
+        case CMD_FLASH_DELTA_BEGIN: {
+            if (pac.length != 8 || delta_begin(*(uint32_t *) pac.data,
+                                               *(uint32_t *) (pac.data + 4)))
                 send_NACK(&pac);
             else
                 send_ACK(&pac);
             break;
         }
+        case CMD_FLASH_DELTA_DATA: {
+            if (pac.length <= 4 || delta_apply(*(uint32_t *) pac.data,
+                                               pac.data + 4, pac.length - 4))
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
+            break;
+        }
+        case CMD_FLASH_UNPACK_BEGIN: {
+            if (pac.length != 8 || unpack_begin(*(uint32_t *) pac.data,
+                                                *(uint32_t *) (pac.data + 4)))
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
+            break;
+        }
+        case CMD_FLASH_UNPACK_DATA: {
+            uint32_t written;
+            uint8_t res = (pac.length <= 4) ||
+                          unpack_data(*(uint32_t *) pac.data, pac.data + 4,
+                                      pac.length - 4);
+            written = unpack_written();
+            pac.length = 5;
+            pac.data[0] = res ? NACK : ACK;
+            memcpy(pac.data + 1, &written, 4);
+            put_packet(&pac);
+            break;
+        }
+        case CMD_FLASH_SYNC_PAGE: {
+            sync_pages(&pac);
+            break;
+        }
+        case CMD_FLASH_DELTA_END: {
+            uint16_t rewritten;
+            if (delta_install(&rewritten)) {
+                send_NACK(&pac);
+            } else {
+                pac.length = 3;
+                pac.data[0] = SUCCESSED;  // ACK
+                memcpy(pac.data + 1, &rewritten, 2);
+                put_packet(&pac);
+            }
+            break;
+        }
 
             /******************************************************************/
 
         case CMD_EXT_FLASH_FOPEN: {
-            // mount the filesystem
-            int err = lfs_mount(&lfs_w25q128jv, &cfg);
-
-            // reformat if we can't mount the filesystem, this should only
-            // happen on the first boot
-            if (err) {
-                lfs_format(&lfs_w25q128jv, &cfg);
-                lfs_mount(&lfs_w25q128jv, &cfg);
-            }
+            // mount the filesystem, formatted on the first boot and moved
+            // below the slots when /boot is all it holds
+            lfs_port_mount_write("/boot");
 
             lfs_remove(&lfs_w25q128jv, "/boot");
 
             // Open boot partition
-            lfs_file_open(&lfs_w25q128jv, &lfs_file_w25q128jv, "/boot",
-                          LFS_O_WRONLY | LFS_O_APPEND | LFS_O_CREAT);
+            lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv, "/boot",
+                             LFS_O_WRONLY | LFS_O_APPEND | LFS_O_CREAT,
+                             &lfs_file_cfg_w25q128jv);
 
             send_ACK(&pac);
             break;
@@ -236,11 +809,23 @@ void bl_command_process(void)
             break;
         }
         case CMD_EXT_FLASH_ERASE_SECTOR: {
+            slot_erase(&pac);
             break;
         }
         case CMD_EXT_FLASH_HEX_DEL: {
             break;
         }
+        case CMD_EXT_FLASH_SLOT_WRITE: {
+            slot_write(&pac);
+            break;
+        }
+        case CMD_EXT_FLASH_XIP_SELECT: {
+            if (pac.length != 1 || slot_xip_select(pac.data[0]))
+                send_NACK(&pac);
+            else
+                send_ACK(&pac);
+            break;
+        }
 
             /******************************************************************/
 
@@ -267,54 +852,84 @@ void bl_command_process(void)
             break;
         }
         }
+
+        // the reply is out, erase the next page while the programmer sends
+        // the next packet. A failed page stays pending and fails its write.
+        flash_erase_ahead();
+        w25q128jv_poll();  // start the next queued external flash operation
     }
 }
 
 uint8_t boot_from_fs(void)
 {
-    bootLED_on();
-    APROM_update_enable();
+    uint8_t ret = FAILED;
 
-    if (flash_erase_app_all())
-        return FAILED;
+    bootLED_on();
     memset(bl_buffer, 0, BUFFERSIZE);
 
-    int err = lfs_mount(&lfs_w25q128jv, &cfg);
-
-    // reformat if we can't mount the filesystem, this should only happen on the
-    // first boot
-    if (err) {
-        lfs_format(&lfs_w25q128jv, &cfg);
-        lfs_mount(&lfs_w25q128jv, &cfg);
-    }
-
-    lfs_file_open(&lfs_w25q128jv, &lfs_file_w25q128jv, "/boot",
-                  LFS_O_RDONLY | LFS_O_CREAT);
+    // nothing is erased or formatted unless there is an image to boot
+    if (lfs_port_mount())
+        goto led_off;
+    if (lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv, "/boot",
+                         LFS_O_RDONLY, &lfs_file_cfg_w25q128jv))
+        goto unmount;
 
     lfs_soff_t fsize = lfs_file_size(&lfs_w25q128jv, &lfs_file_w25q128jv);
     // printf("/boot size is %ld\n", fsize);
 
+    APROM_update_enable();
+    if (fsize <= 0 || flash_erase_app_all())
+        goto close;
+
     while (fsize >= BUFFERSIZE) {
         lfs_file_read(&lfs_w25q128jv, &lfs_file_w25q128jv, bl_buffer,
                       BUFFERSIZE);
-        if (flash_write_app_page(*(uint32_t *) bl_buffer,
-                                 (uint8_t *) (bl_buffer + 4)))
-            return FAILED;
+        if (flash_write_app(*(uint32_t *) bl_buffer, bl_buffer + 4,
+                            BUFFERSIZE - 4))
+            goto close;
         fsize -= BUFFERSIZE;
     }
     if (fsize) {
         memset(bl_buffer, 0, BUFFERSIZE);
         lfs_file_read(&lfs_w25q128jv, &lfs_file_w25q128jv, bl_buffer, fsize);
-        if (flash_write_app_page(*(uint32_t *) bl_buffer,
-                                 (uint8_t *) (bl_buffer + 4)))
-            return FAILED;
+        if (flash_write_app(*(uint32_t *) bl_buffer, bl_buffer + 4,
+                            BUFFERSIZE - 4))
+            goto close;
     }
+    ret = SUCCESSED;
 
+close:
     lfs_file_close(&lfs_w25q128jv, &lfs_file_w25q128jv);
-    lfs_unmount(&lfs_w25q128jv);
-
     APROM_update_enable();
+unmount:
+    lfs_unmount(&lfs_w25q128jv);
+led_off:
     bootLED_off();
 
+    return ret;
+}
+
+uint8_t boot_from_xip(void)
+{
+    uint32_t vectors;
+    uint8_t slot = BL_XIP_NONE;
+
+    // SPIM reaches QSPI0 pins only, no filesystem to mount for nothing
+    if (!w25q128jv_on_qspi() || lfs_port_mount())
+        return FAILED;
+    if (!lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv,
+                          XIP_SELECT_PATH, LFS_O_RDONLY,
+                          &lfs_file_cfg_w25q128jv)) {
+        if (lfs_file_read(&lfs_w25q128jv, &lfs_file_w25q128jv, &slot, 1) != 1)
+            slot = BL_XIP_NONE;
+        lfs_file_close(&lfs_w25q128jv, &lfs_file_w25q128jv);
+    }
+    lfs_unmount(&lfs_w25q128jv);
+
+    // an erased or rewritten slot falls back to APROM
+    if (slot_xip_vectors(slot, &vectors))
+        return FAILED;
+    w25q128jv_flush();  // SPIM reads the flash from now on
+    system_jump_to_xip(vectors);
     return SUCCESSED;
 }
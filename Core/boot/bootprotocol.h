@@ -20,17 +20,26 @@
  *
  * HEADER   : 0xA5A5A5
  * COMMAND  : See details in the following macros
- * LENGTH   : Data length
+ * LENGTH   : Data length, at most BL_DATA_MAX
  * DATA     : Variable length
  * CHECKSUM : sum(data) % 255
  *
+ * Protocol v2 framing uses HEADER 0x5A5A5A and replaces the CHECKSUM with
+ * CRC(4), the CRC-32 (zlib crc32()) of HEADER, COMMAND, LENGTH and DATA, little
+ * endian. The bootloader accepts both framings and replies in the framing of
+ * the request, CMD_CHK_PROTOCOL replies with the version it was sent in.
+ *
  */
 
 #ifndef BOOTPROTOCOL_H
 #define BOOTPROTOCOL_H
 
 /* bootprotocol common macros */
-#define HEADER 0xA5
+#define HEADER    0xA5
+#define HEADER_V2 0x5A
+
+#define BL_PROTOCOL_V1 1
+#define BL_PROTOCOL_V2 2
 
 #define SUCCESSED 0
 #define FAILED    1
@@ -43,6 +52,9 @@
 #define CMD_CHK_DEVICE          0x02
 #define CMD_PROG_END            0x03
 #define CMD_PROG_EXT_FLASH_BOOT 0x04
+#define CMD_SET_BAUD            0x05
+#define CMD_PROG_EXT_FLASH_XIP  0x06
+#define CMD_PROG_EXT_FLASH_SLOT 0x07
 
 #define CMD_FLASH_SET_PGSZ     0x10
 #define CMD_FLASH_GET_PGSZ     0x11
@@ -51,6 +63,15 @@
 #define CMD_FLASH_VERIFY       0x14
 #define CMD_FLASH_ERASE_SECTOR 0x15
 #define CMD_FLASH_ERASE_ALL    0x16
+#define CMD_FLASH_WINDOW_OPEN  0x17
+#define CMD_FLASH_WINDOW_WRITE 0x18
+#define CMD_FLASH_WINDOW_SYNC  0x19
+#define CMD_FLASH_DELTA_BEGIN  0x1A
+#define CMD_FLASH_DELTA_DATA   0x1B
+#define CMD_FLASH_DELTA_END    0x1C
+#define CMD_FLASH_SYNC_PAGE    0x1D
+#define CMD_FLASH_UNPACK_BEGIN 0x1E
+#define CMD_FLASH_UNPACK_DATA  0x1F
 
 #define CMD_EEPROM_SET_PGSZ     0x20
 #define CMD_EEPROM_GET_PGSZ     0x21
@@ -67,16 +88,186 @@
 #define CMD_EXT_FLASH_VERIFY       0x34
 #define CMD_EXT_FLASH_ERASE_SECTOR 0x35
 #define CMD_EXT_FLASH_HEX_DEL      0x36
+#define CMD_EXT_FLASH_SLOT_WRITE   0x37
+#define CMD_EXT_FLASH_XIP_SELECT   0x38
+
+/**
+ * Longest DATA accepted, a windowed write of a 4 KiB page. Longer packets are
+ * dropped like corrupted ones.
+ */
+#define BL_DATA_MAX (8 + 4096)
+
+/**
+ * Flash page size
+ *
+ *  CMD_FLASH_SET_PGSZ : DATA = SIZE(2), 256 * N up to the 4 KiB FMC page.
+ *                       reply  ACK/NACK.
+ *  CMD_FLASH_GET_PGSZ : reply  ACK, SIZE(2).
+ *
+ * The page size is the PAGE length of CMD_FLASH_WRITE, CMD_FLASH_READ and
+ * CMD_FLASH_WINDOW_WRITE, 512 after reset. Larger pages pay the packet header
+ * and the ACK round trip less often.
+ */
+
+/**
+ * Flash erase
+ *
+ *  CMD_FLASH_ERASE_SECTOR : DATA = ADDR(4) | LEN(4), both multiples of the
+ *                           4 KiB FMC page, inside the user app section.
+ *                           reply  ACK/NACK.
+ *  CMD_FLASH_ERASE_ALL    : the whole user app section.
+ *                           reply  ACK/NACK.
+ *
+ * Pages in APROM bank 0, which the bootloader runs from, are erased before
+ * the reply. Those in bank 1 are only scheduled: each one is erased before it
+ * is first programmed or read, the page after the last one programmed while
+ * the next packet is on its way, and whatever is left by CMD_PROG_END.
+ * Erasing just the pages of the image saves erasing the rest of the section.
+ */
+
+/**
+ * Windowed flash write
+ *
+ * The programmer may keep up to N CMD_FLASH_WINDOW_WRITE packets in flight
+ * instead of waiting for the ACK of every page.
+ *
+ *  CMD_FLASH_WINDOW_OPEN  : DATA = N
+ *                           reply  ACK, granted N (<= BL_WINDOW_MAX).
+ *                           Resets the sequence number to 0.
+ *  CMD_FLASH_WINDOW_WRITE : DATA = SEQ(2) | RESERVED(2) | ADDR(4) | PAGE
+ *                           reply  ACK/NACK, SEQ(2) for every packet.
+ *                           Each packet carries its own address, so the pages
+ *                           are programmed in arrival order. A sequence gap
+ *                           (dropped or corrupted packet) is reported at once
+ *                           with a NACK for every missing SEQ.
+ *  CMD_FLASH_WINDOW_SYNC  : DATA = END_SEQ(2), the next SEQ the programmer
+ *                           would send. NACKs every missing SEQ below END_SEQ,
+ *                           then replies ACK/NACK, BASE_SEQ(2), where ACK
+ *                           means every packet below END_SEQ was programmed.
+ *
+ * Multi-byte fields are little endian.
+ */
+#define BL_WINDOW_MAX 32
+
+/**
+ * Delta update, see delta.h for the op stream
+ *
+ *  CMD_FLASH_DELTA_BEGIN : DATA = SIZE(4) | CRC(4) of the new image
+ *                          reply  ACK/NACK.
+ *  CMD_FLASH_DELTA_DATA  : DATA = OFS(4) | OPS, OFS is the new image offset
+ *                          the whole ops in OPS start at.
+ *                          reply  ACK/NACK.
+ *  CMD_FLASH_DELTA_END   : reply  ACK/NACK, REWRITTEN(2) number of FMC pages
+ *                          erased and programmed.
+ */
+
+/**
+ * Compressed flash write, see unpack.h for the stream format
+ *
+ *  CMD_FLASH_UNPACK_BEGIN : DATA = ADDR(4) | SIZE(4), 512 byte aligned APROM
+ *                           address (erased before) and decompressed size.
+ *                           reply  ACK/NACK.
+ *  CMD_FLASH_UNPACK_DATA  : DATA = OFS(4) | STREAM, OFS is the stream offset
+ *                           of STREAM, which may end anywhere.
+ *                           reply  ACK/NACK, WRITTEN(4) bytes decompressed so
+ *                           far. The image is programmed once WRITTEN equals
+ *                           SIZE. A NACK other than for a gap aborts the
+ *                           write.
+ */
+
+/**
+ * Flash verify
+ *
+ *  CMD_FLASH_VERIFY : DATA = ADDR(4) | LEN(4), both multiples of 512, inside
+ *                     the user app section.
+ *                     reply  ACK/NACK, CRC(4) of the range, calculated by the
+ *                     FMC checksum engine without reading it back over the
+ *                     line. The programmer compares it with zlib crc32().
+ */
+
+/**
+ * Page sync
+ *
+ * The programmer sends a manifest, the CRC-32 (zlib crc32()) of every 4 KiB
+ * FMC page of the new image, and the bootloader compares each one with the
+ * FMC checksum engine. Pages that match are left alone, the others are erased
+ * and then programmed with CMD_FLASH_WRITE as usual.
+ *
+ *  CMD_FLASH_SYNC_PAGE : DATA = ADDR(4) | CRC(4) * N, ADDR is the FMC page
+ *                        aligned address of the first page, 1 <= N <=
+ *                        BL_SYNC_PAGES_MAX.
+ *                        reply  ACK/NACK, ERASED((N + 7) / 8), bit i set when
+ *                        page i differed and was erased.
+ *
+ * The last page is padded with 0xFF, the CRC of an all 0xFF page matches an
+ * erased one. A mismatch only costs a rewrite, a page is never skipped without
+ * its CRC matching.
+ */
+#define BL_SYNC_PAGES_MAX 128
+
+/**
+ * External flash image slots, see device.h
+ *
+ *  CMD_EXT_FLASH_ERASE_SECTOR : DATA = ADDR(4) | LEN(4), multiples of the
+ *                               4 KiB W25Q128JV sector, inside the slots.
+ *                               reply  ACK/NACK.
+ *  CMD_EXT_FLASH_SLOT_WRITE   : DATA = ADDR(4) | BYTES, inside the slots,
+ *                               erased before.
+ *                               reply  ACK/NACK.
+ *  CMD_PROG_EXT_FLASH_XIP     : DATA = SLOT(1)
+ *                               reply  ACK/NACK. After the ACK the bootloader
+ *                               maps the W25Q128JV into the SPIM window and
+ *                               runs the image of the slot in place, nothing
+ *                               is copied to APROM. NACK when the slot does
+ *                               not start with the vector table of an image
+ *                               linked to EXT_FLASH_XIP_BASE + its address.
+ *  CMD_EXT_FLASH_XIP_SELECT   : DATA = SLOT(1), BL_XIP_NONE for APROM
+ *                               reply  ACK/NACK. Stores the slot run in place
+ *                               after reset in RUN mode, see boot_from_xip().
+ *                               NACK as CMD_PROG_EXT_FLASH_XIP would, or when
+ *                               the filesystem cannot be written.
+ *  CMD_PROG_EXT_FLASH_SLOT    : DATA = SLOT(1)
+ *                               reply  ACK/NACK. Installs the image of the
+ *                               slot at the load address of its header, see
+ *                               slot.h. NACK without a valid header, or when
+ *                               the CRC-32 or SHA-256 of the copy does not
+ *                               match, the pages are erased again then.
+ *
+ * Erases and programs are queued on the W25Q128JV and run while the next
+ * packets arrive, a later command on the same range waits for them.
+ */
+#define BL_XIP_NONE 0xFF
+
+/**
+ * Baud rate negotiation
+ *
+ *  CMD_SET_BAUD : DATA = BAUD(4) [| QUERY(1)]
+ *                 reply  ACK/NACK, EXACT(1), ACTUAL(4), ERROR_PPM(4, signed)
+ *                 at the old rate. ACTUAL is the rate the 12 MHz UART clock
+ *                 really gives, EXACT is 1 when it equals BAUD. NACK when BAUD
+ *                 is out of range or off by more than BL_BAUD_ERR_PPM.
+ *
+ * After an ACK (and without QUERY = 1) both ends switch to BAUD, then the
+ * programmer sends CMD_CHK_PROTOCOL at the new rate. The bootloader keeps the
+ * new rate only if that ping arrives within BL_BAUD_CONFIRM_MS, otherwise it
+ * falls back to the old rate, and so should the programmer when the ping is
+ * not answered.
+ */
+#define BL_BAUD_MAX        3000000
+#define BL_BAUD_ERR_PPM    20000
+#define BL_BAUD_CONFIRM_MS 1000
 
 #include <stdint.h>
 
 /**
  * @brief packet format struct
- * @param cmd    Packet command.
- * @param data   Data buffer pointer.
- * @param length Data length.
+ * @param version Framing, BL_PROTOCOL_V1 or BL_PROTOCOL_V2.
+ * @param cmd     Packet command.
+ * @param data    Data buffer pointer.
+ * @param length  Data length.
  */
 typedef struct __bootloader_packet {
+    uint8_t version;
     uint8_t cmd;
     uint16_t length;
     uint8_t *data;
@@ -93,6 +284,11 @@ uint8_t get_packet(bl_packet_t *packet);
 
 /**
  * @brief Send a packet to the communication channel.
+ *
+ * The payload and the checksum, which is stored at data[length], leave by
+ * PDMA after this returns. The data buffer must hold length + 4 bytes and is
+ * not reused before the next get_packet(), which waits for the transfer.
+ *
  * @param packet
  * @return uint8_t
  *      0: successed.
@@ -129,7 +325,28 @@ void bl_command_process(void);
 /**
  * @brief Boot the program. Load the application image from /boot partition
  *
+ *  APROM is only erased once /boot is open, a filesystem that does not mount
+ *  is left as it is.
+ *
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, no filesystem or no /boot, or a flash error.
  */
 uint8_t boot_from_fs(void);
 
+/**
+ * @brief Run the slot stored by CMD_EXT_FLASH_XIP_SELECT in place.
+ *
+ *  Called in RUN mode before system_jump_to_app(). The selection is the file
+ *  /xip in the filesystem below the slots, its slot is checked again as
+ *  CMD_PROG_EXT_FLASH_XIP does. Without the flash on QSPI0 the filesystem is
+ *  not mounted at all.
+ *
+ * @return uint8_t
+ *      0: successed, does not return on the board.
+ *      1: failed, nothing selected or the slot holds no image to run, boot
+ *         from APROM.
+ */
+uint8_t boot_from_xip(void);
+
 #endif /* BOOTPROTOCOL_H */
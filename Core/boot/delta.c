@@ -0,0 +1,251 @@
+/**
+ * @file delta.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Delta update against the user app already in APROM.
+ */
+
+#include "delta.h"
+#include <string.h>
+#include "NuMicro.h"
+#include "crc32.h"
+#include "device.h"
+#include "flash.h"
+
+#include "lfs.h"
+#include "lfs_port.h"
+
+/*******************************************************************************
+ * Macro
+ ******************************************************************************/
+#define FAILED    1
+#define SUCCESSED 0
+
+#define DELTA_STAGE_PATH "/delta"
+#define DELTA_APP_SIZE   (USER_APP_SIZE - USER_APP_START)
+
+enum { DELTA_IDLE, DELTA_STAGING, DELTA_STAGED };
+
+static uint8_t delta_buf[FMC_FLASH_PAGE_SIZE] __attribute__((__aligned__(4)));
+
+static uint8_t delta_state;
+static uint32_t delta_size;     // new image size
+static uint32_t delta_crc;      // expected CRC-32 of the new image
+static uint32_t delta_written;  // bytes staged so far
+static uint32_t delta_sum;      // CRC-32 of the bytes staged so far
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void delta_close(void)
+{
+    if (delta_state == DELTA_STAGING)
+        lfs_file_close(&lfs_w25q128jv, &lfs_file_w25q128jv);
+    if (delta_state != DELTA_IDLE)
+        lfs_unmount(&lfs_w25q128jv);
+    delta_state = DELTA_IDLE;
+}
+
+static uint8_t stage_write(const uint8_t *buf, uint32_t len)
+{
+    if (len > delta_size - delta_written)
+        return FAILED;
+    if (lfs_file_write(&lfs_w25q128jv, &lfs_file_w25q128jv, buf, len) !=
+        (lfs_ssize_t) len)
+        return FAILED;
+    delta_sum = crc32_update(delta_sum, buf, len);
+    delta_written += len;
+    return SUCCESSED;
+}
+
+/**
+ * @brief Read len bytes of the staged image at pos, 0xFF past its end.
+ */
+static uint8_t stage_read(uint32_t pos, uint8_t *buf, uint32_t len)
+{
+    uint32_t avail = (pos < delta_size) ? delta_size - pos : 0;
+
+    if (avail > len)
+        avail = len;
+    memset(buf + avail, 0xFF, len - avail);
+    if (!avail)
+        return SUCCESSED;
+
+    if (lfs_file_seek(&lfs_w25q128jv, &lfs_file_w25q128jv, pos,
+                      LFS_SEEK_SET) < 0 ||
+        lfs_file_read(&lfs_w25q128jv, &lfs_file_w25q128jv, buf, avail) !=
+            (lfs_ssize_t) avail)
+        return FAILED;
+    return SUCCESSED;
+}
+
+/**
+ * @brief Read the staged image back and check its CRC-32.
+ */
+static uint8_t stage_check(void)
+{
+    uint32_t crc = 0;
+
+    for (uint32_t pos = 0; pos < delta_size; pos += sizeof(delta_buf)) {
+        uint32_t len = delta_size - pos;
+        if (len > sizeof(delta_buf))
+            len = sizeof(delta_buf);
+        if (stage_read(pos, delta_buf, len))
+            return FAILED;
+        crc = crc32_update(crc, delta_buf, len);
+    }
+    return (crc == delta_crc) ? SUCCESSED : FAILED;
+}
+
+/**
+ * @brief Install one FMC page from the stage, if it differs from APROM.
+ * @return int8_t 1: rewritten, 0: unchanged, -1: failed.
+ */
+static int8_t install_page(uint32_t page)
+{
+    uint32_t addr = USER_APP_START + page;
+
+    if (stage_read(page, delta_buf, FMC_FLASH_PAGE_SIZE))
+        return -1;
+    if (!flash_verify_app(addr, delta_buf, FMC_FLASH_PAGE_SIZE))
+        return 0;
+
+    // rows of one multi-word program each, erased rows are skipped
+    if (flash_erase_app_page(addr))
+        return -1;
+    for (uint32_t ofs = 0; ofs < FMC_FLASH_PAGE_SIZE;
+         ofs += FMC_MULTI_WORD_PROG_LEN) {
+        uint32_t i = 0;
+        while (i < FMC_MULTI_WORD_PROG_LEN && delta_buf[ofs + i] == 0xFF)
+            i++;
+        if (i < FMC_MULTI_WORD_PROG_LEN &&
+            flash_write_app(addr + ofs, delta_buf + ofs,
+                            FMC_MULTI_WORD_PROG_LEN))
+            return -1;
+    }
+    return 1;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint8_t delta_begin(uint32_t size, uint32_t crc)
+{
+    delta_close();
+    if (size == 0 || size > DELTA_APP_SIZE)
+        return FAILED;
+
+    // formatted on the first boot
+    if (lfs_port_mount_write(DELTA_STAGE_PATH))
+        return FAILED;
+    if (lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv,
+                         DELTA_STAGE_PATH,
+                         LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC,
+                         &lfs_file_cfg_w25q128jv)) {
+        lfs_unmount(&lfs_w25q128jv);
+        return FAILED;
+    }
+
+    delta_state = DELTA_STAGING;
+    delta_size = size;
+    delta_crc = crc;
+    delta_written = 0;
+    delta_sum = 0;
+    return SUCCESSED;
+}
+
+uint8_t delta_apply(uint32_t ofs, const uint8_t *ops, uint32_t len)
+{
+    if (delta_state != DELTA_STAGING)
+        return FAILED;
+    // a retransmission whose ACK got lost, applied already
+    if (ofs < delta_written)
+        return SUCCESSED;
+    if (ofs != delta_written)
+        return FAILED;
+
+    while (len) {
+        uint32_t src, n;
+
+        if (ops[0] == DELTA_OP_COPY && len >= DELTA_COPY_SIZE) {
+            src = get_le32(ops + 1);
+            n = get_le32(ops + 5);
+            ops += DELTA_COPY_SIZE;
+            len -= DELTA_COPY_SIZE;
+            if (n == 0 || n > delta_size - delta_written)
+                goto fail;
+
+            while (n) {
+                uint32_t chunk = n;
+                if (chunk > sizeof(delta_buf))
+                    chunk = sizeof(delta_buf);
+                if (src > DELTA_APP_SIZE ||
+                    flash_read_app(USER_APP_START + src, delta_buf, chunk) ||
+                    stage_write(delta_buf, chunk))
+                    goto fail;
+                src += chunk;
+                n -= chunk;
+            }
+        } else if (ops[0] == DELTA_OP_INSERT && len >= DELTA_INSERT_HEAD) {
+            n = ops[1] | (ops[2] << 8);
+            ops += DELTA_INSERT_HEAD;
+            len -= DELTA_INSERT_HEAD;
+            if (n == 0 || n > len || stage_write(ops, n))
+                goto fail;
+            ops += n;
+            len -= n;
+        } else {
+            goto fail;
+        }
+    }
+    return SUCCESSED;
+
+fail:
+    // the stage is inconsistent now, the programmer has to start over
+    delta_close();
+    return FAILED;
+}
+
+uint8_t delta_install(uint16_t *rewritten)
+{
+    uint16_t count = 0;
+
+    if (delta_state == DELTA_STAGING) {
+        lfs_file_close(&lfs_w25q128jv, &lfs_file_w25q128jv);
+        if (delta_written != delta_size || delta_sum != delta_crc) {
+            lfs_unmount(&lfs_w25q128jv);
+            delta_state = DELTA_IDLE;
+            return FAILED;
+        }
+        delta_state = DELTA_STAGED;
+    }
+    if (delta_state != DELTA_STAGED)
+        return FAILED;
+
+    if (lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv,
+                         DELTA_STAGE_PATH, LFS_O_RDONLY,
+                         &lfs_file_cfg_w25q128jv))
+        return FAILED;
+
+    uint8_t res = stage_check();
+    for (uint32_t page = 0; !res && page < DELTA_APP_SIZE;
+         page += FMC_FLASH_PAGE_SIZE) {
+        int8_t ret = install_page(page);
+        if (ret < 0)
+            res = FAILED;
+        else
+            count += ret;
+    }
+
+    lfs_file_close(&lfs_w25q128jv, &lfs_file_w25q128jv);
+    if (!res)
+        delta_close();  // done, a failed install keeps the stage for a retry
+    if (rewritten)
+        *rewritten = count;
+    return res;
+}
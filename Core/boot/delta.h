@@ -0,0 +1,67 @@
+/**
+ * @file delta.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Delta update against the user app already in APROM.
+ *
+ * The programmer sends an op stream that rebuilds the new image from the one
+ * in APROM:
+ *
+ *  COPY   : DELTA_OP_COPY   | SRC(4) | LEN(4)
+ *           LEN bytes of the current image from offset SRC.
+ *  INSERT : DELTA_OP_INSERT | LEN(2) | DATA(LEN)
+ *           LEN literal bytes.
+ *
+ * Offsets are relative to USER_APP_START, multi-byte fields little endian. The
+ * new image is staged on the W25Q128JV ("/delta" in LittleFS) first, so COPY
+ * never reads a page that was rewritten already. Installing then erases and
+ * programs only the FMC pages whose content changed.
+ */
+
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdint.h>
+
+#define DELTA_OP_COPY   0x01
+#define DELTA_OP_INSERT 0x02
+
+#define DELTA_COPY_SIZE   9  // op, SRC, LEN
+#define DELTA_INSERT_HEAD 3  // op, LEN
+
+/**
+ * @brief Start staging a new image.
+ * @param size new image size, at most the user app section.
+ * @param crc CRC-32 (see crc32.h) of the new image.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed.
+ */
+uint8_t delta_begin(uint32_t size, uint32_t crc);
+
+/**
+ * @brief Apply whole ops to the staged image.
+ * @param ofs new image offset the ops start at. Ops starting below the bytes
+ *        staged so far were applied already and are skipped.
+ * @param ops op stream, ops must not be split across calls.
+ * @param len op stream length.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, malformed op or the image would exceed its size.
+ */
+uint8_t delta_apply(uint32_t ofs, const uint8_t *ops, uint32_t len);
+
+/**
+ * @brief Check the staged image and install it into APROM.
+ *
+ * Can be called again after a failed install, the staged image is kept until
+ * the next delta_begin().
+ *
+ * @param rewritten number of FMC pages erased and programmed, may be NULL.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, incomplete image, CRC mismatch or flash error.
+ */
+uint8_t delta_install(uint16_t *rewritten);
+
+#endif /* DELTA_H */
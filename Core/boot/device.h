@@ -8,6 +8,23 @@
  *      Flash Size              : 512 kB
  *      USER_APP Section Size   : 448 kB
  *      BOOTLOADER Section Size :  64 kB
+ *
+ *      APROM Bank 0 : 0x00000 - 0x3FFFF, bootloader + user app (192 kB)
+ *      APROM Bank 1 : 0x40000 - 0x7FFFF, user app (256 kB)
+ *
+ *      An ISP erase or program stalls instruction fetch from its own bank
+ *      only. The bootloader runs from bank 0, so bank 1 is programmed while
+ *      it keeps running (read-while-write).
+ *
+ *      External Flash W25Q128JV (16 MB):
+ *
+ *      LittleFS    : 0x000000 - 0x7FFFFF (8 MB), /boot
+ *      Image slots : 0x800000 - 0xFFFFFF, 16 raw images of 512 kB, each
+ *                    mapped at EXT_FLASH_XIP_BASE + its flash address by SPIM
+ *                    for execute-in-place.
+ *
+ *      A LittleFS formatted over the whole chip before the slots still mounts
+ *      and keeps the slots unavailable, see lfs_port_mount_write().
  */
 
 #ifndef DEVICE_H
@@ -21,6 +38,19 @@
 #define BOOTLOADER_END   (0x0000FFFFUL)
 #define BOOTLOADER_SIZE  (0x00010000UL)
 
+#define APROM_BANK1_START (0x00040000UL)
+
+#define SRAM_START (0x20000000UL)
+#define SRAM_SIZE  (0x00028000UL)
+
+#define EXT_FLASH_SIZE       (0x01000000UL)
+#define EXT_FLASH_LFS_START  (0x00000000UL)
+#define EXT_FLASH_LFS_SIZE   (0x00800000UL)
+#define EXT_FLASH_SLOT_START (0x00800000UL)
+#define EXT_FLASH_SLOT_SIZE  (0x00080000UL)
+#define EXT_FLASH_SLOT_COUNT (16)
+#define EXT_FLASH_XIP_BASE   (0x08000000UL)  // SPIM_DMM_MAP_ADDR
+
 enum device_table {
     D_ATSAME54_DEVB = 1,
     D_NUM487KM_DEVB
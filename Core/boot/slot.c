@@ -0,0 +1,150 @@
+/**
+ * @file slot.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Raw image slots on the W25Q128JV, installed into APROM.
+ */
+
+#include "slot.h"
+#include <stddef.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "crc32.h"
+#include "flash.h"
+#include "sha256_dma.h"
+#include "w25q128jv.h"
+
+/*******************************************************************************
+ * Macro
+ ******************************************************************************/
+#define FAILED    1
+#define SUCCESSED 0
+
+struct slot_copy {
+    uint32_t load;  // APROM address of the image
+    uint32_t dest;  // APROM address of the next chunk
+    uint32_t end;   // W25Q128JV address after the image
+    uint32_t crc;   // CRC-32 of the image so far
+    uint32_t sp;    // initial SP, programmed last
+};
+
+/* The first multi-word row of the image with the initial SP left erased, an
+ * image without it is not started. */
+static uint32_t slot_row[FMC_MULTI_WORD_PROG_LEN / 4];
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+/**
+ * @brief Program a chunk, the first one without the initial SP.
+ */
+static uint8_t slot_program(struct slot_copy *copy,
+                            const uint8_t *pbuf,
+                            uint32_t bytes)
+{
+    uint32_t n = 0;
+
+    if (copy->dest == copy->load) {
+        n = (bytes < sizeof(slot_row)) ? bytes : sizeof(slot_row);
+        memcpy(slot_row, pbuf, n);
+        copy->sp = slot_row[0];
+        slot_row[0] = 0xFFFFFFFF;
+        if (flash_write_app(copy->dest, (const uint8_t *) slot_row, n))
+            return FAILED;
+    }
+    if (bytes > n && flash_write_app(copy->dest + n, pbuf + n, bytes - n))
+        return FAILED;
+    return SUCCESSED;
+}
+
+/**
+ * @brief w25q128jv_read_pipe() handler, hash and program the chunk just read.
+ * @return uint8_t 1: read on, 0: stop.
+ */
+static uint8_t slot_copy_chunk(void *ctx,
+                               const uint8_t *pbuf,
+                               uint32_t addr,
+                               uint32_t bytes)
+{
+    struct slot_copy *copy = ctx;
+    uint8_t ret;
+
+    // the engine fetches the chunk while it is programmed
+    sha256_dma_update(pbuf, bytes, addr + bytes == copy->end);
+    copy->crc = crc32_update(copy->crc, pbuf, bytes);
+    ret = slot_program(copy, pbuf, bytes);
+
+    // pbuf takes another chunk after the return
+    if (sha256_dma_wait() || ret)
+        return 0;
+    copy->dest += bytes;
+    return 1;
+}
+
+/*******************************************************************************
+ * Public Functions
+ ******************************************************************************/
+uint8_t slot_header_read(uint8_t slot, slot_header_t *hdr)
+{
+    if (slot >= EXT_FLASH_SLOT_COUNT)
+        return FAILED;
+
+    w25q128jv_read_bytes((uint8_t *) hdr, slot_base(slot) + SLOT_HEADER_OFS,
+                         sizeof(*hdr));
+    if (hdr->magic != SLOT_MAGIC ||
+        hdr->hdr_crc != crc32_update(0, (const uint8_t *) hdr,
+                                     offsetof(slot_header_t, hdr_crc)))
+        return FAILED;
+    if (!hdr->size || (hdr->size & 3) || hdr->size > SLOT_IMAGE_MAX ||
+        (hdr->load & (FMC_FLASH_PAGE_SIZE - 1)) || hdr->load < USER_APP_START ||
+        hdr->load > USER_APP_SIZE || hdr->size > USER_APP_SIZE - hdr->load)
+        return FAILED;
+    return SUCCESSED;
+}
+
+uint8_t slot_install(uint8_t slot,
+                     uint8_t *buf0,
+                     uint8_t *buf1,
+                     uint32_t chunk)
+{
+    slot_header_t hdr;
+    struct slot_copy copy;
+    uint8_t digest[32];
+    uint32_t span;  // bytes of the FMC pages the image covers
+    uint8_t ok;
+
+    if ((chunk % SHA256_DMA_BLOCK) || slot_header_read(slot, &hdr))
+        return FAILED;
+    if (sha256_dma_start())
+        return FAILED;  // an mbedtls message is in the engine
+
+    // bank 0 pages now, bank 1 pages right before they are programmed
+    span = (hdr.size + FMC_FLASH_PAGE_SIZE - 1) & ~(FMC_FLASH_PAGE_SIZE - 1);
+    if (flash_erase_app_defer(hdr.load, span)) {
+        sha256_dma_stop();
+        return FAILED;
+    }
+
+    // one pass: every chunk is read, hashed and programmed once
+    copy.load = copy.dest = hdr.load;
+    copy.end = slot_base(slot) + hdr.size;
+    copy.crc = 0;
+    ok = w25q128jv_read_pipe(buf0, buf1, chunk, slot_base(slot), hdr.size,
+                             slot_copy_chunk, &copy) == 1 &&
+         !flash_erase_flush() && copy.crc == hdr.crc;
+    if (ok) {
+        sha256_dma_digest(digest);
+        ok = !memcmp(digest, hdr.sha256, sizeof(digest));
+    } else {
+        sha256_dma_stop();
+    }
+
+    // commit, the vector table is whole from now on
+    if (ok && !flash_write_app(hdr.load, (const uint8_t *) &copy.sp, 4))
+        return SUCCESSED;
+
+    // roll back, no part of a bad image is left behind
+    flash_erase_app_defer(hdr.load, span);
+    flash_erase_flush();
+    return FAILED;
+}
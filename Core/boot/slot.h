@@ -0,0 +1,88 @@
+/**
+ * @file slot.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Raw image slots on the W25Q128JV, installed into APROM.
+ *
+ * A slot (device.h) holds the image from its start, where an image run in
+ * place keeps its vector table, and a header in its last 4 KiB sector. The
+ * programmer writes the header after the image:
+ *
+ *  MAGIC(4)    : SLOT_MAGIC
+ *  SIZE(4)     : image length, multiple of 4, at most SLOT_IMAGE_MAX
+ *  LOAD(4)     : APROM address to install to, FMC page aligned
+ *  CRC(4)      : CRC-32 (zlib crc32()) of the image
+ *  SHA256(32)  : SHA-256 of the image, checked on install
+ *  HDR_CRC(4)  : CRC-32 of the fields before
+ *
+ * The install reads the image with one Fast Read from start to end and
+ * programs it chunk by chunk as it arrives, no filesystem in between. The CRPT
+ * engine hashes each chunk by DMA while it is programmed, so the SHA-256 is
+ * checked without reading the image a second time.
+ */
+
+#ifndef SLOT_H
+#define SLOT_H
+
+#include <stdint.h>
+#include "device.h"
+
+#define SLOT_MAGIC      0x544F4C53UL  // "SLOT"
+#define SLOT_HEADER_OFS (EXT_FLASH_SLOT_SIZE - 4096)
+#define SLOT_IMAGE_MAX  SLOT_HEADER_OFS
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t load;
+    uint32_t crc;
+    uint8_t sha256[32];
+    uint32_t hdr_crc;
+} slot_header_t;
+
+/**
+ * @brief W25Q128JV address of a slot.
+ * @param slot 0 to EXT_FLASH_SLOT_COUNT - 1.
+ */
+static inline uint32_t slot_base(uint8_t slot)
+{
+    return EXT_FLASH_SLOT_START + slot * EXT_FLASH_SLOT_SIZE;
+}
+
+/**
+ * @brief Read and check the header of a slot.
+ * @param slot slot number.
+ * @param hdr the header.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, no slot, no header, or the image does not fit the user app
+ *         section.
+ */
+uint8_t slot_header_read(uint8_t slot, slot_header_t *hdr);
+
+/**
+ * @brief Install the image of a slot at its load address.
+ *
+ * The FMC pages of the image are scheduled for erasing, the image is streamed
+ * into them and its CRC-32 and SHA-256 taken on the way. With two buffers the
+ * next chunk is read by PDMA while the current one is programmed.
+ *
+ * The initial SP is held back until both match, it commits the image. On a
+ * mismatch or a program failure, the commit included, the pages are erased
+ * again.
+ *
+ * @param slot slot number.
+ * @param buf0 chunk buffer, word aligned.
+ * @param buf1 the other chunk buffer, word aligned, or NULL.
+ * @param chunk chunk length, multiple of SHA256_DMA_BLOCK, 16 KiB at most.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, bad header, program failure, CRC-32 or SHA-256 mismatch,
+ *         or an mbedtls message holds the CRPT engine.
+ */
+uint8_t slot_install(uint8_t slot,
+                     uint8_t *buf0,
+                     uint8_t *buf1,
+                     uint32_t chunk);
+
+#endif /* SLOT_H */
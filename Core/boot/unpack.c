@@ -0,0 +1,205 @@
+/**
+ * @file unpack.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Compressed flash write, decompressed on the fly into APROM.
+ */
+
+#include "unpack.h"
+#include <string.h>
+#include "device.h"
+#include "flash.h"
+
+/*******************************************************************************
+ * Macro
+ ******************************************************************************/
+#define FAILED    1
+#define SUCCESSED 0
+
+#define UNPACK_MASK (UNPACK_WINDOW - 1)
+
+#if (UNPACK_WINDOW & UNPACK_MASK) || (UNPACK_WINDOW % UNPACK_ROW)
+#error "UNPACK_WINDOW must be a power of 2 and a multiple of UNPACK_ROW"
+#endif
+
+enum {
+    UNPACK_IDLE,
+    UNPACK_TOKEN,
+    UNPACK_LIT_EXT,
+    UNPACK_LITERAL,
+    UNPACK_OFFSET_LO,
+    UNPACK_OFFSET_HI,
+    UNPACK_MATCH_EXT,
+    UNPACK_DONE,
+};
+
+/* The rows are programmed straight from the ring, so it must be aligned. */
+static uint8_t unpack_ring[UNPACK_WINDOW] __attribute__((__aligned__(4)));
+
+static uint8_t unpack_state;
+static uint32_t unpack_addr;      // APROM address of the image
+static uint32_t unpack_size;      // decompressed image size
+static uint32_t unpack_consumed;  // stream bytes consumed so far
+static uint32_t unpack_out;       // bytes decompressed so far
+static uint32_t unpack_lit;       // literals left in the current sequence
+static uint32_t unpack_match;     // match length of the current sequence
+static uint16_t unpack_offset;    // match offset of the current sequence
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+
+/**
+ * @brief Program the row the output just completed, padded when it is the
+ *        last one.
+ */
+static uint8_t flush_row(void)
+{
+    uint32_t fill = unpack_out % UNPACK_ROW;
+    uint32_t start = unpack_out - (fill ? fill : UNPACK_ROW);
+
+    if (fill)
+        memset(unpack_ring + (unpack_out & UNPACK_MASK), 0xFF,
+               UNPACK_ROW - fill);
+    return flash_write_app(unpack_addr + start,
+                           unpack_ring + (start & UNPACK_MASK), UNPACK_ROW);
+}
+
+static uint8_t put_byte(uint8_t data)
+{
+    if (unpack_out >= unpack_size)
+        return FAILED;
+    unpack_ring[unpack_out++ & UNPACK_MASK] = data;
+    if (!(unpack_out % UNPACK_ROW) || unpack_out == unpack_size)
+        return flush_row();
+    return SUCCESSED;
+}
+
+static uint8_t copy_match(void)
+{
+    if (unpack_offset == 0 || unpack_offset > UNPACK_WINDOW ||
+        unpack_offset > unpack_out || unpack_match > unpack_size - unpack_out)
+        return FAILED;
+
+    // byte by byte, an offset below the length repeats the last bytes
+    for (; unpack_match; unpack_match--) {
+        if (put_byte(unpack_ring[(unpack_out - unpack_offset) & UNPACK_MASK]))
+            return FAILED;
+    }
+    unpack_state = (unpack_out == unpack_size) ? UNPACK_DONE : UNPACK_TOKEN;
+    return SUCCESSED;
+}
+
+/**
+ * @brief The literals of a sequence are done, the image may be complete.
+ */
+static uint8_t end_literals(void)
+{
+    unpack_state = (unpack_out == unpack_size) ? UNPACK_DONE : UNPACK_OFFSET_LO;
+    return SUCCESSED;
+}
+
+static uint8_t unpack_byte(uint8_t data)
+{
+    switch (unpack_state) {
+    case UNPACK_TOKEN:
+        unpack_lit = data >> 4;
+        unpack_match = (data & 0x0F) + UNPACK_MIN_MATCH;
+        if (unpack_lit == 15)
+            unpack_state = UNPACK_LIT_EXT;
+        else if (unpack_lit)
+            unpack_state = UNPACK_LITERAL;
+        else
+            return end_literals();
+        return SUCCESSED;
+
+    case UNPACK_LIT_EXT:
+        unpack_lit += data;
+        if (unpack_lit > unpack_size)
+            return FAILED;
+        if (data == 255)
+            return SUCCESSED;
+        if (unpack_lit) {
+            unpack_state = UNPACK_LITERAL;
+            return SUCCESSED;
+        }
+        return end_literals();
+
+    case UNPACK_LITERAL:
+        if (put_byte(data))
+            return FAILED;
+        if (--unpack_lit)
+            return SUCCESSED;
+        return end_literals();
+
+    case UNPACK_OFFSET_LO:
+        unpack_offset = data;
+        unpack_state = UNPACK_OFFSET_HI;
+        return SUCCESSED;
+
+    case UNPACK_OFFSET_HI:
+        unpack_offset |= data << 8;
+        if (unpack_match == 15 + UNPACK_MIN_MATCH) {
+            unpack_state = UNPACK_MATCH_EXT;
+            return SUCCESSED;
+        }
+        return copy_match();
+
+    case UNPACK_MATCH_EXT:
+        unpack_match += data;
+        if (unpack_match > unpack_size)
+            return FAILED;
+        if (data == 255)
+            return SUCCESSED;
+        return copy_match();
+
+    default:  // trailing bytes past the image, or aborted
+        return FAILED;
+    }
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint8_t unpack_begin(uint32_t addr, uint32_t size)
+{
+    unpack_state = UNPACK_IDLE;
+
+    if ((addr % UNPACK_ROW) ||
+        addr <= BOOTLOADER_END || size == 0 || addr + size > USER_APP_SIZE ||
+        addr + size < addr)
+        return FAILED;
+
+    unpack_addr = addr;
+    unpack_size = size;
+    unpack_consumed = 0;
+    unpack_out = 0;
+    unpack_state = UNPACK_TOKEN;
+    return SUCCESSED;
+}
+
+uint8_t unpack_data(uint32_t ofs, const uint8_t *buf, uint32_t len)
+{
+    if (unpack_state == UNPACK_IDLE || ofs > unpack_consumed)
+        return FAILED;
+
+    // a retransmission after a lost ACK, only the new tail counts
+    if (ofs + len <= unpack_consumed)
+        return SUCCESSED;
+    buf += unpack_consumed - ofs;
+    len -= unpack_consumed - ofs;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (unpack_byte(buf[i])) {
+            unpack_state = UNPACK_IDLE;
+            return FAILED;
+        }
+    }
+    unpack_consumed += len;
+    return SUCCESSED;
+}
+
+uint32_t unpack_written(void)
+{
+    return unpack_out;
+}
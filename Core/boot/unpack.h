@@ -0,0 +1,72 @@
+/**
+ * @file unpack.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Compressed flash write, decompressed on the fly into APROM.
+ *
+ * The programmer sends the image as one LZ4 block style sequence stream, split
+ * into packets anywhere:
+ *
+ *  TOKEN(1)       : literal count (high nibble) | match length - 4 (low)
+ *  [LIT_EXT(n)]   : nibble 15 continues with bytes added until one is < 255
+ *  LITERALS       : literal count bytes
+ *  OFFSET(2)      : distance back into the output, 1..UNPACK_WINDOW
+ *  [MATCH_EXT(n)] : as LIT_EXT, for the match length
+ *
+ * The stream ends as soon as the output reaches the image size, after the
+ * literals or the match of the last sequence. The output goes through a static
+ * UNPACK_WINDOW byte history ring, every full UNPACK_ROW is programmed straight
+ * from it and the last one is padded with 0xFF.
+ */
+
+#ifndef UNPACK_H
+#define UNPACK_H
+
+#include <stdint.h>
+
+/**
+ * @brief Program unit, one multi-word program and independent of the page size
+ *        set by CMD_FLASH_SET_PGSZ.
+ */
+#define UNPACK_ROW 512
+
+/**
+ * @brief History window, the largest match offset. Power of 2 and a multiple
+ *        of UNPACK_ROW.
+ */
+#ifndef UNPACK_WINDOW
+#define UNPACK_WINDOW 4096
+#endif
+
+#define UNPACK_MIN_MATCH 4
+
+/**
+ * @brief Start a compressed write.
+ * @param addr APROM address of the image, UNPACK_ROW aligned, erased before.
+ * @param size decompressed image size.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, the image is not inside the user app section.
+ */
+uint8_t unpack_begin(uint32_t addr, uint32_t size);
+
+/**
+ * @brief Decompress a piece of the stream.
+ * @param ofs stream offset of the piece. Bytes below the ones consumed so far
+ *        were decompressed already and are skipped.
+ * @param buf stream data.
+ * @param len stream data length.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, gap in the stream, malformed sequence or flash error. The
+ *         write is aborted until the next unpack_begin().
+ */
+uint8_t unpack_data(uint32_t ofs, const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Number of bytes decompressed so far.
+ * @return uint32_t the image size once the whole image is programmed.
+ */
+uint32_t unpack_written(void);
+
+#endif /* UNPACK_H */
@@ -65,7 +65,8 @@ int main(void)
         // if (select_boot_partition())
         //     return 0;
         // printf("\033[0;32;32m\x1B[1m=======================\033[m\n");
-        system_jump_to_app();
+        if (boot_from_xip())
+            system_jump_to_app();
     }
     while (1) {
         APROM_update_enable();
@@ -27,6 +27,10 @@
 
 int32_t  g_FMC_i32ErrCode;
 
+/* The ISP helpers the bootloader erases and programs APROM with run from
+ * SRAM, see RAMFUNC in boot_system.h */
+#define FMC_RAMFUNC __attribute__((section(".ramfunc"), noinline))
+
 
 /**
   * @brief Disable FMC ISP function.
@@ -140,7 +144,7 @@ int32_t FMC_ConfigXOM(uint32_t u32XomNum, uint32_t u32XomBase, uint8_t u8XomPage
   * @note     Global error code g_FMC_i32ErrCode
   *           -1  Erase failed or erase time-out
   */
-int32_t FMC_Erase(uint32_t u32PageAddr)
+FMC_RAMFUNC int32_t FMC_Erase(uint32_t u32PageAddr)
 {
     int32_t  tout;
 
@@ -220,7 +224,7 @@ int32_t FMC_Erase_SPROM(void)
   * @note     Global error code g_FMC_i32ErrCode
   *           -1  Erase failed or erase time-out
   */
-int32_t FMC_Erase_Block(uint32_t u32BlockAddr)
+FMC_RAMFUNC int32_t FMC_Erase_Block(uint32_t u32BlockAddr)
 {
     int32_t  tout;
 
@@ -535,7 +539,7 @@ void FMC_SetBootSource(int32_t i32BootSrc)
   * @note     Global error code g_FMC_i32ErrCode
   *           -1  Program failed or time-out
   */
-int32_t FMC_Write(uint32_t u32Addr, uint32_t u32Data)
+FMC_RAMFUNC int32_t FMC_Write(uint32_t u32Addr, uint32_t u32Data)
 {
     int32_t  tout;
 
@@ -574,7 +578,7 @@ int32_t FMC_Write(uint32_t u32Addr, uint32_t u32Data)
   * @note     Global error code g_FMC_i32ErrCode
   *           -1  Program failed or time-out
   */
-int32_t FMC_Write8Bytes(uint32_t u32addr, uint32_t u32data0, uint32_t u32data1)
+FMC_RAMFUNC int32_t FMC_Write8Bytes(uint32_t u32addr, uint32_t u32data0, uint32_t u32data1)
 {
     int32_t  tout;
 
@@ -617,7 +621,7 @@ int32_t FMC_Write8Bytes(uint32_t u32addr, uint32_t u32data0, uint32_t u32data1)
   *           -1  Program failed or time-out
   *           -2  Invalid address
   */
-int32_t FMC_WriteMultiple(uint32_t u32Addr, uint32_t pu32Buf[], uint32_t u32Len)
+FMC_RAMFUNC int32_t FMC_WriteMultiple(uint32_t u32Addr, uint32_t pu32Buf[], uint32_t u32Len)
 {
     int   i, idx, retval = 0;
     int32_t  tout;
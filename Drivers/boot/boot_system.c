@@ -6,9 +6,44 @@
  */
 
 #include "boot_system.h"
+#include <string.h>
 #include "NuMicro.h"
+#include "commuch.h"
 #include "device.h"
 
+static volatile uint32_t system_tick;
+
+/* The exceptions are taken from SRAM while an ISP operation stalls APROM.
+ * VTOR needs the table aligned to its size rounded up to a power of 2. */
+#define VECTOR_COUNT (16 + 109)  // startup_M480.S
+
+extern uint32_t __Vectors[];
+static uint32_t ram_vectors[VECTOR_COUNT] __attribute__((aligned(512)));
+
+static system_pdma_handler_t pdma_handlers[PDMA_CH_MAX];
+
+/*******************************************************************************
+ * Interrupt Handler
+ ******************************************************************************/
+RAMFUNC void SysTick_Handler(void)
+{
+    system_tick++;
+}
+
+RAMFUNC void PDMA_IRQHandler(void)
+{
+    uint32_t abort = PDMA_GET_ABORT_STS(PDMA);
+    uint32_t done = PDMA_GET_TD_STS(PDMA);
+    uint32_t pending = abort | done;
+
+    PDMA_CLR_ABORT_FLAG(PDMA, abort);
+    PDMA_CLR_TD_FLAG(PDMA, done);
+    for (uint32_t ch = 0; pending; ch++, pending >>= 1) {
+        if ((pending & 1) && pdma_handlers[ch])
+            pdma_handlers[ch]();
+    }
+}
+
 /*******************************************************************************
  * Peripheral Driver - private function
  ******************************************************************************/
@@ -38,15 +73,33 @@ static void system_clock_init(void)
     /* Enable UART clock */
     CLK_EnableModuleClock(UART0_MODULE);
 
+#if BOOT_SPI_FLASH_HAS_QSPI0
+    /* Enable QSPI0 peripheral clock */
+    CLK_EnableModuleClock(QSPI0_MODULE);
+#endif
+#if BOOT_SPI_FLASH_HAS_SPI2
     /* Enable SPI2 peripheral clock */
     CLK_EnableModuleClock(SPI2_MODULE);
+#endif
 
     /* Select UART clock source from HXT and UART module clock divider as 1 */
     CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT,
                        CLK_CLKDIV0_UART0(1));
 
+#if BOOT_SPI_FLASH_HAS_QSPI0
+    /* Select PCLK0 as the clock source of QSPI0 */
+    CLK_SetModuleClock(QSPI0_MODULE, CLK_CLKSEL2_QSPI0SEL_PCLK0, MODULE_NoMsk);
+#endif
+#if BOOT_SPI_FLASH_HAS_SPI2
     /* Select PCLK1 as the clock source of SPI2 */
     CLK_SetModuleClock(SPI2_MODULE, CLK_CLKSEL2_SPI2SEL_PCLK1, MODULE_NoMsk);
+#endif
+
+    /* Enable PDMA clock, UART0 transmission */
+    CLK_EnableModuleClock(PDMA_MODULE);
+
+    /* Enable CRC clock, protocol v2 framing */
+    CLK_EnableModuleClock(CRC_MODULE);
 
     /* Enable CRYPTO module clock */
     CLK_EnableModuleClock(CRPT_MODULE);
@@ -55,6 +108,9 @@ static void system_clock_init(void)
     /* User can use SystemCoreClockUpdate() to calculate SystemCoreClock and
      * CyclesPerUs automatically. */
     SystemCoreClockUpdate();
+
+    /* 1 ms system tick */
+    SysTick_Config(SystemCoreClock / 1000);
 }
 
 /**
@@ -102,8 +158,11 @@ static void system_uart0_init(void)
     SYS->GPB_MFPH |=
         (SYS_GPB_MFPH_PB12MFP_UART0_RXD | SYS_GPB_MFPH_PB13MFP_UART0_TXD);
 
-    /* Init UART to 38400-8n1 for print message */
-    UART_Open(UART0, 38400);
+    /* Init UART to 38400-8n1, CMD_SET_BAUD raises it later */
+    UART_Open(UART0, COM_CHANNEL_BAUD_DEFAULT);
+
+    /* Interrupt driven reception */
+    com_channel_init();
 }
 
 /**
@@ -111,19 +170,73 @@ static void system_uart0_init(void)
  */
 static void system_uart0_deinit(void)
 {
+    com_channel_deinit();
     UART_Close(UART0);
 }
 
+#if BOOT_SPI_FLASH_HAS_QSPI0
 /**
- * @brief For External Flash - w25q128jv
+ * @brief QSPI0 pins of the W25Q128JV, quad capable
+ *
+ *  FLASH_IO0   : PA.0 (QSPI0_MOSI0)
+ *  FLASH_IO1   : PA.1 (QSPI0_MISO0)
+ *  FLASH_SCK   : PA.2
+ *  FLASH_CS    : PA.3
+ *  FLASH_IO2   : PA.4 (QSPI0_MOSI1, /WP)
+ *  FLASH_IO3   : PA.5 (QSPI0_MISO1, /HOLD)
+ *
+ *  PA.4 and PA.5 start as GPIO outputs holding /WP and /HOLD high, QSPI0
+ *  gets them once the QE probe selects quad, see system_spi_quad_pins().
+ *
+ * @param on 1: to QSPI0, 0: back to GPIO inputs as after reset.
+ */
+static void system_qspi0_pins(uint8_t on)
+{
+    SYS->GPA_MFPL &= ~(SYS_GPA_MFPL_PA0MFP_Msk | SYS_GPA_MFPL_PA1MFP_Msk |
+                       SYS_GPA_MFPL_PA2MFP_Msk | SYS_GPA_MFPL_PA3MFP_Msk |
+                       SYS_GPA_MFPL_PA4MFP_Msk | SYS_GPA_MFPL_PA5MFP_Msk);
+    if (!on) {
+        GPIO_SetMode(PA, BIT4 | BIT5, GPIO_MODE_INPUT);
+        return;
+    }
+
+    /* /WP and /HOLD high before the flash is selected */
+    PA4 = 1;
+    PA5 = 1;
+    GPIO_SetMode(PA, BIT4 | BIT5, GPIO_MODE_OUTPUT);
+
+    SYS->GPA_MFPL |= SYS_GPA_MFPL_PA0MFP_QSPI0_MOSI0 |
+                     SYS_GPA_MFPL_PA1MFP_QSPI0_MISO0 |
+                     SYS_GPA_MFPL_PA2MFP_QSPI0_CLK |
+                     SYS_GPA_MFPL_PA3MFP_QSPI0_SS;
+
+    /* Enable QSPI0 clock pin (PA2) schmitt trigger */
+    PA->SMTEN |= GPIO_SMTEN_SMTEN2_Msk;
+
+    /* Enable QSPI0 I/O high slew rate */
+    GPIO_SetSlewCtl(PA, 0x3F, GPIO_SLEWCTL_FAST);
+}
+#endif
+
+#if BOOT_SPI_FLASH_HAS_SPI2
+/**
+ * @brief SPI2 pins of the W25Q128JV
  *
  *  FLASH_MOSI  : PA.8
  *  FLASH_SCK   : PA.10
  *  FLASH_MISO  : PG.4
  *  FLASH_CS    : PA.11
+ *
+ * @param on 1: to SPI2, 0: back to GPIO inputs as after reset.
  */
-static void system_spi_init(void)
+static void system_spi2_pins(uint8_t on)
 {
+    SYS->GPA_MFPH &= ~(SYS_GPA_MFPH_PA8MFP_Msk | SYS_GPA_MFPH_PA10MFP_Msk |
+                       SYS_GPA_MFPH_PA11MFP_Msk);
+    SYS->GPG_MFPL &= ~SYS_GPG_MFPL_PG4MFP_Msk;
+    if (!on)
+        return;
+
     /* Setup SPI2 multi-function pins */
     // TODO: Change Flash_CS from PG4 (MFP3) to PA9 (MFP4)
     // SYS->GPA_MFPH |= SYS_GPA_MFPH_PA11MFP_SPI2_SS |
@@ -140,13 +253,42 @@ static void system_spi_init(void)
     /* Enable SPI2 I/O high slew rate */
     GPIO_SetSlewCtl(PA, 0xF, GPIO_SLEWCTL_FAST);
     GPIO_SetSlewCtl(PG, 0xF, GPIO_SLEWCTL_FAST);
+}
+#endif
 
+/**
+ * @brief For External Flash - w25q128jv
+ *
+ *  With BOOT_SPI_FLASH_AUTO both controllers are opened and no pins are
+ *  routed yet, the driver routes them per port it probes through
+ *  system_spi_flash_port().
+ */
+static void system_spi_init(void)
+{
+#if BOOT_SPI_FLASH_HAS_QSPI0
+    /* Configure QSPI_FLASH_PORT as a master, MSB first, 8-bit transaction,
+     * SPI Mode-0 timing, clock is 20MHz. Quad mode is switched per
+     * instruction by the w25q128jv driver. */
+    QSPI_Open(QSPI_FLASH_PORT, QSPI_MASTER, QSPI_MODE_0, 8, 20000000);
+
+    /* Disable auto SS function, control SS signal manually. */
+    QSPI_DisableAutoSS(QSPI_FLASH_PORT);
+#endif
+
+#if BOOT_SPI_FLASH_HAS_SPI2
     /* Configure SPI_FLASH_PORT as a master, MSB first, 8-bit transaction, SPI
      * Mode-0 timing, clock is 20MHz */
     SPI_Open(SPI_FLASH_PORT, SPI_MASTER, SPI_MODE_0, 8, 20000000);
 
     /* Disable auto SS function, control SS signal manually. */
     SPI_DisableAutoSS(SPI_FLASH_PORT);
+#endif
+
+#if BOOT_SPI_FLASH_QSPI == BOOT_SPI_FLASH_QSPI0
+    system_qspi0_pins(1);
+#elif BOOT_SPI_FLASH_QSPI == BOOT_SPI_FLASH_SPI2
+    system_spi2_pins(1);
+#endif
 }
 
 static void system_spi_deinit(void)
@@ -154,12 +296,54 @@ static void system_spi_deinit(void)
     // TODO:
 }
 
+#if BOOT_SPI_FLASH_HAS_QSPI0
+/**
+ * @brief Map the W25Q128JV at SPIM_DMM_MAP_ADDR, reads through the SPIM cache.
+ *
+ *  FLASH_IO0   : PA.0 (SPIM_MOSI)
+ *  FLASH_IO1   : PA.1 (SPIM_MISO)
+ *  FLASH_SCK   : PA.2 (SPIM_CLK)
+ *  FLASH_CS    : PA.3 (SPIM_SS)
+ *  FLASH_IO2   : PA.4 (GPIO high, /WP)
+ *  FLASH_IO3   : PA.5 (GPIO high, /HOLD)
+ *
+ *  PA.4 and PA.5 are SPIM_D3 and SPIM_D2, the reverse of QSPI0_MOSI1 and
+ *  QSPI0_MISO1, so quad reads would swap IO2 and IO3. The window is read with
+ *  Fast Read Dual I/O (BBh) on IO0 and IO1 instead, at HCLK / 2 = 96 MHz.
+ */
+static void system_spim_init(void)
+{
+    CLK_EnableModuleClock(SPIM_MODULE);
+
+    SYS->GPA_MFPL &= ~(SYS_GPA_MFPL_PA0MFP_Msk | SYS_GPA_MFPL_PA1MFP_Msk |
+                       SYS_GPA_MFPL_PA2MFP_Msk | SYS_GPA_MFPL_PA3MFP_Msk |
+                       SYS_GPA_MFPL_PA4MFP_Msk | SYS_GPA_MFPL_PA5MFP_Msk);
+    SYS->GPA_MFPL |= SYS_GPA_MFPL_PA0MFP_SPIM_MOSI |
+                     SYS_GPA_MFPL_PA1MFP_SPIM_MISO |
+                     SYS_GPA_MFPL_PA2MFP_SPIM_CLK |
+                     SYS_GPA_MFPL_PA3MFP_SPIM_SS;
+    PA4 = 1;
+    PA5 = 1;
+    GPIO_SetMode(PA, BIT4 | BIT5, GPIO_MODE_OUTPUT);
+
+    SPIM_SET_CLOCK_DIVIDER(1);
+    SPIM_DISABLE_CCM();  // the cache caches, it is not mapped as SRAM
+    SPIM_ENABLE_CACHE();
+    SPIM_INVALID_CACHE();  // the slot may have been rewritten since
+    SPIM_EnterDirectMapMode(0, CMD_DMA_FAST_DUAL_READ, 0);
+}
+#endif
+
 /*******************************************************************************
  * Public Function
  ******************************************************************************/
 
 void system_init(void)
 {
+    memcpy(ram_vectors, __Vectors, sizeof(ram_vectors));
+    SCB->VTOR = (uint32_t) ram_vectors;
+    __DSB();
+
     /* Unlock protected registers */
     SYS_UnlockReg();
 
@@ -189,19 +373,19 @@ void system_deinit(void)
     SYS_UnlockReg();
 
 #if defined(BOOT_SPI_DRIVER_ENABLE) && (BOOT_SPI_DRIVER_ENABLE + 0)
-    system_spi_init();
+    system_spi_deinit();
 #endif
 
 #if defined(BOOT_UART_DRIVER_ENABLE) && (BOOT_UART_DRIVER_ENABLE + 0)
-    system_uart0_init();
+    system_uart0_deinit();
 #endif
 
 #if defined(BOOT_CLOCK_DRIVER_ENABLE) && (BOOT_CLOCK_DRIVER_ENABLE + 0)
-    system_clock_init();
+    system_clock_deinit();
 #endif
 
 #if defined(BOOT_GPIO_DRIVER_ENABLE) && (BOOT_GPIO_DRIVER_ENABLE + 0)
-    system_gpio_init();
+    system_gpio_deinit();
 #endif
 
     /* Lock protected registers */
@@ -212,25 +396,20 @@ void system_deinit(void)
  * Bootloader Operation
  ******************************************************************************/
 
-__attribute__((always_inline)) static inline void jump2app(void)
+__attribute__((always_inline)) static inline void jump2app(uint32_t vectors)
 {
     // Setting the stack pointer.
-    __set_MSP(*(uint32_t *) USER_APP_START);
+    __set_MSP(*(uint32_t *) vectors);
 
     // SP + 4: Reset Handler Offset.
-    __ASM volatile("BLX %0" : : "r"(*(uint32_t *) (USER_APP_START + 4)));
+    __ASM volatile("BLX %0" : : "r"(*(uint32_t *) (vectors + 4)));
 }
 
-void system_jump_to_app(void)
+/**
+ * @brief Hand the core over to the image whose vector table is at vectors.
+ */
+static void system_jump(uint32_t vectors)
 {
-    // TODO If not in Privileged Mode.
-    // if (CONTROL_nPRIV_Msk & __get_CONTROL()) {
-    //    // not in privileged mode
-    //    __asm("SVC #0\n");
-    // }
-
-    system_deinit();
-
     __disable_irq();
 
     NVIC->ICER[0] = 0xFFFFFFFF;
@@ -260,14 +439,93 @@ void system_jump_to_app(void)
     __DSB();
     __ISB();
 
-    SCB->VTOR = (USER_APP_START & SCB_VTOR_TBLOFF_Msk);
+    SCB->VTOR = (vectors & SCB_VTOR_TBLOFF_Msk);
 
     __DSB();
     __ISB();
 
     __enable_irq();
 
-    jump2app();
+    jump2app(vectors);
+}
+
+void system_jump_to_app(void)
+{
+    // TODO If not in Privileged Mode.
+    // if (CONTROL_nPRIV_Msk & __get_CONTROL()) {
+    //    // not in privileged mode
+    //    __asm("SVC #0\n");
+    // }
+
+    system_deinit();
+    system_jump(USER_APP_START);
+}
+
+void system_jump_to_xip(uint32_t vectors)
+{
+#if BOOT_SPI_FLASH_HAS_QSPI0
+    system_deinit();
+
+    SYS_UnlockReg();
+    system_spim_init();
+    SYS_LockReg();
+
+    system_jump(vectors);
+#else
+    (void) vectors;  // SPIM cannot reach the flash on SPI2
+#endif
+}
+
+void system_pdma_attach(uint32_t ch, system_pdma_handler_t handler)
+{
+    pdma_handlers[ch] = handler;
+    NVIC_EnableIRQ(PDMA_IRQn);
+}
+
+void system_spi_flash_port(uint8_t qspi)
+{
+#if BOOT_SPI_FLASH_QSPI == BOOT_SPI_FLASH_AUTO
+    // the other port's pins are released first, nothing drives both
+    if (qspi) {
+        system_spi2_pins(0);
+        system_qspi0_pins(1);
+    } else {
+        system_qspi0_pins(0);
+        system_spi2_pins(1);
+    }
+#else
+    (void) qspi;  // routed by system_spi_init()
+#endif
+}
+
+void system_spi_quad_pins(uint8_t quad)
+{
+#if BOOT_SPI_FLASH_HAS_QSPI0
+    SYS->GPA_MFPL &= ~(SYS_GPA_MFPL_PA4MFP_Msk | SYS_GPA_MFPL_PA5MFP_Msk);
+    if (quad)
+        SYS->GPA_MFPL |= SYS_GPA_MFPL_PA4MFP_QSPI0_MOSI1 |
+                         SYS_GPA_MFPL_PA5MFP_QSPI0_MISO1;
+#else
+    (void) quad;  // SPI2 has no IO2 and IO3
+#endif
+}
+
+RAMFUNC uint32_t system_get_tick(void)
+{
+    return system_tick;
+}
+
+uint32_t system_get_us(void)
+{
+    uint32_t ms, val;
+
+    // SysTick counts down from LOAD once per millisecond
+    do {
+        ms = system_tick;
+        val = SysTick->VAL;
+    } while (ms != system_tick);
+    return ms * 1000 +
+           (SysTick->LOAD - val) / (SystemCoreClock / 1000000);
 }
 
 uint8_t system_is_prog_mode(void)
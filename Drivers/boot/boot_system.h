@@ -11,8 +11,19 @@
 
 #include <stdint.h>
 
-#define PLL_CLOCK      192000000UL
-#define SPI_FLASH_PORT SPI2
+#define PLL_CLOCK       192000000UL
+#define SPI_FLASH_PORT  SPI2
+#define QSPI_FLASH_PORT QSPI0
+
+/**
+ * @brief Run a function from SRAM, copied there by Reset_Handler.
+ *
+ *  An ISP erase or program stalls instruction fetch from the APROM bank it
+ *  works on. Marked are the interrupt handlers, the UART0 receive path,
+ *  get_packet()/put_packet(), flash_write_app_page() and what it calls, and
+ *  the BSP's FMC erase and program helpers (FMC_RAMFUNC in fmc.c).
+ */
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline))
 
 /*******************************************************************************
  * Peripheral Driver Enable
@@ -33,12 +44,59 @@
 #define BOOT_SPI_DRIVER_ENABLE 1
 #endif
 
+/* Port of the W25Q128JV. BOOT_SPI_FLASH_AUTO opens both controllers and the
+ * driver picks the port at run time: QSPI0 (PA.0 - PA.5, quad SPI and XIP)
+ * when the flash answers there, else SPI2 (PA.8, PA.10, PG.4, PA.11) as on
+ * the original wiring. BOOT_SPI_FLASH_QSPI0 or BOOT_SPI_FLASH_SPI2 build a
+ * single port, see README "External Flash" and system_spi_init() */
+#define BOOT_SPI_FLASH_SPI2  0
+#define BOOT_SPI_FLASH_QSPI0 1
+#define BOOT_SPI_FLASH_AUTO  2
+
+#ifndef BOOT_SPI_FLASH_QSPI
+#define BOOT_SPI_FLASH_QSPI BOOT_SPI_FLASH_AUTO
+#endif
+
+#define BOOT_SPI_FLASH_HAS_QSPI0 (BOOT_SPI_FLASH_QSPI != BOOT_SPI_FLASH_SPI2)
+#define BOOT_SPI_FLASH_HAS_SPI2  (BOOT_SPI_FLASH_QSPI != BOOT_SPI_FLASH_QSPI0)
+
+/* Quad instructions on QSPI0 when QE is set. 0: single SPI only, PA.4 and
+ * PA.5 stay GPIO outputs holding /WP and /HOLD high */
+#ifndef BOOT_SPI_FLASH_QUAD
+#define BOOT_SPI_FLASH_QUAD 1
+#endif
+
+/**
+ * @brief Hand IO2 and IO3 of the flash on QSPI0 to QSPI0 for quad
+ *        instructions, or hold /WP and /HOLD high by GPIO for single SPI.
+ *        Called by w25q128jv_probe_quad(), nothing to do on SPI2.
+ * @param quad 1: PA.4, PA.5 QSPI0_MOSI1, QSPI0_MISO1, 0: GPIO high.
+ */
+void system_spi_quad_pins(uint8_t quad);
+
+/**
+ * @brief Route the flash pins to the port the w25q128jv driver probes and
+ *        release the other port's pins to GPIO inputs.
+ *        Only BOOT_SPI_FLASH_AUTO routes here, single port builds route in
+ *        system_spi_init().
+ * @param qspi 1: QSPI0, 0: SPI2.
+ */
+void system_spi_flash_port(uint8_t qspi);
+
+/**
+ * @brief Completion handler of a PDMA channel, see system_pdma_attach().
+ *
+ *  NOTE: Called from the PDMA interrupt handler.
+ */
+typedef void (*system_pdma_handler_t)(void);
+
 /*******************************************************************************
  * Public Function
  ******************************************************************************/
 /**
  * @brief System initialization.
  *
+ *  - Vector table copy in SRAM
  *  - system_gpio_init()
  *  - system_clock_init()
  *  - system_uart_init()
@@ -67,6 +125,22 @@ void system_deinit(void);
  */
 void system_jump_to_app(void);
 
+/**
+ * @brief Run an image in place from the W25Q128JV.
+ *
+ *  - system_deinit()
+ *  - PA.0 - PA.3 from QSPI0 to SPIM, direct map mode with the SPIM cache
+ *  - Change the vector table offset to the image in the SPIM window
+ *  - Set the MSP and jump to its Reset_Handler()
+ *
+ *  NOTE: Needs the flash on QSPI0, check w25q128jv_on_qspi() first, SPIM
+ *        does not reach the SPI2 pins. Returns without jumping on a SPI2
+ *        only build. Queued program and erase operations must be done.
+ *
+ * @param vectors vector table address, EXT_FLASH_XIP_BASE + flash address.
+ */
+void system_jump_to_xip(uint32_t vectors);
+
 /**
  * @brief Check whether the MCU is in "Prog" mode.
  * @return uint8_t
@@ -75,6 +149,30 @@ void system_jump_to_app(void);
  */
 uint8_t system_is_prog_mode(void);
 
+/**
+ * @brief Route the transfer done and abort interrupts of a PDMA channel.
+ *
+ * All channels share PDMA_IRQHandler(), it clears the flags of every channel
+ * that finished and calls their handlers. The PDMA interrupt is enabled by the
+ * first attach.
+ *
+ * @param ch PDMA channel, 0 to PDMA_CH_MAX - 1.
+ * @param handler called when the channel finished, NULL to detach.
+ */
+void system_pdma_attach(uint32_t ch, system_pdma_handler_t handler);
+
+/**
+ * @brief Get the system tick.
+ * @return uint32_t milliseconds since system_init(), wraps around.
+ */
+uint32_t system_get_tick(void);
+
+/**
+ * @brief Get a microsecond time stamp, from the system tick and SysTick.
+ * @return uint32_t microseconds since system_init(), wraps around.
+ */
+uint32_t system_get_us(void);
+
 /**
  * @brief Delay by polling.
  * @param uint32_t ms   delay times in millisecond.
@@ -6,16 +6,258 @@
  */
 
 #include "commuch.h"
+#include <string.h>
 #include "NuMicro.h"
+#include "boot_system.h"
+
+#define COM_RX_MASK (COM_CHANNEL_RX_BUFSIZE - 1)
+
+#if (COM_CHANNEL_RX_BUFSIZE & COM_RX_MASK)
+#error "COM_CHANNEL_RX_BUFSIZE must be a power of 2"
+#endif
+
+/* rx_head is only written by the ISR, rx_tail only by the reader. */
+static uint8_t rx_buf[COM_CHANNEL_RX_BUFSIZE];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+static volatile uint32_t rx_overruns;
+
+/* Receive armed by com_channel_read_async(), filled by the ISR. */
+static uint8_t *rx_dst;
+static uint32_t rx_dst_len;
+static volatile uint32_t rx_dst_left;
+
+static uint32_t line_baud = COM_CHANNEL_BAUD_DEFAULT;
+
+static volatile uint8_t tx_busy;
+static com_channel_done_t tx_done;
+
+/*******************************************************************************
+ * Interrupt Handler
+ ******************************************************************************/
+RAMFUNC void UART0_IRQHandler(void)
+{
+    uint32_t head = rx_head;
+    uint32_t left = rx_dst_left;
+
+    while (!UART_GET_RX_EMPTY(UART0)) {
+        uint8_t data = UART_READ(UART0);
+        if (left)  // the ring is empty, it was drained when armed
+            rx_dst[rx_dst_len - left--] = data;
+        else if (head - rx_tail < COM_CHANNEL_RX_BUFSIZE)
+            rx_buf[head++ & COM_RX_MASK] = data;
+        else
+            rx_overruns++;
+    }
+    __DMB();
+    rx_head = head;  // publish after the data is stored
+    rx_dst_left = left;
+
+    if (UART0->FIFOSTS & UART_FIFOSTS_RXOVIF_Msk) {
+        UART0->FIFOSTS = UART_FIFOSTS_RXOVIF_Msk;
+        rx_overruns++;
+    }
+}
+
+/* COM_CHANNEL_TX_PDMA_CH done or aborted, see system_pdma_attach() */
+static RAMFUNC void com_channel_tx_done(void)
+{
+    UART_PDMA_DISABLE(UART0, UART_INTEN_TXPDMAEN_Msk);
+    tx_busy = 0;
+    if (tx_done)
+        tx_done();
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void com_channel_init(void)
+{
+    NVIC_DisableIRQ(UART0_IRQn);
+    rx_head = 0;
+    rx_tail = 0;
+    rx_overruns = 0;
+    rx_dst_left = 0;
+    line_baud = COM_CHANNEL_BAUD_DEFAULT;
+
+    /* Interrupt at 8 bytes, the time-out picks up the rest of a burst */
+    UART0->FIFO = (UART0->FIFO & ~UART_FIFO_RFITL_Msk) | UART_FIFO_RFITL_8BYTES;
+    UART_SetTimeoutCnt(UART0, 40);
+    UART_ENABLE_INT(UART0, UART_INTEN_RDAIEN_Msk | UART_INTEN_RXTOIEN_Msk);
+    NVIC_EnableIRQ(UART0_IRQn);
+
+    /* PDMA channel for UART0 TX, re-armed by every com_channel_write_async() */
+    tx_busy = 0;
+    tx_done = NULL;
+    PDMA_Open(PDMA, 1UL << COM_CHANNEL_TX_PDMA_CH);
+    PDMA_EnableInt(PDMA, COM_CHANNEL_TX_PDMA_CH, PDMA_INT_TRANS_DONE);
+    system_pdma_attach(COM_CHANNEL_TX_PDMA_CH, com_channel_tx_done);
+}
+
+void com_channel_deinit(void)
+{
+    com_channel_flush();
+    PDMA_DisableInt(PDMA, COM_CHANNEL_TX_PDMA_CH, PDMA_INT_TRANS_DONE);
+    PDMA->CHCTL &= ~(1UL << COM_CHANNEL_TX_PDMA_CH);
+    system_pdma_attach(COM_CHANNEL_TX_PDMA_CH, NULL);
+
+    NVIC_DisableIRQ(UART0_IRQn);
+    UART_DISABLE_INT(UART0, UART_INTEN_RDAIEN_Msk | UART_INTEN_RXTOIEN_Msk |
+                                UART_INTEN_TOCNTEN_Msk);
+    NVIC_ClearPendingIRQ(UART0_IRQn);
+}
 
 void com_channel_putc(uint8_t data)
 {
+    com_channel_flush();  // keep the byte order
     UART_Write(UART0, &data, 1);
 }
 
+RAMFUNC void com_channel_write_async(const uint8_t *buf, uint32_t n,
+                             com_channel_done_t done)
+{
+    com_channel_flush();
+
+    if (n < COM_CHANNEL_TX_PDMA_MIN) {
+        if (n)
+            UART_Write(UART0, (uint8_t *) buf, n);
+        if (done)
+            done();
+        return;
+    }
+
+    tx_done = done;
+    tx_busy = 1;
+    PDMA_SetTransferCnt(PDMA, COM_CHANNEL_TX_PDMA_CH, PDMA_WIDTH_8, n);
+    PDMA_SetTransferAddr(PDMA, COM_CHANNEL_TX_PDMA_CH, (uint32_t) buf,
+                         PDMA_SAR_INC, (uint32_t) &UART0->DAT, PDMA_DAR_FIX);
+    PDMA_SetTransferMode(PDMA, COM_CHANNEL_TX_PDMA_CH, PDMA_UART0_TX, 0, 0);
+    PDMA_SetBurstType(PDMA, COM_CHANNEL_TX_PDMA_CH, PDMA_REQ_SINGLE, 0);
+    __DMB();  // the buffer is in memory before the PDMA reads it
+
+    /* UART0 requests a byte whenever the TX FIFO has room */
+    UART_PDMA_ENABLE(UART0, UART_INTEN_TXPDMAEN_Msk);
+}
+
+RAMFUNC void com_channel_write(const uint8_t *buf, uint32_t n)
+{
+    com_channel_write_async(buf, n, NULL);
+    com_channel_flush();
+}
+
+RAMFUNC void com_channel_flush(void)
+{
+    while (tx_busy)
+        ;
+}
+
 uint8_t com_channel_getc(void)
 {
-    uint8_t data;
-    UART_Read(UART0, &data, 1);
+    uint32_t tail = rx_tail;
+    while (rx_head == tail)
+        ;
+    __DMB();
+    uint8_t data = rx_buf[tail & COM_RX_MASK];
+    rx_tail = tail + 1;
     return data;
 }
+
+RAMFUNC uint32_t com_channel_read(uint8_t *buf, uint32_t n, uint32_t timeout_ms)
+{
+    uint32_t count = 0;
+    uint32_t tick = system_get_tick();
+
+    while (count < n) {
+        uint32_t tail = rx_tail;
+        uint32_t avail = rx_head - tail;
+
+        if (avail == 0) {
+            if (timeout_ms != COM_CHANNEL_WAIT_FOREVER &&
+                system_get_tick() - tick >= timeout_ms)
+                break;
+            continue;
+        }
+        __DMB();
+
+        // copy up to the end of the ring, the rest on the next pass
+        uint32_t ofs = tail & COM_RX_MASK;
+        if (avail > n - count)
+            avail = n - count;
+        if (avail > COM_CHANNEL_RX_BUFSIZE - ofs)
+            avail = COM_CHANNEL_RX_BUFSIZE - ofs;
+        memcpy(buf + count, rx_buf + ofs, avail);
+        rx_tail = tail + avail;
+        count += avail;
+        tick = system_get_tick();
+    }
+    return count;
+}
+
+RAMFUNC uint32_t com_channel_available(void)
+{
+    return rx_head - rx_tail;
+}
+
+RAMFUNC void com_channel_read_async(uint8_t *buf, uint32_t n)
+{
+    uint32_t count;
+
+    // the FIFO holds what arrives meanwhile, the order is kept
+    NVIC_DisableIRQ(UART0_IRQn);
+    count = com_channel_read(buf, n, 0);
+    rx_dst = buf;
+    rx_dst_len = n;
+    rx_dst_left = n - count;
+    NVIC_EnableIRQ(UART0_IRQn);
+}
+
+RAMFUNC uint32_t com_channel_read_wait(uint32_t timeout_ms)
+{
+    uint32_t left = rx_dst_left;
+    uint32_t tick = system_get_tick();
+
+    while (rx_dst_left) {
+        if (rx_dst_left != left) {
+            left = rx_dst_left;
+            tick = system_get_tick();
+        } else if (system_get_tick() - tick >= timeout_ms) {
+            break;
+        }
+    }
+
+    NVIC_DisableIRQ(UART0_IRQn);
+    left = rx_dst_left;
+    rx_dst_left = 0;
+    NVIC_EnableIRQ(UART0_IRQn);
+    __DMB();  // the ISR stores are visible before buf is read
+    return rx_dst_len - left;
+}
+
+void com_channel_set_baud(uint32_t baud)
+{
+    com_channel_flush();
+    UART_WAIT_TX_EMPTY(UART0);
+
+    NVIC_DisableIRQ(UART0_IRQn);
+    UART0->BAUD = UART_BAUD_MODE2 | (com_channel_baud_divisor(baud) - 2);
+
+    /* whatever arrived while both ends were switching is garbage */
+    UART0->FIFO |= UART_FIFO_RXRST_Msk;
+    while (UART0->FIFO & UART_FIFO_RXRST_Msk)
+        ;
+    rx_tail = rx_head;
+    rx_dst_left = 0;
+    NVIC_EnableIRQ(UART0_IRQn);
+
+    line_baud = baud;
+}
+
+uint32_t com_channel_get_baud(void)
+{
+    return line_baud;
+}
+
+uint32_t com_channel_overruns(void)
+{
+    return rx_overruns;
+}
@@ -3,6 +3,16 @@
  * @author cy023
  * @date 2023.03.20
  * @brief
+ *
+ * UART0 reception is interrupt driven: the RX ISR drains the hardware FIFO
+ * into a single-producer/single-consumer ring buffer, so bytes keep arriving
+ * while the bootloader is busy programming flash. A receive armed with
+ * com_channel_read_async() takes the bytes straight into the caller's buffer
+ * instead, once the ring is drained into it.
+ *
+ * UART0 transmission of whole buffers goes through a PDMA channel, the CPU
+ * only queues the transfer and is notified by the PDMA interrupt when the last
+ * byte has been handed to the TX FIFO.
  */
 
 #ifndef COMMUCH_H
@@ -10,16 +20,82 @@
 
 #include <stdint.h>
 
-// TODO:
+/**
+ * @brief Size of the receive ring buffer, must be a power of 2.
+ */
+#ifndef COM_CHANNEL_RX_BUFSIZE
+#define COM_CHANNEL_RX_BUFSIZE 2048
+#endif
+
+/**
+ * @brief UART0 clock, HXT with divider 1, see system_clock_init().
+ */
+#define COM_CHANNEL_UART_CLK 12000000UL
+
+/**
+ * @brief Line rate after reset.
+ */
+#define COM_CHANNEL_BAUD_DEFAULT 38400
+
+/**
+ * @brief PDMA channel used for UART0 transmission.
+ */
+#ifndef COM_CHANNEL_TX_PDMA_CH
+#define COM_CHANNEL_TX_PDMA_CH 0
+#endif
+
+/**
+ * @brief Shorter writes are copied straight into the TX FIFO, setting up the
+ *        PDMA costs more than they take.
+ */
+#ifndef COM_CHANNEL_TX_PDMA_MIN
+#define COM_CHANNEL_TX_PDMA_MIN 16
+#endif
+
+/**
+ * @brief Completion callback of com_channel_write_async().
+ *
+ *  NOTE: Called from the PDMA interrupt handler.
+ */
+typedef void (*com_channel_done_t)(void);
+
+/**
+ * @brief Timeout value of com_channel_read() that never expires.
+ */
+#define COM_CHANNEL_WAIT_FOREVER 0xFFFFFFFFUL
+
+/**
+ * @brief UART clock divisor (baud rate mode 2) closest to a baud rate.
+ *
+ * The line runs at COM_CHANNEL_UART_CLK / divisor, which equals the requested
+ * rate only when it divides the UART clock.
+ *
+ * @param baud requested baud rate, not 0.
+ * @return uint32_t divisor, BRD + 2.
+ */
+static inline uint32_t com_channel_baud_divisor(uint32_t baud)
+{
+    return (COM_CHANNEL_UART_CLK + baud / 2) / baud;
+}
+
 /**
  * @brief communication channel initialization.
+ *
+ *  - Reset the receive ring buffer
+ *  - Enable UART0 RX data available and RX time-out interrupts
+ *  - Enable the PDMA interrupt for UART0 transmission
+ *
+ *  NOTE: UART0 must be opened before, see system_uart0_init().
  */
-// void com_channel_init(void);
+void com_channel_init(void);
 
 /**
  * @brief communication channel deinitialization.
+ *
+ *  - Wait for a pending transmission
+ *  - Disable UART0 RX interrupts and the TX PDMA channel
  */
-// void com_channel_deinit(void);
+void com_channel_deinit(void);
 
 /**
  * @brief Send 1 byte data to communication channel.
@@ -28,6 +104,33 @@
  */
 void com_channel_putc(uint8_t data);
 
+/**
+ * @brief Start sending n bytes to communication channel by PDMA.
+ *
+ * Returns as soon as the transfer is queued, a previous one is waited for.
+ * The buffer must stay untouched until done is called or com_channel_flush()
+ * returns.
+ *
+ * @param buf the data to send.
+ * @param n number of bytes to send.
+ * @param done called when the transfer completes, may be NULL.
+ */
+void com_channel_write_async(const uint8_t *buf, uint32_t n,
+                             com_channel_done_t done);
+
+/**
+ * @brief Send n bytes to communication channel, wait for the transfer.
+ *
+ * @param buf the data to send.
+ * @param n number of bytes to send.
+ */
+void com_channel_write(const uint8_t *buf, uint32_t n);
+
+/**
+ * @brief Wait until a com_channel_write_async() transfer completes.
+ */
+void com_channel_flush(void);
+
 /**
  * @brief Receive 1 byte data from communication channel.
  *
@@ -35,4 +138,70 @@ void com_channel_putc(uint8_t data);
  */
 uint8_t com_channel_getc(void);
 
+/**
+ * @brief Receive up to n bytes from communication channel.
+ *
+ * @param buf buffer for the received data.
+ * @param n number of bytes to receive.
+ * @param timeout_ms give up when no more data arrives for this long,
+ *        COM_CHANNEL_WAIT_FOREVER to block until n bytes are received.
+ * @return uint32_t number of bytes received.
+ */
+uint32_t com_channel_read(uint8_t *buf, uint32_t n, uint32_t timeout_ms);
+
+/**
+ * @brief Get the number of received bytes not read yet.
+ *
+ * @return uint32_t bytes waiting in the receive ring buffer.
+ */
+uint32_t com_channel_available(void);
+
+/**
+ * @brief Start receiving n bytes into buf, in the background.
+ *
+ * The bytes waiting in the ring buffer are copied at once, the RX ISR stores
+ * the rest straight into buf. Later bytes go to the ring buffer again.
+ *
+ *  NOTE: Nothing else may read the channel until com_channel_read_wait().
+ *
+ * @param buf buffer for the received data.
+ * @param n number of bytes to receive.
+ */
+void com_channel_read_async(uint8_t *buf, uint32_t n);
+
+/**
+ * @brief Wait for a com_channel_read_async() receive.
+ *
+ * @param timeout_ms give up when no more data arrives for this long, the rest
+ *        of the receive is cancelled.
+ * @return uint32_t number of bytes received.
+ */
+uint32_t com_channel_read_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Switch the line rate.
+ *
+ * Waits until the pending transmission has left the shift register, so a
+ * reply sent before still goes out at the old rate. Bytes received during the
+ * switch are dropped.
+ *
+ * @param baud new baud rate, see com_channel_baud_divisor().
+ */
+void com_channel_set_baud(uint32_t baud);
+
+/**
+ * @brief Get the line rate set by com_channel_set_baud().
+ *
+ * @return uint32_t requested baud rate, COM_CHANNEL_BAUD_DEFAULT after
+ *         com_channel_init().
+ */
+uint32_t com_channel_get_baud(void);
+
+/**
+ * @brief Get the number of overrun bytes since com_channel_init().
+ *
+ * @return uint32_t bytes lost by the hardware FIFO or the ring buffer.
+ */
+uint32_t com_channel_overruns(void);
+
 #endif /* COMMUCH_H */
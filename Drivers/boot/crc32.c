@@ -0,0 +1,36 @@
+/**
+ * @file crc32.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief CRC-32 by the M480 CRC engine.
+ */
+
+#include "crc32.h"
+#include "NuMicro.h"
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint32_t crc32_update(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    /* SEED loads the raw engine register, undo CHKSFMT and CHKSREV of the
+     * previous result to continue from it */
+    CRC_Open(CRC_32, CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM,
+             __RBIT(~crc), CRC_CPU_WDATA_8);
+
+    while (len && ((uint32_t) buf & 3)) {
+        CRC_WRITE_DATA(*buf++);
+        len--;
+    }
+
+    /* DATREV reverses each byte, a word is fed as 4 bytes in memory order */
+    CRC->CTL = (CRC->CTL & ~CRC_CTL_DATLEN_Msk) | CRC_CPU_WDATA_32;
+    for (; len >= 4; len -= 4, buf += 4)
+        CRC_WRITE_DATA(*(const uint32_t *) buf);
+    CRC->CTL = (CRC->CTL & ~CRC_CTL_DATLEN_Msk) | CRC_CPU_WDATA_8;
+
+    while (len--)
+        CRC_WRITE_DATA(*buf++);
+
+    return CRC_GetChecksum();
+}
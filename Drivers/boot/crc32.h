@@ -0,0 +1,31 @@
+/**
+ * @file crc32.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief CRC-32 of the boot protocol v2 framing.
+ *
+ * CRC-32/ISO-HDLC (reflected polynomial 0xEDB88320, initial value and final
+ * XOR 0xFFFFFFFF), the same as zlib crc32(), so a programmer can use any
+ * stock implementation. The bootloader computes it with the CRC engine, the
+ * host build with a bit-exact software version.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+/**
+ * @brief Update a CRC-32 with more data.
+ *
+ * crc32_update(crc32_update(0, a, n), b, m) equals the CRC-32 of a and b
+ * concatenated.
+ *
+ * @param crc CRC-32 of the data so far, 0 to start.
+ * @param buf the data.
+ * @param len data length.
+ * @return uint32_t CRC-32 including buf.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif /* CRC32_H */
@@ -8,53 +8,162 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include "NuMicro.h"
+#include "boot_system.h"
 #include "commuch.h"
+#include "crc32.h"
 #include "device.h"
 
 /*******************************************************************************
  * Macro
  ******************************************************************************/
-#define BL_FLASH_PACSIZE (512U)
+#define BL_FLASH_PGSZ_DEFAULT (512U)
 
 #define FAILED    1
 #define SUCCESSED 0
 
+#define APP_PAGES   ((USER_APP_SIZE - USER_APP_START) / FMC_FLASH_PAGE_SIZE)
+#define BLOCK_PAGES 4  // FMC_Erase_Block()
+
+#if (USER_APP_START % (FMC_FLASH_PAGE_SIZE * BLOCK_PAGES))
+#error "USER_APP_START must be aligned to an erase block"
+#endif
+
+#if (BOOTLOADER_END >= APROM_BANK1_START)
+#error "the bootloader must run from bank 0 to program bank 1 while running"
+#endif
+
+static uint16_t flash_pgsz = BL_FLASH_PGSZ_DEFAULT;
+
+/* bit n: page n of the user app is still to be erased */
+static uint32_t erase_pending[(APP_PAGES + 31) / 32];
+static uint32_t erase_cursor;  // page following the last one written
+
+/*******************************************************************************
+ * Erase Scheduler
+ ******************************************************************************/
+static RAMFUNC uint8_t is_pending(uint32_t page)
+{
+    return page < APP_PAGES && ((erase_pending[page / 32] >> (page % 32)) & 1);
+}
+
+/**
+ * @brief Erase a pending page, together with its block in one trigger when
+ *        the whole block is pending. A page that fails stays pending.
+ */
+static RAMFUNC uint8_t erase_page(uint32_t page)
+{
+    uint32_t addr = USER_APP_START + page * FMC_FLASH_PAGE_SIZE;
+    uint32_t count = 1;
+
+    if (!(page % BLOCK_PAGES) && is_pending(page + 1) &&
+        is_pending(page + 2) && is_pending(page + 3)) {
+        if (FMC_Erase_Block(addr))
+            return FAILED;
+        count = BLOCK_PAGES;
+    } else if (FMC_Erase(addr)) {
+        return FAILED;
+    }
+
+    for (; count; count--, page++)
+        erase_pending[page / 32] &= ~(1UL << (page % 32));
+    return SUCCESSED;
+}
+
+/**
+ * @brief Erase the pending pages a range touches, before it is read or
+ *        programmed.
+ */
+static RAMFUNC uint8_t erase_range(uint32_t addr, uint32_t len)
+{
+    uint32_t end = addr + len;
+
+    if (end <= USER_APP_START || len == 0)
+        return SUCCESSED;
+    if (addr < USER_APP_START)
+        addr = USER_APP_START;
+
+    for (uint32_t page = (addr - USER_APP_START) / FMC_FLASH_PAGE_SIZE;
+         page < APP_PAGES &&
+         USER_APP_START + page * FMC_FLASH_PAGE_SIZE < end;
+         page++) {
+        if (is_pending(page) && erase_page(page))
+            return FAILED;
+    }
+    return SUCCESSED;
+}
+
 /*******************************************************************************
  * Public function
  ******************************************************************************/
 uint8_t flash_set_pgsz(uint16_t size)
 {
-    if (size != 512)  // TODO: only support 512 bytes now
+    if (size == 0 || (size % 256) || size > FMC_FLASH_PAGE_SIZE)
         return FAILED;
-    else
-        return SUCCESSED;
+    flash_pgsz = size;
+    return SUCCESSED;
 }
 
 uint16_t flash_get_pgsz(void)
 {
-    return BL_FLASH_PACSIZE;
+    return flash_pgsz;
 }
 
-uint8_t flash_write_app_page(const uint32_t dest, uint8_t *buf)
+RAMFUNC uint8_t flash_write_app(const uint32_t dest, const uint8_t *buf,
+                                uint32_t len)
 {
-    // TODO: FMC_WriteMultiple(0x00020000UL, (uint32_t *)page_buffer, BUFFSIZE);
-    for (uint32_t addr = dest, i = 0; i < BL_FLASH_PACSIZE;
-         addr += 4, i += 4) {
+    uint32_t i = 0;
+
+    if (erase_range(dest, len))
+        return FAILED;
+    if (dest >= USER_APP_START && len)
+        erase_cursor =
+            (dest + len - 1 - USER_APP_START) / FMC_FLASH_PAGE_SIZE + 1;
+
+    // Fast path: multi-word program, one ISP trigger per 512 bytes row. The
+    // BSP feeds 16 bytes before it looks at the length, so it only gets whole
+    // 16 byte units. An interrupt that holds up the data feed ends the burst
+    // inside a row; the BSP would count a whole row from there, so the rest
+    // of that row goes by double words and the next burst starts on a row.
+    if (!((uintptr_t) buf & 3) && !(dest % FMC_MULTI_WORD_PROG_LEN)) {
+        const uint32_t *words = (const uint32_t *) buf;
+        uint32_t mp = len & ~15UL;
+
+        while (i < mp) {
+            int32_t res = FMC_WriteMultiple(dest + i, (uint32_t *) (buf + i),
+                                            mp - i);
+            if (res <= 0 || (res % 8))
+                return FAILED;
+            for (i += res; (i % FMC_MULTI_WORD_PROG_LEN) && i < mp; i += 8) {
+                if (FMC_Write8Bytes(dest + i, words[i / 4], words[i / 4 + 1]))
+                    return FAILED;
+            }
+        }
+    }
+
+    // Unaligned buffer or the tail under 16 bytes: word by word
+    for (; i < len; i += 4) {
         uint32_t tmp = buf[i];
         tmp |= buf[i + 1] << 8;
         tmp |= buf[i + 2] << 16;
         tmp |= buf[i + 3] << 24;
-        if (FMC_Write(addr, tmp) != 0)
+        if (FMC_Write(dest + i, tmp) != 0)
             return FAILED;
     }
     return SUCCESSED;
 }
 
+RAMFUNC uint8_t flash_write_app_page(const uint32_t dest, uint8_t *buf)
+{
+    return flash_write_app(dest, buf, flash_pgsz);
+}
+
 uint8_t flash_read_app_page(const uint32_t src, uint8_t *buf)
 {
-    for (uint32_t addr = src, i = 0; i < BL_FLASH_PACSIZE;
-         addr += 4, i += 4) {
+    if (erase_range(src, flash_pgsz))
+        return FAILED;
+    for (uint32_t addr = src, i = 0; i < flash_pgsz; addr += 4, i += 4) {
         uint32_t res = FMC_Read(addr);
         buf[i + 0] = res & 0xFF;
         buf[i + 1] = (res >> 8) & 0xFF;
@@ -66,18 +175,89 @@ uint8_t flash_read_app_page(const uint32_t src, uint8_t *buf)
     return SUCCESSED;
 }
 
-uint8_t flash_verify_app_page(const uint32_t src, uint8_t *buf)
+uint8_t flash_read_app(const uint32_t src, uint8_t *buf, uint32_t len)
 {
-    uint32_t *pbuf32 = (uint32_t *) buf;
-    for (uint32_t addr = src, i = 0; i < BL_FLASH_PACSIZE;
-         addr += 4, i += 4) {
+    uint32_t addr = src & ~3UL;
+    uint32_t skip = src & 3UL;
+
+    if (src < USER_APP_START || src + len > USER_APP_SIZE || src + len < src ||
+        erase_range(src, len))
+        return FAILED;
+
+    while (len) {
+        uint32_t res = FMC_Read(addr) >> (skip * 8);
+        if (g_FMC_i32ErrCode != 0)
+            return FAILED;
+        for (; skip < 4 && len; skip++, len--) {
+            *buf++ = res & 0xFF;
+            res >>= 8;
+        }
+        addr += 4;
+        skip = 0;
+    }
+    return SUCCESSED;
+}
+
+uint8_t flash_verify_app(const uint32_t src, const uint8_t *buf, uint32_t len)
+{
+    if (erase_range(src, len))
+        return FAILED;
+    for (uint32_t addr = src, i = 0; i < len; addr += 4, i += 4) {
         uint32_t res = FMC_Read(addr);
-        if (res != pbuf32[i / 4] || g_FMC_i32ErrCode != 0)
+        uint32_t tmp = buf[i];
+        tmp |= buf[i + 1] << 8;
+        tmp |= buf[i + 2] << 16;
+        tmp |= (uint32_t) buf[i + 3] << 24;
+        if (res != tmp || g_FMC_i32ErrCode != 0)
             return FAILED;
     }
     return SUCCESSED;
 }
 
+uint8_t flash_verify_app_page(const uint32_t src, uint8_t *buf)
+{
+    return flash_verify_app(src, buf, flash_pgsz);
+}
+
+/*
+ * The ISP checksum engine (FMC_ISPCMD_RUN_CKS) runs CRC-32 over whole FMC
+ * pages: polynomial 04C11DB7h, seed FFFFFFFFh, the bits of every byte
+ * reflected on the way in, the result reflected and complemented. It is the
+ * CRC peripheral set to CRC_32, CRC_WDATA_RVS | CRC_CHECKSUM_RVS |
+ * CRC_CHECKSUM_COM and seed 0xFFFFFFFF, which the BSP FMC_CRC32 sample checks
+ * it against, and so CRC-32/ISO-HDLC, zlib crc32(). Start and length need
+ * 4 KiB alignment (ISPADDR, ISPDAT in fmc_reg.h), FMC_GetChkSum() only checks
+ * 512 and reads back 0 for anything else.
+ */
+#define FMC_CKS_ALIGN FMC_FLASH_PAGE_SIZE
+
+uint8_t flash_checksum_app(const uint32_t src, uint32_t len, uint32_t *crc)
+{
+    uint32_t words[32];
+
+    if (src < USER_APP_START || src + len > USER_APP_SIZE || src + len < src ||
+        len == 0 || ((src | len) & 511) || erase_range(src, len))
+        return FAILED;
+
+    if (!((src | len) & (FMC_CKS_ALIGN - 1))) {
+        // 0xFFFFFFFF is a valid checksum as well, the error code tells
+        *crc = FMC_GetChkSum(src, len);
+        return (g_FMC_i32ErrCode != 0) ? FAILED : SUCCESSED;
+    }
+
+    // part of a page, the CPU reads it into the CRC engine instead
+    *crc = 0;
+    for (uint32_t addr = src; addr < src + len; addr += sizeof(words)) {
+        for (uint32_t i = 0; i < 32; i++) {
+            words[i] = FMC_Read(addr + i * 4);
+            if (g_FMC_i32ErrCode != 0)
+                return FAILED;
+        }
+        *crc = crc32_update(*crc, (const uint8_t *) words, sizeof(words));
+    }
+    return SUCCESSED;
+}
+
 // uint8_t flash_erase_sector(uint8_t sector_num)
 // {
 //     // TODO:
@@ -87,6 +267,18 @@ uint8_t flash_verify_app_page(const uint32_t src, uint8_t *buf)
 //     return 0;
 // }
 
+uint8_t flash_erase_app_page(const uint32_t addr)
+{
+    uint32_t page = (addr - USER_APP_START) / FMC_FLASH_PAGE_SIZE;
+
+    if (addr < USER_APP_START || addr > USER_APP_END)
+        return FAILED;
+    if (FMC_Erase(addr & ~(FMC_FLASH_PAGE_SIZE - 1)))
+        return FAILED;
+    erase_pending[page / 32] &= ~(1UL << (page % 32));
+    return SUCCESSED;
+}
+
 uint8_t flash_erase_app_all(void)
 {
     uint8_t res = 0;
@@ -94,5 +286,41 @@ uint8_t flash_erase_app_all(void)
          addr += (FMC_FLASH_PAGE_SIZE << 2))
         res |= FMC_Erase_Block(addr);  // erase 4 pages
     // TODO: res |= FMC_Erase(addr);
+    if (!res)
+        memset(erase_pending, 0, sizeof(erase_pending));
     return res;
 }
+
+uint8_t flash_erase_app_defer(const uint32_t addr, uint32_t len)
+{
+    uint32_t page = (addr - USER_APP_START) / FMC_FLASH_PAGE_SIZE;
+    uint32_t end = addr + len;
+
+    if (addr < USER_APP_START || len == 0 || end > USER_APP_SIZE ||
+        end < addr || (addr | len) & (FMC_FLASH_PAGE_SIZE - 1))
+        return FAILED;
+
+    erase_cursor = page;
+    for (; len; len -= FMC_FLASH_PAGE_SIZE, page++)
+        erase_pending[page / 32] |= 1UL << (page % 32);
+
+    // bank 0 stalls the bootloader, better now than while packets arrive
+    if (end > APROM_BANK1_START)
+        end = APROM_BANK1_START;
+    if (addr < end)
+        return erase_range(addr, end - addr);
+    return SUCCESSED;
+}
+
+uint8_t flash_erase_ahead(void)
+{
+    // only bank 1 pages are left pending, erased while the RX ISR runs
+    if (!is_pending(erase_cursor))
+        return SUCCESSED;
+    return erase_page(erase_cursor);
+}
+
+uint8_t flash_erase_flush(void)
+{
+    return erase_range(USER_APP_START, USER_APP_SIZE - USER_APP_START);
+}
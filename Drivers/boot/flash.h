@@ -5,6 +5,16 @@
  * @brief
  *
  * The API only supports for address in User App Section.
+ *
+ * Erasing can be deferred: flash_erase_app_defer() only marks the FMC pages of
+ * a range in a bitmap. A pending page is erased just before it is first
+ * programmed or read, or earlier by flash_erase_ahead() while the programmer
+ * is still sending.
+ *
+ * The scheduler knows the two APROM banks, see device.h. Only bank 1 pages
+ * are deferred, erasing them leaves the bootloader running in bank 0. Bank 0
+ * pages are erased at once, while the programmer waits for the reply and
+ * nothing is on the line.
  */
 
 #ifndef FLASH_H
@@ -13,8 +23,9 @@
 #include <stdint.h>
 
 /**
- * @brief Set the flash page size.
- * @param size the size to set. should be 256 * N.
+ * @brief Set the flash page size, the unit of the *_page() functions.
+ * @param size the size to set, 256 * N up to FMC_FLASH_PAGE_SIZE. 512 after
+ *        reset.
  * @return uint8_t
  *      0: successed.
  *      1: failed.
@@ -27,6 +38,17 @@ uint8_t flash_set_pgsz(uint16_t size);
  */
 uint16_t flash_get_pgsz(void);
 
+/**
+ * @brief Write a buffer of any length to flash.
+ * @param dest byte address, multiple of 4.
+ * @param buf the data, word aligned for the fast multi-word program.
+ * @param len number of bytes, multiple of 4.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed.
+ */
+uint8_t flash_write_app(const uint32_t dest, const uint8_t *buf, uint32_t len);
+
 /**
  * @brief Write page buffer to flash page.
  * @param page_addr byte address of the flash page to read.
@@ -47,6 +69,28 @@ uint8_t flash_write_app_page(const uint32_t dest, uint8_t *buf);
  */
 uint8_t flash_read_app_page(const uint32_t src, uint8_t *buf);
 
+/**
+ * @brief Read any byte range of the user app section.
+ * @param src byte address, no alignment needed.
+ * @param buf buffer for the data.
+ * @param len number of bytes to read.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, the range is not inside the user app section.
+ */
+uint8_t flash_read_app(const uint32_t src, uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Verify the flash is the same as a buffer of any length.
+ * @param src byte address, multiple of 4.
+ * @param buf the data to compare with.
+ * @param len number of bytes, multiple of 4.
+ * @return uint8_t
+ *      0: the flash is the same with buf.
+ *      1: the flash is different from buf.
+ */
+uint8_t flash_verify_app(const uint32_t src, const uint8_t *buf, uint32_t len);
+
 /**
  * @brief Verify the flash page is the same as page buf.
  * @param page_addr byte address of the flash page to verify.
@@ -57,6 +101,20 @@ uint8_t flash_read_app_page(const uint32_t src, uint8_t *buf);
  */
 uint8_t flash_verify_app_page(const uint32_t src, uint8_t *buf);
 
+/**
+ * @brief CRC-32 of a user app range, calculated by the FMC checksum engine
+ *        for whole FMC pages, read by the CPU otherwise.
+ * @param src byte address, multiple of 512.
+ * @param len number of bytes, multiple of 512.
+ * @param crc the checksum, zlib crc32() of the range, see FMC_CKS_ALIGN in
+ *            flash.c; test_04_flash checks that against crc32_update() on
+ *            the board.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed.
+ */
+uint8_t flash_checksum_app(const uint32_t src, uint32_t len, uint32_t *crc);
+
 /**
  * @brief Erase the assigned flash section.
  * @param sector_num the num of flash section to clear.
@@ -66,6 +124,15 @@ uint8_t flash_verify_app_page(const uint32_t src, uint8_t *buf);
  */
 // uint8_t flash_erase_sector(uint8_t sector_num);
 
+/**
+ * @brief Erase the FMC page (FMC_FLASH_PAGE_SIZE) holding addr.
+ * @param addr any byte address in the user app section.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed.
+ */
+uint8_t flash_erase_app_page(const uint32_t addr);
+
 /**
  * @brief Erase all space of user app flash.
  * @return uint8_t
@@ -74,4 +141,33 @@ uint8_t flash_verify_app_page(const uint32_t src, uint8_t *buf);
  */
 uint8_t flash_erase_app_all(void);
 
+/**
+ * @brief Schedule the FMC pages of a range for erasing. Those in bank 0 are
+ *        erased before this returns, the others are deferred.
+ * @param addr byte address, multiple of FMC_FLASH_PAGE_SIZE.
+ * @param len number of bytes, multiple of FMC_FLASH_PAGE_SIZE.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, the range is not inside the user app section or a bank 0
+ *         page failed to erase.
+ */
+uint8_t flash_erase_app_defer(const uint32_t addr, uint32_t len);
+
+/**
+ * @brief Erase the page after the last one written, if it is pending. The
+ *        whole block goes in one go when it is pending as well.
+ * @return uint8_t
+ *      0: successed, or nothing to erase.
+ *      1: failed, the page stays pending.
+ */
+uint8_t flash_erase_ahead(void);
+
+/**
+ * @brief Erase every pending page.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed.
+ */
+uint8_t flash_erase_flush(void);
+
 #endif /* FLASH_H */
@@ -0,0 +1,79 @@
+/**
+ * @file sha256_dma.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief SHA-256 by the M480 CRPT engine in DMA cascade mode.
+ */
+
+#include "sha256_dma.h"
+#include <string.h>
+#include "NuMicro.h"
+
+/*******************************************************************************
+ * Macro
+ ******************************************************************************/
+#define FAILED    1
+#define SUCCESSED 0
+
+static uint8_t sha256_dma_first;  // the next part opens the cascade
+static uint8_t sha256_dma_held;   // a digest is between start and digest
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint8_t sha256_dma_start(void)
+{
+    if (sha256_dma_held)
+        return FAILED;
+    sha256_dma_held = 1;
+
+    /* INSWAP feeds the words in memory order, OUTSWAP leaves the digest
+     * registers in the byte order of the standard */
+    SHA_Open(CRPT, SHA_MODE_SHA256, SHA_IN_OUT_SWAP, 0);
+    SHA_CLR_INT_FLAG(CRPT);
+    sha256_dma_first = 1;
+    return SUCCESSED;
+}
+
+void sha256_dma_update(const uint8_t *buf, uint32_t len, uint8_t last)
+{
+    uint32_t mode;
+
+    if (sha256_dma_first)
+        mode = last ? CRYPTO_DMA_ONE_SHOT : CRYPTO_DMA_FIRST;
+    else
+        mode = last ? CRYPTO_DMA_LAST : CRYPTO_DMA_CONTINUE;
+    sha256_dma_first = 0;
+
+    SHA_SetDMATransfer(CRPT, (uint32_t) buf, len);
+    __DMB();  // the part is in memory before the engine fetches it
+    SHA_Start(CRPT, mode);
+}
+
+uint8_t sha256_dma_wait(void)
+{
+    uint32_t flags;
+
+    while (!(flags = SHA_GET_INT_FLAG(CRPT)))
+        ;
+    SHA_CLR_INT_FLAG(CRPT);
+
+    if ((flags & CRPT_INTSTS_HMACEIF_Msk) ||
+        (CRPT->HMAC_STS & CRPT_HMAC_STS_DMAERR_Msk))
+        return FAILED;
+    return SUCCESSED;
+}
+
+void sha256_dma_digest(uint8_t digest[32])
+{
+    uint32_t words[8];
+
+    SHA_Read(CRPT, words);
+    memcpy(digest, words, sizeof(words));
+    sha256_dma_held = 0;
+}
+
+void sha256_dma_stop(void)
+{
+    sha256_dma_held = 0;
+}
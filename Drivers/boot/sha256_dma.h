@@ -0,0 +1,63 @@
+/**
+ * @file sha256_dma.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief SHA-256 of data streaming through SRAM, by the CRPT engine.
+ *
+ * The engine fetches every part by its own DMA, in a cascade from the first
+ * part to the last, while the CPU goes on. A part has to stay in place until
+ * sha256_dma_wait() returns. The bootloader uses the M480 CRPT engine, the
+ * host build a software version giving the same digest.
+ *
+ * One digest holds the engine at a time, from sha256_dma_start() to
+ * sha256_dma_digest() or sha256_dma_stop(). mbedtls (sha256_alt.c) claims it
+ * the same way, so neither user can break into the other's cascade.
+ */
+
+#ifndef SHA256_DMA_H
+#define SHA256_DMA_H
+
+#include <stdint.h>
+
+/**
+ * @brief Every part but the last is a multiple of the SHA-256 block.
+ */
+#define SHA256_DMA_BLOCK 64
+
+/**
+ * @brief Claim the engine and start a new digest.
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, another digest holds the engine.
+ */
+uint8_t sha256_dma_start(void);
+
+/**
+ * @brief Start hashing the next part, returns before it is done.
+ * @param buf the part, word aligned, left alone until sha256_dma_wait().
+ * @param len part length, a multiple of SHA256_DMA_BLOCK unless last.
+ * @param last 1 for the last part of the data.
+ */
+void sha256_dma_update(const uint8_t *buf, uint32_t len, uint8_t last);
+
+/**
+ * @brief Wait for the part started by sha256_dma_update().
+ * @return uint8_t
+ *      0: successed.
+ *      1: failed, DMA error.
+ */
+uint8_t sha256_dma_wait(void);
+
+/**
+ * @brief The digest, once the last part is done. Frees the engine.
+ * @param digest 32 bytes, in the byte order of the SHA-256 standard.
+ */
+void sha256_dma_digest(uint8_t digest[32]);
+
+/**
+ * @brief Drop the digest unfinished and free the engine, no part may be
+ *        running.
+ */
+void sha256_dma_stop(void);
+
+#endif /* SHA256_DMA_H */
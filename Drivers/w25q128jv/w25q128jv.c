@@ -11,6 +11,7 @@
 #include "w25q128jv.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "NuMicro.h"
 #include "boot_system.h"
 
@@ -93,22 +94,103 @@
  */
 #define W25Q128JV_DUMMY_BYTE 0x00
 
+/**
+ * @brief JEDEC ID of the W25Q128JV-IQ/JQ, manufacturer EFh, device 4018h
+ *          ref: w25q128jv datasheet, Read JEDEC ID (9Fh)
+ */
+#define W25Q128JV_JEDEC 0xEF4018
+
 #define SUCCESSED 1
 #define FAILED    0
 
+/**
+ * @brief Status Register-2 Quad Enable, /WP and /HOLD become IO2 and IO3
+ *          ref: w25q128jv datasheet 7.1.4
+ */
+#define W25Q128JV_SR2_QE 0x02
+
+/**
+ * @brief Status Register-2 Suspend Status, set by Erase/Program Suspend (75h)
+ *          ref: w25q128jv datasheet 7.1.10
+ */
+#define W25Q128JV_SR2_SUS 0x80
+
+/* Minimum time from a resume to the next suspend, datasheet 9.6 tSUS */
+#define W25Q128JV_T_SUS_US 20
+
 /*******************************************************************************
  * Porting Layer
  ******************************************************************************/
+/**
+ * @brief Port the flash answers on, probed before the first instruction with
+ *        BOOT_SPI_FLASH_AUTO, see w25q128jv_probe_port().
+ */
+static enum {
+    W25Q128JV_PORT_UNKNOWN = 0,
+    W25Q128JV_PORT_SPI2,
+    W25Q128JV_PORT_QSPI0
+} flash_port;
+
+/* q on QSPI0, s on SPI2, a single port build expands only its own */
+#if BOOT_SPI_FLASH_QSPI == BOOT_SPI_FLASH_AUTO
+#define FLASH_ON_QSPI    (flash_port == W25Q128JV_PORT_QSPI0)
+#define FLASH_PORT(q, s) (FLASH_ON_QSPI ? (q) : (s))
+#define FLASH_DO(q, s)   (FLASH_ON_QSPI ? (void) (q) : (void) (s))
+#elif BOOT_SPI_FLASH_HAS_QSPI0
+#define FLASH_ON_QSPI    1
+#define FLASH_PORT(q, s) (q)
+#define FLASH_DO(q, s)   ((void) (q))
+#else
+#define FLASH_ON_QSPI    0
+#define FLASH_PORT(q, s) (s)
+#define FLASH_DO(q, s)   ((void) (s))
+#endif
+
+#define FLASH_WRITE_TX(data)                                                   \
+    FLASH_DO(QSPI_WRITE_TX(QSPI_FLASH_PORT, (data)),                           \
+             SPI_WRITE_TX(SPI_FLASH_PORT, (data)))
+#define FLASH_READ_RX()                                                        \
+    FLASH_PORT(QSPI_READ_RX(QSPI_FLASH_PORT), SPI_READ_RX(SPI_FLASH_PORT))
+#define FLASH_IS_BUSY()                                                        \
+    FLASH_PORT(QSPI_IS_BUSY(QSPI_FLASH_PORT), SPI_IS_BUSY(SPI_FLASH_PORT))
+#define FLASH_SS_LOW()                                                         \
+    FLASH_DO(QSPI_SET_SS_LOW(QSPI_FLASH_PORT), SPI_SET_SS_LOW(SPI_FLASH_PORT))
+#define FLASH_SS_HIGH()                                                        \
+    FLASH_DO(QSPI_SET_SS_HIGH(QSPI_FLASH_PORT), SPI_SET_SS_HIGH(SPI_FLASH_PORT))
+#define FLASH_QUAD_OUTPUT()                                                    \
+    FLASH_DO(QSPI_ENABLE_QUAD_OUTPUT_MODE(QSPI_FLASH_PORT), 0)
+#define FLASH_QUAD_INPUT()                                                     \
+    FLASH_DO(QSPI_ENABLE_QUAD_INPUT_MODE(QSPI_FLASH_PORT), 0)
+#define FLASH_SINGLE() FLASH_DO(QSPI_DISABLE_QUAD_MODE(QSPI_FLASH_PORT), 0)
+#define FLASH_QUAD_CAPABLE (FLASH_ON_QSPI && BOOT_SPI_FLASH_QUAD)
+#define FLASH_TX_REG       FLASH_PORT(&QSPI_FLASH_PORT->TX, &SPI_FLASH_PORT->TX)
+#define FLASH_RX_REG       FLASH_PORT(&QSPI_FLASH_PORT->RX, &SPI_FLASH_PORT->RX)
+#define FLASH_PDMA_TX      FLASH_PORT(PDMA_QSPI0_TX, PDMA_SPI2_TX)
+#define FLASH_PDMA_RX      FLASH_PORT(PDMA_QSPI0_RX, PDMA_SPI2_RX)
+#define FLASH_PDMA_TRIGGER()                                                   \
+    FLASH_DO(QSPI_TRIGGER_TX_RX_PDMA(QSPI_FLASH_PORT),                         \
+             SPI_TRIGGER_TX_RX_PDMA(SPI_FLASH_PORT))
+#define FLASH_PDMA_DISABLE()                                                   \
+    FLASH_DO(QSPI_DISABLE_TX_RX_PDMA(QSPI_FLASH_PORT),                         \
+             SPI_DISABLE_TX_RX_PDMA(SPI_FLASH_PORT))
+
+/**
+ * @brief Largest PDMA transfer, 14-bit transfer count.
+ */
+#define W25Q128JV_PDMA_MAX (16384)
+
 /**
  * @brief For SPI data swap
  *
+ *  NOTE: In quad mode one byte takes 2 clocks on IO0-IO3, the data direction
+ *        is set by w25q128jv_quad_output() / w25q128jv_quad_input().
  */
 static uint8_t w25q128jv_spi(uint8_t data)
 {
-    SPI_WRITE_TX(SPI_FLASH_PORT, data);
-    while (SPI_IS_BUSY(SPI_FLASH_PORT))
+    FLASH_WRITE_TX(data);
+    while (FLASH_IS_BUSY())
         ;  // wait tx finish
-    return SPI_READ_RX(SPI_FLASH_PORT) & 0xFF;
+    return FLASH_READ_RX() & 0xFF;
 }
 
 /**
@@ -117,16 +199,148 @@ static uint8_t w25q128jv_spi(uint8_t data)
  */
 static inline void __w25q128jv_CS_ENABLE(void)
 {
-    SPI_SET_SS_LOW(SPI_FLASH_PORT);
+    if (flash_port == W25Q128JV_PORT_UNKNOWN)
+        w25q128jv_probe_port();
+    FLASH_SS_LOW();
 }
 
 /**
- * @brief For SPI /CS pin disable
+ * @brief For SPI /CS pin disable, back to single SPI for the next instruction
  *
  */
 static inline void __w25q128jv_CS_DISABLE(void)
 {
-    SPI_SET_SS_HIGH(SPI_FLASH_PORT);
+    FLASH_SS_HIGH();
+    FLASH_SINGLE();
+}
+
+/**
+ * @brief Drive IO0-IO3 for the rest of the instruction
+ *
+ */
+static inline void w25q128jv_quad_output(void)
+{
+    FLASH_QUAD_OUTPUT();
+}
+
+/**
+ * @brief Sample IO0-IO3 for the rest of the instruction
+ *
+ */
+static inline void w25q128jv_quad_input(void)
+{
+    FLASH_QUAD_INPUT();
+}
+
+/*******************************************************************************
+ * PDMA
+ ******************************************************************************/
+static volatile uint8_t pdma_busy;
+static uint8_t pdma_ready;
+
+/**
+ * @brief W25Q128JV_PDMA_RX_CH done, see system_pdma_attach().
+ *
+ *  NOTE: The TX channel finished before, its interrupt is not enabled.
+ */
+static void w25q128jv_pdma_done(void)
+{
+    FLASH_PDMA_DISABLE();
+    pdma_busy = 0;
+}
+
+static void w25q128jv_pdma_open(void)
+{
+    if (pdma_ready)
+        return;
+    pdma_ready = 1;
+    PDMA_Open(PDMA,
+              (1UL << W25Q128JV_PDMA_TX_CH) | (1UL << W25Q128JV_PDMA_RX_CH));
+    PDMA_EnableInt(PDMA, W25Q128JV_PDMA_RX_CH, PDMA_INT_TRANS_DONE);
+    system_pdma_attach(W25Q128JV_PDMA_RX_CH, w25q128jv_pdma_done);
+}
+
+/**
+ * @brief Start a data phase of the current instruction, PDMA_MAX bytes at most.
+ *
+ *  Both channels run in either direction: the master only clocks what the TX
+ *  channel writes, and the RX channel completes once the last byte has been
+ *  shifted, where the TX channel completes when it entered the FIFO. Phases
+ *  shorter than W25Q128JV_PDMA_MIN are polled and done on return.
+ *
+ * @param tx bytes to send, NULL for dummy bytes.
+ * @param rx buffer for the received bytes, NULL to drop them.
+ * @param bytes length of the data phase.
+ */
+static void w25q128jv_data_start(const uint8_t *tx, uint8_t *rx, uint32_t bytes)
+{
+    static const uint8_t dummy_tx = W25Q128JV_DUMMY_BYTE;
+    static uint8_t dummy_rx;
+
+    if (bytes < W25Q128JV_PDMA_MIN) {
+        for (uint32_t i = 0; i < bytes; i++) {
+            uint8_t data = w25q128jv_spi(tx ? tx[i] : W25Q128JV_DUMMY_BYTE);
+            if (rx)
+                rx[i] = data;
+        }
+        return;
+    }
+
+    w25q128jv_pdma_open();
+    PDMA_SetTransferCnt(PDMA, W25Q128JV_PDMA_TX_CH, PDMA_WIDTH_8, bytes);
+    PDMA_SetTransferAddr(PDMA, W25Q128JV_PDMA_TX_CH,
+                         (uintptr_t) (tx ? tx : &dummy_tx),
+                         tx ? PDMA_SAR_INC : PDMA_SAR_FIX,
+                         (uintptr_t) FLASH_TX_REG, PDMA_DAR_FIX);
+    PDMA_SetTransferMode(PDMA, W25Q128JV_PDMA_TX_CH, FLASH_PDMA_TX, 0, 0);
+    PDMA_SetBurstType(PDMA, W25Q128JV_PDMA_TX_CH, PDMA_REQ_SINGLE, 0);
+
+    PDMA_SetTransferCnt(PDMA, W25Q128JV_PDMA_RX_CH, PDMA_WIDTH_8, bytes);
+    PDMA_SetTransferAddr(PDMA, W25Q128JV_PDMA_RX_CH,
+                         (uintptr_t) FLASH_RX_REG, PDMA_SAR_FIX,
+                         (uintptr_t) (rx ? rx : &dummy_rx),
+                         rx ? PDMA_DAR_INC : PDMA_DAR_FIX);
+    PDMA_SetTransferMode(PDMA, W25Q128JV_PDMA_RX_CH, FLASH_PDMA_RX, 0, 0);
+    PDMA_SetBurstType(PDMA, W25Q128JV_PDMA_RX_CH, PDMA_REQ_SINGLE, 0);
+
+    pdma_busy = 1;
+    __DMB();  // the buffer is in memory before the PDMA reads it
+    FLASH_PDMA_TRIGGER();
+}
+
+/**
+ * @brief Wait for the data phase started by w25q128jv_data_start().
+ */
+static void w25q128jv_data_wait(void)
+{
+    /* Sleep until the RX channel interrupt. With PRIMASK set a pending
+     * interrupt still ends __WFI(), it is taken when re-enabled. */
+    __disable_irq();
+    while (pdma_busy) {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+}
+
+/**
+ * @brief Data phase of the current instruction, any length.
+ * @param tx bytes to send, NULL for dummy bytes.
+ * @param rx buffer for the received bytes, NULL to drop them.
+ * @param bytes length of the data phase.
+ */
+static void w25q128jv_data(const uint8_t *tx, uint8_t *rx, uint32_t bytes)
+{
+    while (bytes) {
+        uint32_t n = (bytes < W25Q128JV_PDMA_MAX) ? bytes : W25Q128JV_PDMA_MAX;
+
+        w25q128jv_data_start(tx, rx, n);
+        w25q128jv_data_wait();
+        tx = tx ? tx + n : NULL;
+        rx = rx ? rx + n : NULL;
+        bytes -= n;
+    }
 }
 
 /*******************************************************************************
@@ -155,6 +369,226 @@ static inline void w25q128jv_wait_for_busy(void)
     __w25q128jv_CS_DISABLE();
 }
 
+/**
+ * @brief Data phase width, probed from the QE bit before the first read or
+ *        program. Single SPI on SPI2, or with QE clear.
+ */
+static enum {
+    W25Q128JV_IO_UNKNOWN = 0,
+    W25Q128JV_IO_SINGLE,
+    W25Q128JV_IO_QUAD
+} io_mode;
+
+static inline uint8_t w25q128jv_quad(void)
+{
+    if (io_mode == W25Q128JV_IO_UNKNOWN)
+        w25q128jv_probe_quad();
+    return io_mode == W25Q128JV_IO_QUAD;
+}
+
+static inline void w25q128jv_send_addr(uint32_t addr)
+{
+    w25q128jv_spi((addr & 0xFF0000) >> 16);
+    w25q128jv_spi((addr & 0xFF00) >> 8);
+    w25q128jv_spi(addr & 0xFF);
+}
+
+/**
+ * @brief Select the flash and start a read at addr, the data follows until
+ *        /CS goes high. The flash reads on across pages, sectors and blocks.
+ *
+ *  - single : Fast Read (0Bh), 1 dummy byte.
+ *  - quad   : Fast Read Quad I/O (EBh), the address and M7-0 on IO0-IO3,
+ *             M5-4 != 10b so no continuous read mode, 4 dummy clocks.
+ */
+static void w25q128jv_read_start(uint32_t addr)
+{
+    uint8_t quad = w25q128jv_quad();  // may probe, before /CS goes low
+
+    __w25q128jv_CS_ENABLE();
+    if (quad) {
+        w25q128jv_spi(W25Q128JV_FAST_READ_QUAD_IO);
+        w25q128jv_quad_output();
+        w25q128jv_send_addr(addr);
+        w25q128jv_spi(0xFF);  // M7-0
+        w25q128jv_quad_input();
+        w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
+        w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
+    } else {
+        w25q128jv_spi(W25Q128JV_FAST_READ);
+        w25q128jv_send_addr(addr);
+        w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
+    }
+}
+
+/*******************************************************************************
+ * Program/Erase Queue
+ ******************************************************************************/
+/**
+ * @brief A program or erase waiting for the flash, the program data copied in.
+ */
+struct w25q128jv_op {
+    uint8_t cmd;
+    uint16_t bytes;  // program length
+    uint32_t addr;
+    uint8_t data[W25Q128JV_PAGE_SIZE];
+};
+
+static struct w25q128jv_op op_queue[W25Q128JV_QUEUE_DEPTH];
+static uint8_t op_head;
+static uint8_t op_count;
+static uint8_t op_active;  // op_queue[op_head] started on the flash
+static uint8_t op_resumed; // op_queue[op_head] resumed at resume_us
+static uint32_t resume_us;
+
+static uint8_t w25q128jv_read_sr(uint8_t cmd)
+{
+    uint8_t sr;
+
+    __w25q128jv_CS_ENABLE();
+    w25q128jv_spi(cmd);
+    sr = w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
+    __w25q128jv_CS_DISABLE();
+    return sr;
+}
+
+static inline uint8_t w25q128jv_busy(void)
+{
+    return w25q128jv_read_sr(W25Q128JV_READ_STATUS_REG1) & 0x01;
+}
+
+/**
+ * @brief Send the queued operation, the flash works on it after /CS is high.
+ *
+ *  - program : Page Program (02h), or Quad Input Page Program (32h) with the
+ *              data on IO0-IO3.
+ *  - erase   : Sector Erase (20h) or Block Erase (D8h).
+ */
+static void w25q128jv_op_start(const struct w25q128jv_op *op)
+{
+    uint8_t cmd = op->cmd;
+    uint8_t quad = 0;
+
+    if (cmd == W25Q128JV_PAGE_PROGRAM) {
+        quad = w25q128jv_quad();
+        if (quad)
+            cmd = W25Q128JV_QUAD_INPUT_PAGE_PROGRAM;
+    }
+
+    op_resumed = 0;
+    w25q128jv_write_enable();
+    __w25q128jv_CS_ENABLE();
+    w25q128jv_spi(cmd);
+    w25q128jv_send_addr(op->addr);
+    if (quad)
+        w25q128jv_quad_output();
+    if (op->bytes)
+        w25q128jv_data(op->data, NULL, op->bytes);
+    __w25q128jv_CS_DISABLE();
+}
+
+/**
+ * @brief Take the next free slot, waiting for the flash while they are all
+ *        taken. w25q128jv_poll() starts it.
+ */
+static struct w25q128jv_op *w25q128jv_op_alloc(uint8_t cmd, uint32_t addr)
+{
+    struct w25q128jv_op *op;
+
+    while (op_count == W25Q128JV_QUEUE_DEPTH)
+        w25q128jv_poll();
+
+    op = &op_queue[(op_head + op_count) % W25Q128JV_QUEUE_DEPTH];
+    op->cmd = cmd;
+    op->bytes = 0;
+    op->addr = addr;
+    op_count++;
+    return op;
+}
+
+/**
+ * @brief Check whether a queued operation changes the range.
+ */
+static uint8_t w25q128jv_op_overlap(uint32_t addr, uint32_t bytes)
+{
+    for (uint8_t i = 0; i < op_count; i++) {
+        const struct w25q128jv_op *op =
+            &op_queue[(op_head + i) % W25Q128JV_QUEUE_DEPTH];
+        uint32_t start = op->addr;
+        uint32_t size = op->bytes;
+
+        if (op->cmd == W25Q128JV_SECTOR_ERASE_4KB)
+            size = W25Q128JV_SECTOR_SIZE;
+        else if (op->cmd == W25Q128JV_BLOCK_ERASE_64KB)
+            size = W25Q128JV_BLOCK_SIZE;
+        if (op->cmd != W25Q128JV_PAGE_PROGRAM)
+            start &= ~(size - 1);
+        if (addr < start + size && start < addr + bytes)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Make the flash readable at the range before a read.
+ *
+ *  A queued operation on the range is waited for. Otherwise the operation in
+ *  progress is suspended (75h), the flash accepts reads once BUSY is clear.
+ *  After a resume the operation runs for tSUS before it is suspended again,
+ *  reads closer together would keep it from progressing.
+ *
+ * @return uint8_t 1: suspended, resume with w25q128jv_read_end().
+ */
+static uint8_t w25q128jv_read_begin(uint32_t addr, uint32_t bytes)
+{
+    if (!op_count)
+        return 0;
+    if (w25q128jv_op_overlap(addr, bytes)) {
+        w25q128jv_flush();
+        return 0;
+    }
+    if (!op_active || !w25q128jv_busy())
+        return 0;
+    // whole microseconds, more than tSUS
+    while (op_resumed && system_get_us() - resume_us <= W25Q128JV_T_SUS_US) {
+        if (!w25q128jv_busy())
+            return 0;  // completed meanwhile
+    }
+
+    __w25q128jv_CS_ENABLE();
+    w25q128jv_spi(W25Q128JV_ERASE_PROGRAM_SUSPEND);
+    __w25q128jv_CS_DISABLE();
+    w25q128jv_wait_for_busy();  // tSUS
+
+    // SUS clear: the operation completed before the suspend
+    return (w25q128jv_read_sr(W25Q128JV_READ_STATUS_REG2) &
+            W25Q128JV_SR2_SUS) != 0;
+}
+
+static void w25q128jv_read_end(uint8_t suspended)
+{
+    if (!suspended)
+        return;
+    __w25q128jv_CS_ENABLE();
+    w25q128jv_spi(W25Q128JV_ERASE_PROGRAM_RESUME);
+    __w25q128jv_CS_DISABLE();
+    resume_us = system_get_us();
+    op_resumed = 1;
+}
+
+/**
+ * @brief Read any number of bytes from addr with one instruction.
+ */
+static void w25q128jv_read_data(uint8_t *pbuf, uint32_t addr, uint32_t bytes)
+{
+    uint8_t suspended = w25q128jv_read_begin(addr, bytes);
+
+    w25q128jv_read_start(addr);
+    w25q128jv_data(NULL, pbuf, bytes);
+    __w25q128jv_CS_DISABLE();
+    w25q128jv_read_end(suspended);
+}
+
 static uint32_t w25q128jv_page2sector(uint32_t page_num)
 {
     return ((page_num * W25Q128JV_PAGE_SIZE) / W25Q128JV_SECTOR_SIZE);
@@ -185,10 +619,10 @@ static uint32_t w25q128jv_block2page(uint32_t block_num)
     return (block_num * W25Q128JV_BLOCK_SIZE) / W25Q128JV_PAGE_SIZE;
 }
 
-/*******************************************************************************
- * Public Functions
- ******************************************************************************/
-uint32_t w25q128jv_read_JEDEC_ID(void)
+/**
+ * @brief Read the JEDEC ID on the current port, the flash must be idle.
+ */
+static uint32_t w25q128jv_jedec(void)
 {
     uint32_t manufacture_id, device_id_h, device_id_l;
     __w25q128jv_CS_ENABLE();
@@ -200,10 +634,20 @@ uint32_t w25q128jv_read_JEDEC_ID(void)
     return (manufacture_id << 16) | (device_id_h << 8) | device_id_l;
 }
 
+/*******************************************************************************
+ * Public Functions
+ ******************************************************************************/
+uint32_t w25q128jv_read_JEDEC_ID(void)
+{
+    w25q128jv_flush();
+    return w25q128jv_jedec();
+}
+
 uint8_t w25q128jv_read_UID(uint8_t *uid, uint8_t bytes)
 {
     if (bytes != 8)
         return FAILED;
+    w25q128jv_flush();
     __w25q128jv_CS_ENABLE();
     w25q128jv_spi(W25Q128JV_READ_UNIQUE_ID);  // Read Unique ID Command
     for (uint8_t i = 0; i < 4; i++)
@@ -219,7 +663,7 @@ uint8_t w25q128jv_init(void)
     printf("W25Q128JV Initialization ...\n\n");
 
     uint32_t id = w25q128jv_read_JEDEC_ID();
-    printf("Manufacture ID : 0x%lx\n", (id >> 16) & 0xFF);
+    printf("Manufacture ID : 0x%02x\n", (uint8_t)((id >> 16) & 0xFF));
     printf("Device ID      : 0x%02x%02x\n", (uint8_t)((id & 0xFF00) >> 8),
            (uint8_t)(id & 0xFF));
 
@@ -230,6 +674,10 @@ uint8_t w25q128jv_init(void)
         printf("%02x", UID[i]);
     printf("\n\n");
 
+    printf("Port           : %s\n", w25q128jv_on_qspi() ? "QSPI0" : "SPI2");
+    printf("Data Phase     : %s\n\n",
+           w25q128jv_probe_quad() ? "quad" : "single");
+
     printf("W25Q128JV   Page Size : %8d Bytes\n", W25Q128JV_PAGE_SIZE);
     printf("W25Q128JV Sector Size : %8d Bytes\n", W25Q128JV_SECTOR_SIZE);
     printf("W25Q128JV  Block Size : %8d Bytes\n", W25Q128JV_BLOCK_SIZE);
@@ -238,9 +686,105 @@ uint8_t w25q128jv_init(void)
     return SUCCESSED;
 }
 
+uint8_t w25q128jv_probe_port(void)
+{
+#if BOOT_SPI_FLASH_QSPI == BOOT_SPI_FLASH_AUTO
+    flash_port = W25Q128JV_PORT_QSPI0;
+    system_spi_flash_port(1);
+    if (w25q128jv_jedec() != W25Q128JV_JEDEC) {
+        flash_port = W25Q128JV_PORT_SPI2;
+        system_spi_flash_port(0);
+    }
+    io_mode = W25Q128JV_IO_UNKNOWN;  // QE is only used on QSPI0
+#else
+    flash_port = FLASH_ON_QSPI ? W25Q128JV_PORT_QSPI0 : W25Q128JV_PORT_SPI2;
+#endif
+    return FLASH_ON_QSPI;
+}
+
+uint8_t w25q128jv_on_qspi(void)
+{
+    if (flash_port == W25Q128JV_PORT_UNKNOWN)
+        w25q128jv_probe_port();
+    return FLASH_ON_QSPI;
+}
+
+uint8_t w25q128jv_probe_quad(void)
+{
+    // Read Status Register-2 is accepted while BUSY
+    uint8_t sr2 = w25q128jv_read_sr(W25Q128JV_READ_STATUS_REG2);
+
+    if (FLASH_QUAD_CAPABLE && (sr2 & W25Q128JV_SR2_QE))
+        io_mode = W25Q128JV_IO_QUAD;
+    else
+        io_mode = W25Q128JV_IO_SINGLE;
+    // IO2 and IO3 to QSPI0, or /WP and /HOLD held high for single SPI
+    system_spi_quad_pins(io_mode == W25Q128JV_IO_QUAD);
+    return io_mode == W25Q128JV_IO_QUAD;
+}
+
+/******************************************************************************/
+uint8_t w25q128jv_poll(void)
+{
+    if (op_active) {
+        if (w25q128jv_busy())
+            return op_count;
+        op_active = 0;
+        op_head = (op_head + 1) % W25Q128JV_QUEUE_DEPTH;
+        op_count--;
+    }
+    if (op_count) {
+        w25q128jv_op_start(&op_queue[op_head]);
+        op_active = 1;
+    }
+    return op_count;
+}
+
+void w25q128jv_flush(void)
+{
+    while (w25q128jv_poll())
+        ;
+}
+
+void w25q128jv_erase_sector_async(uint32_t sector_num)
+{
+    w25q128jv_op_alloc(W25Q128JV_SECTOR_ERASE_4KB,
+                       sector_num * W25Q128JV_SECTOR_SIZE);
+    w25q128jv_poll();
+}
+
+void w25q128jv_erase_block_async(uint32_t block_num)
+{
+    w25q128jv_op_alloc(W25Q128JV_BLOCK_ERASE_64KB,
+                       block_num * W25Q128JV_BLOCK_SIZE);
+    w25q128jv_poll();
+}
+
+void w25q128jv_write_bytes_async(const uint8_t *pbuf,
+                                 uint32_t addr,
+                                 uint32_t bytes)
+{
+    while (bytes) {
+        uint32_t n = W25Q128JV_PAGE_SIZE - (addr % W25Q128JV_PAGE_SIZE);
+        struct w25q128jv_op *op;
+
+        if (n > bytes)
+            n = bytes;
+        op = w25q128jv_op_alloc(W25Q128JV_PAGE_PROGRAM, addr);
+        op->bytes = n;
+        memcpy(op->data, pbuf, n);
+        w25q128jv_poll();
+
+        pbuf += n;
+        addr += n;
+        bytes -= n;
+    }
+}
+
 /******************************************************************************/
 void w25q128jv_erase_chip(void)
 {
+    w25q128jv_flush();  // Chip Erase cannot be suspended, not queued
     w25q128jv_write_enable();
     w25q128jv_wait_for_busy();  // wait
 
@@ -252,50 +796,21 @@ void w25q128jv_erase_chip(void)
 
 void w25q128jv_erase_sector(uint32_t sector_num)
 {
-    w25q128jv_write_enable();
-    w25q128jv_wait_for_busy();  // wait
-
-    uint32_t sector_addr = sector_num * W25Q128JV_SECTOR_SIZE;
-
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_SECTOR_ERASE_4KB);
-    w25q128jv_spi((sector_addr & 0xFF0000) >> 16);
-    w25q128jv_spi((sector_addr & 0xFF00) >> 8);
-    w25q128jv_spi(sector_addr & 0xFF);
-    __w25q128jv_CS_DISABLE();
-    w25q128jv_wait_for_busy();  // wait
+    w25q128jv_erase_sector_async(sector_num);
+    w25q128jv_flush();
 }
 
 void w25q128jv_erase_block(uint32_t block_num)
 {
-    w25q128jv_write_enable();
-    w25q128jv_wait_for_busy();  // wait
-
-    uint32_t block_addr = block_num * W25Q128JV_BLOCK_SIZE;
-
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_BLOCK_ERASE_64KB);
-    w25q128jv_spi((block_addr & 0xFF0000) >> 16);
-    w25q128jv_spi((block_addr & 0xFF00) >> 8);
-    w25q128jv_spi(block_addr & 0xFF);
-    __w25q128jv_CS_DISABLE();
-    w25q128jv_wait_for_busy();  // wait
+    w25q128jv_erase_block_async(block_num);
+    w25q128jv_flush();
 }
 
 /******************************************************************************/
 void w25q128jv_write_byte(uint8_t pbuf, uint32_t addr)
 {
-    w25q128jv_write_enable();
-    w25q128jv_wait_for_busy();  // wait
-
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_PAGE_PROGRAM);
-    w25q128jv_spi((addr & 0xFF0000) >> 16);
-    w25q128jv_spi((addr & 0xFF00) >> 8);
-    w25q128jv_spi(addr & 0xFF);
-    w25q128jv_spi(pbuf);
-    __w25q128jv_CS_DISABLE();
-    w25q128jv_wait_for_busy();  // wait
+    w25q128jv_write_bytes_async(&pbuf, addr, 1);
+    w25q128jv_flush();
 }
 
 void w25q128jv_write_page(uint8_t *pbuf,
@@ -310,19 +825,8 @@ void w25q128jv_write_page(uint8_t *pbuf,
     if ((bytes + offset) > W25Q128JV_PAGE_SIZE)
         bytes = W25Q128JV_PAGE_SIZE - offset;
 
-    w25q128jv_write_enable();
-    w25q128jv_wait_for_busy();  // wait
-
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_PAGE_PROGRAM);
-    w25q128jv_spi((page_addr & 0xFF0000) >> 16);
-    w25q128jv_spi((page_addr & 0xFF00) >> 8);
-    w25q128jv_spi(page_addr & 0xFF);
-    for (uint32_t i = 0; i < bytes; i++) {
-        w25q128jv_spi(pbuf[i]);
-    }
-    __w25q128jv_CS_DISABLE();
-    w25q128jv_wait_for_busy();  // wait
+    w25q128jv_write_bytes_async(pbuf, page_addr, bytes);
+    w25q128jv_flush();
 }
 
 void w25q128jv_write_sector(uint8_t *pbuf,
@@ -335,24 +839,14 @@ void w25q128jv_write_sector(uint8_t *pbuf,
     if (offset >= W25Q128JV_SECTOR_SIZE)
         return;
 
-    uint32_t wpage;
-    int32_t wbytes;
-    uint32_t ofs;
-
     if ((bytes + offset) > W25Q128JV_SECTOR_SIZE)
-        wbytes = W25Q128JV_SECTOR_SIZE - offset;
-    else
-        wbytes = bytes;
+        bytes = W25Q128JV_SECTOR_SIZE - offset;
 
-    wpage = w25q128jv_sector2page(sector_num) + (offset / W25Q128JV_PAGE_SIZE);
-    ofs = offset % W25Q128JV_PAGE_SIZE;
-    do {
-        w25q128jv_write_page(pbuf, wpage, ofs, wbytes);
-        wpage++;
-        wbytes -= W25Q128JV_PAGE_SIZE - ofs;
-        pbuf += W25Q128JV_PAGE_SIZE - ofs;
-        ofs = 0;
-    } while (wbytes > 0);
+    // page by page through the queue, the next page is copied in meanwhile
+    w25q128jv_write_bytes_async(pbuf,
+                                sector_num * W25Q128JV_SECTOR_SIZE + offset,
+                                bytes);
+    w25q128jv_flush();
 }
 
 void w25q128jv_write_block(uint8_t *pbuf,
@@ -365,51 +859,23 @@ void w25q128jv_write_block(uint8_t *pbuf,
     if (offset >= W25Q128JV_BLOCK_SIZE)
         return;
 
-    uint32_t wpage;
-    int32_t wbytes;
-    uint32_t ofs;
-
     if ((bytes + offset) > W25Q128JV_BLOCK_SIZE)
-        wbytes = W25Q128JV_BLOCK_SIZE - offset;
-    else
-        wbytes = bytes;
+        bytes = W25Q128JV_BLOCK_SIZE - offset;
 
-    wpage = w25q128jv_sector2page(block_num) + (offset / W25Q128JV_PAGE_SIZE);
-    ofs = offset % W25Q128JV_PAGE_SIZE;
-    do {
-        w25q128jv_write_page(pbuf, wpage, ofs, wbytes);
-        wpage++;
-        wbytes -= W25Q128JV_PAGE_SIZE - ofs;
-        pbuf += W25Q128JV_PAGE_SIZE - ofs;
-        ofs = 0;
-    } while (wbytes > 0);
+    w25q128jv_write_bytes_async(pbuf, block_num * W25Q128JV_BLOCK_SIZE + offset,
+                                bytes);
+    w25q128jv_flush();
 }
 
 /******************************************************************************/
 void w25q128jv_read_byte(uint8_t *pbuf, uint32_t addr)
 {
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_FAST_READ);
-    w25q128jv_spi((addr & 0xFF0000) >> 16);
-    w25q128jv_spi((addr & 0xFF00) >> 8);
-    w25q128jv_spi(addr & 0xFF);
-    w25q128jv_spi(0);
-    *pbuf = w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
-    __w25q128jv_CS_DISABLE();
+    w25q128jv_read_data(pbuf, addr, 1);
 }
 
 void w25q128jv_read_bytes(uint8_t *pbuf, uint32_t addr, uint32_t bytes)
 {
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_FAST_READ);
-    w25q128jv_spi((addr & 0xFF0000) >> 16);
-    w25q128jv_spi((addr & 0xFF00) >> 8);
-    w25q128jv_spi(addr & 0xFF);
-    w25q128jv_spi(0);
-    for (uint32_t i = 0; i < bytes; i++) {
-        pbuf[i] = w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
-    }
-    __w25q128jv_CS_DISABLE();
+    w25q128jv_read_data(pbuf, addr, bytes);
 }
 
 void w25q128jv_read_page(uint8_t *pbuf,
@@ -424,16 +890,7 @@ void w25q128jv_read_page(uint8_t *pbuf,
     if ((bytes + offset) > W25Q128JV_PAGE_SIZE)
         bytes = W25Q128JV_PAGE_SIZE - offset;
 
-    __w25q128jv_CS_ENABLE();
-    w25q128jv_spi(W25Q128JV_FAST_READ);
-    w25q128jv_spi((page_addr & 0xFF0000) >> 16);
-    w25q128jv_spi((page_addr & 0xFF00) >> 8);
-    w25q128jv_spi(page_addr & 0xFF);
-    w25q128jv_spi(0);
-    for (uint32_t i = 0; i < bytes; i++) {
-        pbuf[i] = w25q128jv_spi(W25Q128JV_DUMMY_BYTE);
-    }
-    __w25q128jv_CS_DISABLE();
+    w25q128jv_read_data(pbuf, page_addr, bytes);
 }
 
 void w25q128jv_read_sector(uint8_t *pbuf,
@@ -446,24 +903,12 @@ void w25q128jv_read_sector(uint8_t *pbuf,
     if (offset >= W25Q128JV_SECTOR_SIZE)
         return;
 
-    uint32_t rpage;
-    int32_t rbytes;
-    uint32_t ofs;
-
     if ((bytes + offset) > W25Q128JV_SECTOR_SIZE)
-        rbytes = W25Q128JV_SECTOR_SIZE - offset;
-    else
-        rbytes = bytes;
+        bytes = W25Q128JV_SECTOR_SIZE - offset;
 
-    rpage = w25q128jv_sector2page(sector_num) + (offset / W25Q128JV_PAGE_SIZE);
-    ofs = offset % W25Q128JV_PAGE_SIZE;
-    do {
-        w25q128jv_read_page(pbuf, rpage, ofs, rbytes);
-        rpage++;
-        rbytes -= W25Q128JV_PAGE_SIZE - ofs;
-        pbuf += W25Q128JV_PAGE_SIZE - ofs;
-        ofs = 0;
-    } while (rbytes > 0);
+    // one instruction, the flash reads on across the pages
+    w25q128jv_read_data(pbuf, sector_num * W25Q128JV_SECTOR_SIZE + offset,
+                        bytes);
 }
 
 void w25q128jv_read_block(uint8_t *pbuf,
@@ -476,22 +921,65 @@ void w25q128jv_read_block(uint8_t *pbuf,
     if (offset >= W25Q128JV_BLOCK_SIZE)
         return;
 
-    uint32_t rpage;
-    int32_t rbytes;
-    uint32_t ofs;
-
     if ((bytes + offset) > W25Q128JV_BLOCK_SIZE)
-        rbytes = W25Q128JV_BLOCK_SIZE - offset;
-    else
-        rbytes = bytes;
-
-    rpage = w25q128jv_block2page(block_num) + (offset / W25Q128JV_PAGE_SIZE);
-    ofs = offset % W25Q128JV_PAGE_SIZE;
-    do {
-        w25q128jv_read_page(pbuf, rpage, ofs, rbytes);
-        rpage++;
-        rbytes -= W25Q128JV_PAGE_SIZE - ofs;
-        pbuf += W25Q128JV_PAGE_SIZE - ofs;
-        ofs = 0;
-    } while (rbytes > 0);
+        bytes = W25Q128JV_BLOCK_SIZE - offset;
+
+    // one instruction, the flash reads on across the pages
+    w25q128jv_read_data(pbuf, block_num * W25Q128JV_BLOCK_SIZE + offset,
+                        bytes);
+}
+
+uint8_t w25q128jv_read_stream(uint8_t *pbuf,
+                              uint32_t chunk,
+                              uint32_t addr,
+                              uint32_t bytes,
+                              w25q128jv_chunk_t handler,
+                              void *ctx)
+{
+    return w25q128jv_read_pipe(pbuf, NULL, chunk, addr, bytes, handler, ctx);
+}
+
+uint8_t w25q128jv_read_pipe(uint8_t *pbuf0,
+                            uint8_t *pbuf1,
+                            uint32_t chunk,
+                            uint32_t addr,
+                            uint32_t bytes,
+                            w25q128jv_chunk_t handler,
+                            void *ctx)
+{
+    uint8_t *pbuf[2] = {pbuf0, pbuf1 ? pbuf1 : pbuf0};
+    uint8_t ret = SUCCESSED;
+    uint8_t cur = 0;
+
+    if (chunk == 0 || (pbuf1 && chunk > W25Q128JV_PDMA_MAX))
+        return FAILED;
+
+    uint8_t suspended = w25q128jv_read_begin(addr, bytes);
+    uint32_t n = (bytes < chunk) ? bytes : chunk;
+
+    w25q128jv_read_start(addr);
+    w25q128jv_data(NULL, pbuf[cur], n);
+    while (n) {
+        uint32_t ahead = (bytes - n < chunk) ? bytes - n : chunk;
+
+        // the next chunk streams into the other buffer during the handler
+        if (pbuf1 && ahead)
+            w25q128jv_data_start(NULL, pbuf[!cur], ahead);
+        if (handler(ctx, pbuf[cur], addr, n) != SUCCESSED)
+            ret = FAILED;
+        if (pbuf1 && ahead)
+            w25q128jv_data_wait();
+        else if (ahead && ret == SUCCESSED)
+            w25q128jv_data(NULL, pbuf[cur], ahead);
+        if (ret == FAILED)
+            break;
+
+        cur = pbuf1 ? !cur : cur;
+        addr += n;
+        bytes -= n;
+        n = ahead;
+    }
+    __w25q128jv_CS_DISABLE();
+    w25q128jv_read_end(suspended);
+    return ret;
 }
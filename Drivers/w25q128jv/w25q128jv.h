@@ -6,6 +6,25 @@
  *
  * Reference:
  * https://www.winbond.com/hq/product/code-storage-flash-memory/serial-nor-flash/?__locale=zh_TW&partNo=W25Q128JV
+ *
+ * The flash sits on QSPI0 or on SPI2 (BOOT_SPI_FLASH_QSPI, boot_system.h).
+ * The default build has both and takes QSPI0 when the JEDEC ID reads back
+ * there before the first instruction, else SPI2. On QSPI0 with the QE bit
+ * set, reads use Fast Read Quad I/O (EBh) and programs Quad Input Page
+ * Program (32h), 4 bits per clock in the data phase. Otherwise everything
+ * goes over single SPI. The QE bit is non-volatile and left as found, it is
+ * probed before the first read or program.
+ *
+ * The instruction and address go out byte by byte. Data phases of
+ * W25Q128JV_PDMA_MIN bytes or more are moved by two PDMA channels, the CPU
+ * sleeps until the RX channel interrupt reports the last byte in.
+ *
+ * Programs and erases go through a queue of W25Q128JV_QUEUE_DEPTH operations.
+ * The _async() calls return once the operation is queued, w25q128jv_poll()
+ * starts the next one whenever the flash reports BUSY clear, the flash has no
+ * ready interrupt. A read of a range a queued operation changes waits for it,
+ * any other read suspends the operation in progress (75h) and resumes it (7Ah)
+ * after. The other calls return with the queue empty as before.
  */
 
 #ifndef W25Q128JV_H
@@ -13,6 +32,33 @@
 
 #include <stdint.h>
 
+/**
+ * @brief PDMA channels of the data phase, next to COM_CHANNEL_TX_PDMA_CH.
+ */
+#ifndef W25Q128JV_PDMA_TX_CH
+#define W25Q128JV_PDMA_TX_CH 1
+#endif
+
+#ifndef W25Q128JV_PDMA_RX_CH
+#define W25Q128JV_PDMA_RX_CH 2
+#endif
+
+/**
+ * @brief Shorter data phases are polled, setting up the PDMA costs more than
+ *        they take. LittleFS reads its 16-byte metadata tags this way.
+ */
+#ifndef W25Q128JV_PDMA_MIN
+#define W25Q128JV_PDMA_MIN 32
+#endif
+
+/**
+ * @brief Queued program and erase operations, a page program holds a copy of
+ *        its data.
+ */
+#ifndef W25Q128JV_QUEUE_DEPTH
+#define W25Q128JV_QUEUE_DEPTH 4
+#endif
+
 /**
  * @brief Read JEDEC ID
  * @ref 8.1.1 Manufacturer and Device Identification
@@ -37,6 +83,63 @@ uint8_t w25q128jv_read_UID(uint8_t *uid, uint8_t bytes);
  */
 uint8_t w25q128jv_init(void);
 
+/**
+ * @brief Find the port the flash answers on, QSPI0 first, and route its pins
+ *        by system_spi_flash_port(). Done before the first instruction, call
+ *        again after a rewire with the queue empty, the data phase width is
+ *        probed again after. A single port build only reports its port.
+ * @return uint8_t 1: QSPI0, 0: SPI2.
+ */
+uint8_t w25q128jv_probe_port(void);
+
+/**
+ * @brief Check whether the flash is on QSPI0, where quad SPI and XIP work.
+ * @return uint8_t 1: QSPI0, 0: SPI2.
+ */
+uint8_t w25q128jv_on_qspi(void);
+
+/**
+ * @brief Select the data phase width from the QE bit of Status Register-2.
+ *        Call again after changing the QE bit.
+ * @return uint8_t
+ *      1 - quad read and program
+ *      0 - single SPI, QE clear or the flash on SPI2
+ */
+uint8_t w25q128jv_probe_quad(void);
+
+/**
+ * @brief Complete the operation in progress once BUSY is clear and start the
+ *        next queued one. Call it regularly while operations are queued.
+ * @return uint8_t operations still queued, the one in progress included.
+ */
+uint8_t w25q128jv_poll(void);
+
+/**
+ * @brief Wait until every queued operation completed.
+ */
+void w25q128jv_flush(void);
+
+/**
+ * @brief Queue an erase, waiting for a free slot while the queue is full.
+ *
+ *  NOTE: An erase in progress is suspended by reads outside of it. After a
+ *        resume it runs for tSUS (20us) before the next suspend, a read
+ *        sooner than that waits out the rest.
+ */
+void w25q128jv_erase_sector_async(uint32_t sector_num);
+void w25q128jv_erase_block_async(uint32_t block_num);
+
+/**
+ * @brief Queue a program of any range, one operation per page touched. The
+ *        data is copied, pbuf may be reused on return.
+ * @param pbuf data, the range must be erased.
+ * @param addr flash address.
+ * @param bytes length.
+ */
+void w25q128jv_write_bytes_async(const uint8_t *pbuf,
+                                 uint32_t addr,
+                                 uint32_t bytes);
+
 void w25q128jv_erase_chip(void);
 void w25q128jv_erase_sector(uint32_t sector_num);
 void w25q128jv_erase_block(uint32_t block_num);
@@ -56,6 +159,74 @@ void w25q128jv_read_block(uint8_t *pbuf,
                           uint32_t offset,
                           uint32_t bytes);
 
+/**
+ * @brief Chunk handler of w25q128jv_read_stream().
+ * @param ctx as given to w25q128jv_read_stream().
+ * @param pbuf the chunk just read.
+ * @param addr flash address of pbuf[0].
+ * @param bytes chunk length.
+ * @return uint8_t
+ *      1 - SUCCESSED, read on
+ *      0 - FAILED, stop the read
+ */
+typedef uint8_t (*w25q128jv_chunk_t)(void *ctx,
+                                     const uint8_t *pbuf,
+                                     uint32_t addr,
+                                     uint32_t bytes);
+
+/**
+ * @brief Read a range of any length with one instruction, chunk by chunk.
+ *
+ * /CS stays low from the first to the last chunk, the handler gets each chunk
+ * as soon as it is in pbuf, which is then reused for the next one.
+ *
+ *  NOTE: The handler must not access the flash, the read is still selected.
+ *
+ * @param pbuf buffer of chunk bytes.
+ * @param chunk chunk length, not 0.
+ * @param addr flash address to start from.
+ * @param bytes total length.
+ * @param handler called for every chunk.
+ * @param ctx passed to the handler.
+ * @return uint8_t
+ *      1 - SUCCESSED
+ *      0 - FAILED, chunk 0 or stopped by the handler.
+ */
+uint8_t w25q128jv_read_stream(uint8_t *pbuf,
+                              uint32_t chunk,
+                              uint32_t addr,
+                              uint32_t bytes,
+                              w25q128jv_chunk_t handler,
+                              void *ctx);
+
+/**
+ * @brief w25q128jv_read_stream() with two buffers, the next chunk is read into
+ *        one by PDMA while the handler works on the other.
+ *
+ * A handler that programs the chunk somewhere else hides the read of the next
+ * one behind it. A last chunk under W25Q128JV_PDMA_MIN bytes is polled instead.
+ *
+ *  NOTE: The handler must not access the flash nor the other buffer.
+ *
+ * @param pbuf0 buffer of chunk bytes.
+ * @param pbuf1 the other buffer, NULL for w25q128jv_read_stream().
+ * @param chunk chunk length, not 0, 16 KiB at most with two buffers.
+ * @param addr flash address to start from.
+ * @param bytes total length.
+ * @param handler called for every chunk.
+ * @param ctx passed to the handler.
+ * @return uint8_t
+ *      1 - SUCCESSED
+ *      0 - FAILED, bad chunk or stopped by the handler.
+ */
+uint8_t w25q128jv_read_pipe(uint8_t *pbuf0,
+                            uint8_t *pbuf1,
+                            uint32_t chunk,
+                            uint32_t addr,
+                            uint32_t bytes,
+                            w25q128jv_chunk_t handler,
+                            void *ctx);
+
 void w25q128jv_write_byte(uint8_t pbuf, uint32_t addr);
 void w25q128jv_write_page(uint8_t *pbuf,
                           uint32_t page_num,
@@ -0,0 +1,161 @@
+/**
+ * @file NuMicro.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host stand-in for the NuMicro peripheral access layer.
+ *
+ * Only the subset of the M480 BSP used by the bootloader modules is provided.
+ * FMC calls operate on an emulated 512 KiB APROM and the SPI macros drive an
+ * emulated W25Q128JV, see host.h for the backend control API. PDMA channels
+ * serve the SPI2/QSPI0 requests only, the transfer runs when it is triggered
+ * and raises PDMA_IRQHandler() before the trigger returns, or at the next
+ * __WFI() with host_pdma_set_overlap().
+ */
+
+#ifndef __NUMICRO_H__
+#define __NUMICRO_H__
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * FMC
+ ******************************************************************************/
+#define FMC_APROM_BASE      0x00000000UL
+#define FMC_APROM_END       0x00080000UL
+#define FMC_APROM_BANK0_END (FMC_APROM_END / 2UL)
+#define FMC_FLASH_PAGE_SIZE 0x1000UL
+
+#define FMC_MULTI_WORD_PROG_LEN 512
+
+extern int32_t g_FMC_i32ErrCode;
+
+void FMC_Open(void);
+void FMC_Close(void);
+int32_t FMC_Erase(uint32_t u32PageAddr);
+int32_t FMC_Erase_Block(uint32_t u32BlockAddr);
+uint32_t FMC_Read(uint32_t u32Addr);
+int32_t FMC_Write(uint32_t u32Addr, uint32_t u32Data);
+int32_t FMC_Write8Bytes(uint32_t u32addr, uint32_t u32data0, uint32_t u32data1);
+int32_t FMC_WriteMultiple(uint32_t u32Addr, uint32_t pu32Buf[], uint32_t u32Len);
+uint32_t FMC_GetChkSum(uint32_t u32addr, uint32_t u32count);
+
+#define FMC_ENABLE_AP_UPDATE()  host_fmc_set_ap_update(1)
+#define FMC_DISABLE_AP_UPDATE() host_fmc_set_ap_update(0)
+
+void host_fmc_set_ap_update(int enable);
+
+/*******************************************************************************
+ * SPI
+ ******************************************************************************/
+struct host_spi {
+    uint32_t TX;    /* last byte written */
+    uint32_t RX;    /* byte shifted in by that write */
+    uint8_t quad;   /* QSPI0 only, 4 lanes */
+    uint8_t output; /* 4 lanes driven by the host */
+};
+
+typedef struct host_spi SPI_T;
+
+extern SPI_T host_spi2;
+#define SPI2 (&host_spi2)
+
+#define SPI_WRITE_TX(spi, u32TxData) host_spi_write_tx((spi), (u32TxData))
+#define SPI_READ_RX(spi)             host_spi_read_rx(spi)
+#define SPI_IS_BUSY(spi)             (0)
+#define SPI_SET_SS_LOW(spi)          host_spi_set_ss((spi), 0)
+#define SPI_SET_SS_HIGH(spi)         host_spi_set_ss((spi), 1)
+
+#define SPI_TRIGGER_TX_RX_PDMA(spi) \
+    host_pdma_service((spi), PDMA_SPI2_TX, PDMA_SPI2_RX)
+#define SPI_DISABLE_TX_RX_PDMA(spi) ((void) (spi))
+
+void host_spi_write_tx(SPI_T *spi, uint32_t data);
+uint32_t host_spi_read_rx(SPI_T *spi);
+void host_spi_set_ss(SPI_T *spi, int level);
+
+/*******************************************************************************
+ * QSPI
+ ******************************************************************************/
+typedef struct host_spi QSPI_T;
+
+extern QSPI_T host_qspi0;
+#define QSPI0 (&host_qspi0)
+
+#define QSPI_WRITE_TX(qspi, u32TxData) host_spi_write_tx((qspi), (u32TxData))
+#define QSPI_READ_RX(qspi)             host_spi_read_rx(qspi)
+#define QSPI_IS_BUSY(qspi)             (0)
+#define QSPI_SET_SS_LOW(qspi)          host_spi_set_ss((qspi), 0)
+#define QSPI_SET_SS_HIGH(qspi)         host_spi_set_ss((qspi), 1)
+
+#define QSPI_TRIGGER_TX_RX_PDMA(qspi) \
+    host_pdma_service((qspi), PDMA_QSPI0_TX, PDMA_QSPI0_RX)
+#define QSPI_DISABLE_TX_RX_PDMA(qspi) ((void) (qspi))
+
+#define QSPI_ENABLE_QUAD_INPUT_MODE(qspi)  host_spi_set_quad((qspi), 1, 0)
+#define QSPI_ENABLE_QUAD_OUTPUT_MODE(qspi) host_spi_set_quad((qspi), 1, 1)
+#define QSPI_DISABLE_QUAD_MODE(qspi)       host_spi_set_quad((qspi), 0, 0)
+
+void host_spi_set_quad(SPI_T *spi, int quad, int output);
+
+/*******************************************************************************
+ * PDMA
+ ******************************************************************************/
+typedef struct host_pdma PDMA_T;
+
+extern PDMA_T host_pdma;
+#define PDMA (&host_pdma)
+
+#define PDMA_CH_MAX 16UL
+
+#define PDMA_WIDTH_8        0x00000000UL
+#define PDMA_SAR_INC        0x00000000UL
+#define PDMA_SAR_FIX        0x00000300UL
+#define PDMA_DAR_INC        0x00000000UL
+#define PDMA_DAR_FIX        0x00000C00UL
+#define PDMA_REQ_SINGLE     0x00000004UL
+#define PDMA_INT_TRANS_DONE 0x00000000UL
+
+#define PDMA_QSPI0_TX 20UL
+#define PDMA_QSPI0_RX 21UL
+#define PDMA_SPI2_TX  26UL
+#define PDMA_SPI2_RX  27UL
+
+#define PDMA_GET_TD_STS(pdma)             host_pdma_get_sts((pdma), 0)
+#define PDMA_CLR_TD_FLAG(pdma, u32Mask)   host_pdma_clr_sts((pdma), 0, u32Mask)
+#define PDMA_GET_ABORT_STS(pdma)          host_pdma_get_sts((pdma), 1)
+#define PDMA_CLR_ABORT_FLAG(pdma, u32Mask) \
+    host_pdma_clr_sts((pdma), 1, u32Mask)
+
+void PDMA_Open(PDMA_T *pdma, uint32_t u32Mask);
+void PDMA_SetTransferCnt(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32Width,
+                         uint32_t u32TransCount);
+void PDMA_SetTransferAddr(PDMA_T *pdma, uint32_t u32Ch, uintptr_t u32SrcAddr,
+                          uint32_t u32SrcCtrl, uintptr_t u32DstAddr,
+                          uint32_t u32DstCtrl);
+void PDMA_SetTransferMode(PDMA_T *pdma, uint32_t u32Ch,
+                          uint32_t u32Peripheral, uint32_t u32ScatterEn,
+                          uint32_t u32DescAddr);
+void PDMA_SetBurstType(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32BurstType,
+                       uint32_t u32BurstSize);
+void PDMA_EnableInt(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32Mask);
+void PDMA_DisableInt(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32Mask);
+void PDMA_IRQHandler(void);
+
+uint32_t host_pdma_get_sts(PDMA_T *pdma, int abort);
+void host_pdma_clr_sts(PDMA_T *pdma, int abort, uint32_t mask);
+void host_pdma_service(SPI_T *spi, uint32_t tx_req, uint32_t rx_req);
+void host_pdma_land(void);
+void host_pdma_wfi(void);
+
+/*******************************************************************************
+ * System
+ ******************************************************************************/
+#define SYS_UnlockReg()
+#define SYS_LockReg()
+
+#define __DMB()
+#define __WFI() host_pdma_wfi()
+#define __enable_irq()
+#define __disable_irq()
+
+#endif /* __NUMICRO_H__ */
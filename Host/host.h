@@ -0,0 +1,236 @@
+/**
+ * @file host.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build backends.
+ *
+ * Stand-ins for the board so the boot protocol engine, the flash drivers and
+ * the LittleFS port can run natively:
+ *
+ *  - APROM     : 512 KiB, RAM-backed or file-backed (FMC_* calls).
+ *  - W25Q128JV : 16 MiB, RAM-backed or file-backed (SPI2/QSPI0 command
+ *                emulation).
+ *  - UART0     : any file descriptor, e.g. a socketpair or a pty
+ *                (com_channel_getc / com_channel_putc).
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+
+struct host_spi;  // SPI_T and QSPI_T, NuMicro.h
+
+#define HOST_APROM_SIZE     (0x00080000UL)
+#define HOST_W25Q128JV_SIZE (0x01000000UL)
+
+/**
+ * @brief Operation counters of the emulated peripherals.
+ *
+ * The emulation runs at host speed, so throughput is compared by counting the
+ * operations that cost time on the board.
+ */
+typedef struct __host_stats {
+    uint64_t uart_rx_bytes;   /* bytes read by com_channel_getc() */
+    uint64_t uart_tx_bytes;   /* bytes written by com_channel_putc() */
+    uint64_t uart_rx_async;   /* of which by com_channel_read_async() */
+    uint64_t fmc_isp_program; /* ISP program triggers */
+    uint64_t fmc_isp_mp_data; /* 8-byte units fed to multi-word programs */
+    uint64_t fmc_isp_erase;   /* ISP page/block erase triggers */
+    uint64_t fmc_isp_read;    /* ISP read triggers */
+    uint64_t fmc_isp_cks;     /* 4 KiB pages run through the ISP checksum */
+    uint64_t fmc_bank0_program; /* of the above, in bank 0 next to the */
+    uint64_t fmc_bank0_mp_data; /* bootloader code, instruction fetch */
+    uint64_t fmc_bank0_erase;   /* stalls until they complete */
+    uint64_t spi_bytes;       /* bytes clocked on SPI2/QSPI0 */
+    uint64_t spi_quad_bytes;  /* of which on 4 lanes, 2 clocks each */
+    uint64_t spi_pdma_bytes;  /* of which moved by PDMA, not polled */
+    uint64_t spi_commands;    /* SPI2/QSPI0 chip select assertions */
+    uint64_t nor_program;     /* W25Q128JV page program operations */
+    uint64_t nor_erase;       /* W25Q128JV sector/block/chip erases */
+    uint64_t nor_suspend;     /* W25Q128JV erase/program suspends */
+    uint64_t nor_suspend_early; /* of which within tSUS of a resume */
+    uint64_t sha_dma_bytes;   /* bytes hashed by the CRPT SHA-256 DMA */
+    uint64_t sha_dma_parts;   /* CRPT SHA-256 DMA parts started */
+} host_stats_t;
+
+extern host_stats_t host_stats;
+
+/**
+ * @brief Reset all operation counters.
+ */
+void host_stats_reset(void);
+
+/**
+ * @brief Receives a PDMA transfer once the CPU is back on SPI.
+ * @param transfer counters of the transfer itself.
+ * @param meanwhile counters of what the CPU did while it was in flight.
+ */
+typedef void (*host_pdma_overlap_t)(const host_stats_t *transfer,
+                                    const host_stats_t *meanwhile);
+
+/**
+ * @brief Report every PDMA transfer with the work it ran beside.
+ *
+ * The host PDMA moves the data at the trigger. The transfer still counts as
+ * in flight until the CPU sleeps for its interrupt (__WFI()), drives /CS or
+ * triggers another transfer; whatever the CPU did until then ran beside it
+ * on the board. The interrupt is held back until then too.
+ *
+ * @param fn called per transfer, NULL to stop.
+ */
+void host_pdma_set_overlap(host_pdma_overlap_t fn);
+
+/**
+ * @brief Open the emulated APROM.
+ * @param path backing file, created and sized as needed. NULL for RAM-backed.
+ * @return int 0: successed, -1: failed.
+ *
+ *  NOTE: a new RAM-backed APROM is erased (0xFF).
+ */
+int host_fmc_open(const char *path);
+
+/**
+ * @brief Close the emulated APROM, flushing a file-backed image.
+ */
+void host_fmc_close(void);
+
+/**
+ * @brief Direct access to the emulated APROM memory.
+ * @return uint8_t* pointer to APROM address 0.
+ */
+uint8_t *host_fmc_mem(void);
+
+/**
+ * @brief Cut every FMC_WriteMultiple() burst short, as an interrupt holding
+ *        up the data feed does on the board.
+ * @param bytes bytes a burst programs before it ends, a multiple of 8 from
+ *              16 up. 0: a whole row, as after host_fmc_open().
+ */
+void host_fmc_set_mp_burst(uint32_t bytes);
+
+/**
+ * @brief Make FMC_Write() of one word fail, as the ISPFF flag reports.
+ * @param addr APROM address of the word, 0xFFFFFFFF for none as after
+ *             host_fmc_open().
+ */
+void host_fmc_set_fail(uint32_t addr);
+
+/**
+ * @brief Open the emulated W25Q128JV.
+ * @param path backing file, created and sized as needed. NULL for RAM-backed.
+ * @return int 0: successed, -1: failed.
+ *
+ *  NOTE: a new RAM-backed array is erased (0xFF).
+ */
+int host_spi_flash_open(const char *path);
+
+/**
+ * @brief Close the emulated W25Q128JV, flushing a file-backed image.
+ */
+void host_spi_flash_close(void);
+
+/**
+ * @brief Direct access to the emulated W25Q128JV array.
+ * @return uint8_t* pointer to flash address 0.
+ */
+uint8_t *host_spi_flash_mem(void);
+
+/**
+ * @brief Set or clear the QE bit of the emulated Status Register-2, as left
+ *        by the factory or a previous Write Status Register-2.
+ * @param qe 1: quad instructions accepted, 0: ignored.
+ */
+void host_spi_flash_set_qe(int qe);
+
+/**
+ * @brief Let program and erase take their typical time.
+ *
+ * The time is counted in SPI clocks at 20 MHz: BUSY reads back set until
+ * enough bytes went over SPI2/QSPI0 or host_spi_flash_elapse() passed it, the
+ * array changes when the operation completes. Off after host_spi_flash_open(),
+ * program and erase then complete at once.
+ *
+ * @param enable 1: timed, 0: immediate.
+ */
+void host_spi_flash_set_timing(int enable);
+
+/**
+ * @brief Let time pass for the emulated W25Q128JV without SPI traffic.
+ * @param us microseconds.
+ */
+void host_spi_flash_elapse(uint32_t us);
+
+/**
+ * @brief Time of the emulated W25Q128JV, SPI clocks at 20 MHz and
+ *        host_spi_flash_elapse() since host_spi_flash_open().
+ * @return uint32_t microseconds, system_get_us() on the host.
+ */
+uint32_t host_spi_flash_us(void);
+
+/**
+ * @brief Wire the emulated W25Q128JV to a port, as the board was built.
+ * @param port QSPI0 as after host_spi_flash_open(), or SPI2. The other port
+ *             reads 0xFF.
+ */
+void host_spi_flash_wire(struct host_spi *port);
+
+/**
+ * @brief Check for a program or erase in progress or suspended.
+ * @return int 1: busy or suspended, 0: idle.
+ */
+int host_spi_flash_busy(void);
+
+/**
+ * @brief Attach the communication channel to a file descriptor.
+ * @param fd connected descriptor (socketpair end, pty master, ...).
+ *
+ *  NOTE: When the peer closes the descriptor, com_channel_getc() terminates
+ *        the calling thread, since the bootloader loop never returns by itself.
+ */
+void host_com_channel_open(int fd);
+
+/**
+ * @brief Open a pseudo terminal and attach the communication channel to it.
+ * @return const char* the slave device name for the programmer to open,
+ *         NULL if failed.
+ */
+const char *host_com_channel_open_pty(void);
+
+/**
+ * @brief Check whether system_jump_to_app() or system_jump_to_xip() was called.
+ * @return uint8_t 1: jumped, 0: not jumped.
+ */
+uint8_t host_system_jumped(void);
+
+/**
+ * @brief Vector table of the last jump, USER_APP_START for system_jump_to_app()
+ *        or the SPIM window address given to system_jump_to_xip().
+ */
+uint32_t host_system_jump_vectors(void);
+
+/**
+ * @brief State of the boot LED.
+ * @return uint8_t 1: bootLED_on() last, 0: off.
+ */
+uint8_t host_system_led(void);
+
+/*******************************************************************************
+ * Backend Helper
+ ******************************************************************************/
+/**
+ * @brief Map a memory image for an emulated flash array.
+ * @param path backing file, NULL for an anonymous (RAM) mapping.
+ * @param size image size in bytes.
+ * @return uint8_t* mapped image, NULL if failed.
+ *
+ *  NOTE: Newly created images are filled with 0xFF (erased).
+ */
+uint8_t *host_map_image(const char *path, uint32_t size);
+
+/**
+ * @brief Unmap an image from host_map_image(), flushing it to its file.
+ */
+void host_unmap_image(uint8_t *image, uint32_t size);
+
+#endif /* HOST_H */
@@ -0,0 +1,183 @@
+/**
+ * @file host_commuch.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - communication channel over a file descriptor.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "commuch.h"
+#include "host.h"
+
+static int com_fd = -1;
+static uint32_t line_baud = COM_CHANNEL_BAUD_DEFAULT;
+
+static uint8_t *rx_dst;  // com_channel_read_async() receive
+static uint32_t rx_dst_len;
+
+/*******************************************************************************
+ * Host Control
+ ******************************************************************************/
+void host_com_channel_open(int fd)
+{
+    com_fd = fd;
+}
+
+const char *host_com_channel_open_pty(void)
+{
+    struct termios tio;
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd < 0 || grantpt(fd) || unlockpt(fd)) {
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+
+    // raw 8n1, the bootloader protocol is binary
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    com_fd = fd;
+    return ptsname(fd);
+}
+
+/*******************************************************************************
+ * Communication Channel
+ ******************************************************************************/
+void com_channel_init(void)
+{
+    line_baud = COM_CHANNEL_BAUD_DEFAULT;
+}
+
+void com_channel_deinit(void)
+{
+}
+
+void com_channel_putc(uint8_t data)
+{
+    while (write(com_fd, &data, 1) != 1) {
+        if (errno != EINTR)
+            pthread_exit(NULL);
+    }
+    host_stats.uart_tx_bytes++;
+}
+
+void com_channel_write_async(const uint8_t *buf, uint32_t n,
+                             com_channel_done_t done)
+{
+    uint32_t count = 0;
+
+    while (count < n) {
+        ssize_t len = write(com_fd, buf + count, n - count);
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len <= 0)
+            pthread_exit(NULL);
+        count += len;
+    }
+    host_stats.uart_tx_bytes += n;
+    if (done)
+        done();
+}
+
+void com_channel_write(const uint8_t *buf, uint32_t n)
+{
+    com_channel_write_async(buf, n, NULL);
+}
+
+void com_channel_flush(void)
+{
+}
+
+uint8_t com_channel_getc(void)
+{
+    uint8_t data;
+    ssize_t res;
+
+    while ((res = read(com_fd, &data, 1)) != 1) {
+        // the programmer is gone, nothing is left for the bootloader to serve
+        if (res == 0 || errno != EINTR)
+            pthread_exit(NULL);
+    }
+    host_stats.uart_rx_bytes++;
+    return data;
+}
+
+uint32_t com_channel_read(uint8_t *buf, uint32_t n, uint32_t timeout_ms)
+{
+    struct pollfd pfd = {.fd = com_fd, .events = POLLIN};
+    int timeout = (timeout_ms == COM_CHANNEL_WAIT_FOREVER) ? -1 : timeout_ms;
+    uint32_t count = 0;
+
+    while (count < n) {
+        int res = poll(&pfd, 1, timeout);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res < 0)
+            pthread_exit(NULL);
+        if (res == 0)
+            break;
+
+        ssize_t len = read(com_fd, buf + count, n - count);
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len <= 0)
+            pthread_exit(NULL);
+        count += len;
+    }
+    host_stats.uart_rx_bytes += count;
+    return count;
+}
+
+uint32_t com_channel_available(void)
+{
+    int n = 0;
+
+    if (ioctl(com_fd, FIONREAD, &n) < 0)
+        return 0;
+    return n;
+}
+
+void com_channel_read_async(uint8_t *buf, uint32_t n)
+{
+    // no ISR here, the bytes are read when the receive is waited for
+    rx_dst = buf;
+    rx_dst_len = n;
+}
+
+uint32_t com_channel_read_wait(uint32_t timeout_ms)
+{
+    uint32_t count = com_channel_read(rx_dst, rx_dst_len, timeout_ms);
+
+    host_stats.uart_rx_async += count;
+    rx_dst_len = 0;
+    return count;
+}
+
+void com_channel_set_baud(uint32_t baud)
+{
+    // a pty or socketpair has no line rate, only remember it
+    line_baud = baud;
+}
+
+uint32_t com_channel_get_baud(void)
+{
+    return line_baud;
+}
+
+uint32_t com_channel_overruns(void)
+{
+    // the host channel is flow controlled, nothing is ever lost
+    return 0;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file host_crc32.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - software CRC-32, bit-exact with the CRC engine setup
+ *        in crc32.c.
+ */
+
+#include "crc32.h"
+
+/* CRC of every nibble value, reflected polynomial 0xEDB88320 */
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint32_t crc32_update(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0xF];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0xF];
+    }
+    return ~crc;
+}
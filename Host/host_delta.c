@@ -0,0 +1,130 @@
+/**
+ * @file host_delta.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - delta generator for CMD_FLASH_DELTA_*.
+ *
+ * Greedy matcher: every 4-byte aligned 16-byte block of the old image is
+ * hashed, each position of the new image is looked up and the longest match
+ * (extended backwards over pending literals) becomes a COPY when it pays off.
+ */
+
+#include "host_delta.h"
+#include <stdlib.h>
+#include <string.h>
+#include "delta.h"
+
+#define BLOCK      16
+#define STEP       4
+#define MIN_COPY   32  // shorter matches are cheaper as literals
+#define HASH_BITS  16
+#define CHAIN_MAX  32  // candidates tried per position, bounds 0xFF runs
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static uint32_t block_hash(const uint8_t *p)
+{
+    uint32_t h = 2166136261u;  // FNV-1a
+
+    for (int i = 0; i < BLOCK; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+    return p + 4;
+}
+
+static uint8_t *emit_insert(uint8_t *ops, const uint8_t *data, uint32_t len)
+{
+    while (len) {
+        uint32_t n = len;
+        if (n > HOST_DELTA_INSERT_MAX)
+            n = HOST_DELTA_INSERT_MAX;
+        *ops++ = DELTA_OP_INSERT;
+        *ops++ = n & 0xFF;
+        *ops++ = n >> 8;
+        memcpy(ops, data, n);
+        ops += n;
+        data += n;
+        len -= n;
+    }
+    return ops;
+}
+
+static uint8_t *emit_copy(uint8_t *ops, uint32_t src, uint32_t len)
+{
+    *ops++ = DELTA_OP_COPY;
+    ops = put_le32(ops, src);
+    return put_le32(ops, len);
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint32_t host_delta_encode(const uint8_t *old,
+                           uint32_t old_len,
+                           const uint8_t *new,
+                           uint32_t new_len,
+                           uint8_t *ops)
+{
+    uint32_t blocks = (old_len >= BLOCK) ? (old_len - BLOCK) / STEP + 1 : 0;
+    uint32_t *head = calloc(1u << HASH_BITS, sizeof(uint32_t));
+    uint32_t *next = calloc(blocks + 1, sizeof(uint32_t));
+    uint8_t *out = ops;
+    uint32_t pos = 0, lit = 0;
+
+    if (!head || !next) {
+        free(head);
+        free(next);
+        return 0;
+    }
+
+    // chains hold block index + 1, 0 ends a chain
+    for (uint32_t b = blocks; b-- > 0;) {
+        uint32_t h = block_hash(old + b * STEP);
+        next[b + 1] = head[h];
+        head[h] = b + 1;
+    }
+
+    while (pos + BLOCK <= new_len) {
+        uint32_t best_len = 0, best_src = 0, tries = 0;
+
+        for (uint32_t c = head[block_hash(new + pos)]; c && tries < CHAIN_MAX;
+             c = next[c], tries++) {
+            uint32_t src = (c - 1) * STEP, len = 0;
+            while (pos + len < new_len && src + len < old_len &&
+                   new[pos + len] == old[src + len])
+                len++;
+            if (len > best_len) {
+                best_len = len;
+                best_src = src;
+            }
+        }
+
+        if (best_len < MIN_COPY) {
+            pos++;
+            continue;
+        }
+
+        // the match may start inside the pending literals
+        while (pos > lit && best_src > 0 && new[pos - 1] == old[best_src - 1]) {
+            pos--;
+            best_src--;
+            best_len++;
+        }
+
+        out = emit_insert(out, new + lit, pos - lit);
+        out = emit_copy(out, best_src, best_len);
+        pos += best_len;
+        lit = pos;
+    }
+    out = emit_insert(out, new + lit, new_len - lit);
+
+    free(head);
+    free(next);
+    return out - ops;
+}
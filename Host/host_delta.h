@@ -0,0 +1,39 @@
+/**
+ * @file host_delta.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - delta generator for CMD_FLASH_DELTA_*.
+ */
+
+#ifndef HOST_DELTA_H
+#define HOST_DELTA_H
+
+#include <stdint.h>
+
+/**
+ * @brief Longest INSERT op emitted, keeps every op inside one packet.
+ */
+#define HOST_DELTA_INSERT_MAX 256
+
+/**
+ * @brief Worst-case op stream size of a new image of len bytes.
+ */
+#define HOST_DELTA_BOUND(len) \
+    ((len) + 3 * (((len) + HOST_DELTA_INSERT_MAX - 1) / HOST_DELTA_INSERT_MAX))
+
+/**
+ * @brief Encode new as COPY / INSERT ops against old, see delta.h.
+ * @param old image currently in APROM, from USER_APP_START.
+ * @param old_len old image length.
+ * @param new image to install.
+ * @param new_len new image length.
+ * @param ops op stream, at least HOST_DELTA_BOUND(new_len) bytes.
+ * @return uint32_t op stream length.
+ */
+uint32_t host_delta_encode(const uint8_t *old,
+                           uint32_t old_len,
+                           const uint8_t *new,
+                           uint32_t new_len,
+                           uint8_t *ops);
+
+#endif /* HOST_DELTA_H */
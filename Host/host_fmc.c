@@ -0,0 +1,276 @@
+/**
+ * @file host_fmc.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - emulated FMC and APROM.
+ *
+ * Program operations can only clear bits, as on the real flash array. Erase
+ * sets the page to 0xFF. APROM writes fail unless ISP and APROM update are
+ * enabled, just like FMC_Open() / FMC_ENABLE_AP_UPDATE() on the board.
+ */
+
+#include <string.h>
+#include "NuMicro.h"
+#include "host.h"
+
+int32_t g_FMC_i32ErrCode;
+
+static uint8_t *aprom;
+static int isp_enabled;
+static int ap_update_enabled;
+static uint32_t mp_burst;  // bytes a multi-word burst gets, 0: a whole row
+static uint32_t fail_at = 0xFFFFFFFF;  // FMC_Write() here fails
+
+/* ISP checksum engine, CRC-32 shifted MSB first as the CRC peripheral with
+ * CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM, see flash.c */
+#define CKS_POLY 0x04C11DB7UL
+#define CKS_SEED 0xFFFFFFFFUL
+#define CKS_COM  0xFFFFFFFFUL
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static int32_t fmc_check(uint32_t addr, uint32_t bytes, uint32_t align)
+{
+    if (!aprom || !isp_enabled || (addr % align) ||
+        (addr + bytes > FMC_APROM_END) || (addr + bytes < addr)) {
+        g_FMC_i32ErrCode = -1;
+        return -1;
+    }
+    g_FMC_i32ErrCode = 0;
+    return 0;
+}
+
+static void fmc_program(uint32_t addr, const void *data, uint32_t bytes)
+{
+    uint8_t *dst = aprom + addr;
+    const uint8_t *src = data;
+
+    // programming only clears bits
+    for (uint32_t i = 0; i < bytes; i++)
+        dst[i] &= src[i];
+}
+
+static uint32_t cks_reverse(uint32_t v, int bits)
+{
+    uint32_t r = 0;
+
+    for (int i = 0; i < bits; i++, v >>= 1)
+        r = (r << 1) | (v & 1);
+    return r;
+}
+
+/**
+ * @brief The engine bit by bit: each byte reversed into the top of the
+ *        register, the register reversed and complemented at the end.
+ */
+static uint32_t cks_run(const uint8_t *buf, uint32_t len)
+{
+    uint32_t reg = CKS_SEED;
+
+    for (uint32_t i = 0; i < len; i++) {
+        reg ^= cks_reverse(buf[i], 8) << 24;
+        for (int bit = 0; bit < 8; bit++)
+            reg = (reg & 0x80000000UL) ? (reg << 1) ^ CKS_POLY : reg << 1;
+    }
+    return cks_reverse(reg, 32) ^ CKS_COM;
+}
+
+static int32_t fmc_erase(uint32_t addr, uint32_t bytes)
+{
+    if (fmc_check(addr, bytes, bytes) || !ap_update_enabled) {
+        g_FMC_i32ErrCode = -1;
+        return -1;
+    }
+    host_stats.fmc_isp_erase++;
+    if (addr < FMC_APROM_BANK0_END)
+        host_stats.fmc_bank0_erase++;
+    memset(aprom + addr, 0xFF, bytes);
+    return 0;
+}
+
+/*******************************************************************************
+ * Host Control
+ ******************************************************************************/
+int host_fmc_open(const char *path)
+{
+    host_fmc_close();
+    aprom = host_map_image(path, HOST_APROM_SIZE);
+    mp_burst = 0;
+    fail_at = 0xFFFFFFFF;
+    return aprom ? 0 : -1;
+}
+
+void host_fmc_close(void)
+{
+    if (aprom)
+        host_unmap_image(aprom, HOST_APROM_SIZE);
+    aprom = NULL;
+}
+
+uint8_t *host_fmc_mem(void)
+{
+    return aprom;
+}
+
+void host_fmc_set_mp_burst(uint32_t bytes)
+{
+    mp_burst = bytes;
+}
+
+void host_fmc_set_fail(uint32_t addr)
+{
+    fail_at = addr;
+}
+
+void host_fmc_set_ap_update(int enable)
+{
+    ap_update_enabled = enable;
+}
+
+/*******************************************************************************
+ * FMC API
+ ******************************************************************************/
+void FMC_Open(void)
+{
+    isp_enabled = 1;
+}
+
+void FMC_Close(void)
+{
+    isp_enabled = 0;
+}
+
+int32_t FMC_Erase(uint32_t u32PageAddr)
+{
+    return fmc_erase(u32PageAddr, FMC_FLASH_PAGE_SIZE);
+}
+
+int32_t FMC_Erase_Block(uint32_t u32BlockAddr)
+{
+    return fmc_erase(u32BlockAddr, FMC_FLASH_PAGE_SIZE * 4);
+}
+
+uint32_t FMC_Read(uint32_t u32Addr)
+{
+    uint32_t data;
+
+    if (fmc_check(u32Addr, 4, 4))
+        return 0xFFFFFFFF;
+    host_stats.fmc_isp_read++;
+    memcpy(&data, aprom + u32Addr, 4);
+    return data;
+}
+
+int32_t FMC_Write(uint32_t u32Addr, uint32_t u32Data)
+{
+    if (fmc_check(u32Addr, 4, 4) || !ap_update_enabled ||
+        u32Addr == fail_at) {
+        g_FMC_i32ErrCode = -1;
+        return -1;
+    }
+    host_stats.fmc_isp_program++;
+    if (u32Addr < FMC_APROM_BANK0_END)
+        host_stats.fmc_bank0_program++;
+    fmc_program(u32Addr, &u32Data, 4);
+    return 0;
+}
+
+int32_t FMC_Write8Bytes(uint32_t u32addr, uint32_t u32data0, uint32_t u32data1)
+{
+    uint32_t data[2] = {u32data0, u32data1};
+
+    if (fmc_check(u32addr, 8, 8) || !ap_update_enabled) {
+        g_FMC_i32ErrCode = -1;
+        return -1;
+    }
+    host_stats.fmc_isp_program++;
+    if (u32addr < FMC_APROM_BANK0_END)
+        host_stats.fmc_bank0_program++;
+    fmc_program(u32addr, data, 8);
+    return 0;
+}
+
+int32_t FMC_WriteMultiple(uint32_t u32Addr, uint32_t pu32Buf[], uint32_t u32Len)
+{
+    static const uint8_t past[FMC_MULTI_WORD_PROG_LEN];  // beyond pu32Buf
+    const uint8_t *src = (const uint8_t *) pu32Buf;
+    int32_t retval = 0;
+
+    if (fmc_check(u32Addr, 8, 8) || !ap_update_enabled) {
+        g_FMC_i32ErrCode = -2;
+        return -2;
+    }
+    // the BSP counts a whole row from u32Addr, from inside a row the burst
+    // would run into the next one
+    if (u32Addr % FMC_MULTI_WORD_PROG_LEN) {
+        g_FMC_i32ErrCode = -2;
+        return -2;
+    }
+
+    u32Len -= u32Len % 8;
+    while (u32Len >= 8) {
+        uint32_t n = (u32Len < FMC_MULTI_WORD_PROG_LEN)
+                         ? u32Len
+                         : FMC_MULTI_WORD_PROG_LEN;
+        int cut = 0;
+
+        if (fmc_check(u32Addr, FMC_MULTI_WORD_PROG_LEN, 8)) {
+            g_FMC_i32ErrCode = -1;
+            return -1;
+        }
+
+        // one ISP trigger per burst, the data is fed by the CPU 8 bytes at a
+        // time while the trigger runs
+        host_stats.fmc_isp_program++;
+        if (u32Addr < FMC_APROM_BANK0_END)
+            host_stats.fmc_bank0_program++;
+
+        // the BSP feeds 16 bytes before it looks at the length: with 8 left
+        // u32Len wraps around and the burst goes on past the buffer
+        if (u32Len < 16) {
+            fmc_program(u32Addr, src, 8);
+            fmc_program(u32Addr + 8, past, FMC_MULTI_WORD_PROG_LEN - 8);
+            host_stats.fmc_isp_mp_data += FMC_MULTI_WORD_PROG_LEN / 8;
+            if (u32Addr < FMC_APROM_BANK0_END)
+                host_stats.fmc_bank0_mp_data += FMC_MULTI_WORD_PROG_LEN / 8;
+            g_FMC_i32ErrCode = -1;
+            return -1;
+        }
+
+        // an interrupt holding up the feed ends the burst early
+        if (mp_burst && mp_burst < n) {
+            n = mp_burst;
+            cut = 1;
+        }
+        host_stats.fmc_isp_mp_data += n / 8;
+        if (u32Addr < FMC_APROM_BANK0_END)
+            host_stats.fmc_bank0_mp_data += n / 8;
+        fmc_program(u32Addr, src, n);
+        src += n;
+        u32Addr += n;
+        u32Len -= n;
+        retval += n;
+
+        // the BSP returns after a burst that did not fill its row
+        if (cut || n < FMC_MULTI_WORD_PROG_LEN)
+            break;
+    }
+    return retval;
+}
+
+uint32_t FMC_GetChkSum(uint32_t u32addr, uint32_t u32count)
+{
+    if (fmc_check(u32addr, u32count, 512) || (u32count % 512)) {
+        g_FMC_i32ErrCode = -2;
+        return 0xFFFFFFFF;
+    }
+
+    // the engine reads the array itself, one run and one read trigger
+    host_stats.fmc_isp_cks +=
+        (u32count + FMC_FLASH_PAGE_SIZE - 1) / FMC_FLASH_PAGE_SIZE;
+    // whole pages only, ISPDAT reads 0 for an incorrect range
+    if ((u32addr | u32count) % FMC_FLASH_PAGE_SIZE)
+        return 0;
+    return cks_run(aprom + u32addr, u32count);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file host_pack.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - compressor for CMD_FLASH_UNPACK_*.
+ *
+ * Greedy matcher: every position is hashed by its first 4 bytes and chained
+ * to the previous one with the same hash, the longest match within the last
+ * UNPACK_WINDOW bytes becomes a sequence.
+ */
+
+#include "host_pack.h"
+#include <stdlib.h>
+#include <string.h>
+#include "unpack.h"
+
+#define HASH_BITS 16
+#define CHAIN_MAX 64  // candidates tried per position
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static uint32_t seq_hash(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, 4);
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *out, uint32_t len)
+{
+    for (len -= 15; len >= 255; len -= 255)
+        *out++ = 255;
+    *out++ = len;
+    return out;
+}
+
+/**
+ * @brief Emit a sequence, match_len 0 for the literals-only last one.
+ */
+static uint8_t *emit_sequence(uint8_t *out,
+                              const uint8_t *lit,
+                              uint32_t lit_len,
+                              uint32_t offset,
+                              uint32_t match_len)
+{
+    uint32_t ml = match_len ? match_len - UNPACK_MIN_MATCH : 0;
+    uint8_t *token = out++;
+
+    *token = ((lit_len < 15) ? lit_len : 15) << 4;
+    *token |= (ml < 15) ? ml : 15;
+    if (lit_len >= 15)
+        out = put_length(out, lit_len);
+    memcpy(out, lit, lit_len);
+    out += lit_len;
+    if (!match_len)
+        return out;
+
+    *out++ = offset & 0xFF;
+    *out++ = offset >> 8;
+    if (ml >= 15)
+        out = put_length(out, ml);
+    return out;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint32_t host_pack(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+    uint32_t *head = malloc(sizeof(uint32_t) << HASH_BITS);
+    uint32_t *prev = malloc(sizeof(uint32_t) * (len + 1));
+    uint8_t *p = out;
+    uint32_t pos = 0, lit = 0;
+
+    if (!head || !prev) {
+        free(head);
+        free(prev);
+        return 0;
+    }
+    memset(head, 0xFF, sizeof(uint32_t) << HASH_BITS);  // no position yet
+
+    while (pos + UNPACK_MIN_MATCH <= len) {
+        uint32_t h = seq_hash(in + pos);
+        uint32_t best_len = 0, best_ofs = 0, tries = 0;
+
+        for (uint32_t c = head[h];
+             c != 0xFFFFFFFF && pos - c <= UNPACK_WINDOW && tries < CHAIN_MAX;
+             c = prev[c], tries++) {
+            uint32_t n = 0;
+            while (pos + n < len && in[c + n] == in[pos + n])
+                n++;
+            if (n > best_len) {
+                best_len = n;
+                best_ofs = pos - c;
+            }
+        }
+        prev[pos] = head[h];
+        head[h] = pos;
+
+        if (best_len < UNPACK_MIN_MATCH) {
+            pos++;
+            continue;
+        }
+
+        p = emit_sequence(p, in + lit, pos - lit, best_ofs, best_len);
+
+        // the positions inside the match are candidates for later ones
+        for (uint32_t end = pos + best_len; ++pos < end;) {
+            if (pos + UNPACK_MIN_MATCH <= len) {
+                h = seq_hash(in + pos);
+                prev[pos] = head[h];
+                head[h] = pos;
+            }
+        }
+        lit = pos;
+    }
+    if (lit < len)
+        p = emit_sequence(p, in + lit, len - lit, 0, 0);
+
+    free(head);
+    free(prev);
+    return p - out;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file host_pack.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - compressor for CMD_FLASH_UNPACK_*.
+ */
+
+#ifndef HOST_PACK_H
+#define HOST_PACK_H
+
+#include <stdint.h>
+
+/**
+ * @brief Worst-case stream size of an image of len bytes.
+ */
+#define HOST_PACK_BOUND(len) ((len) + (len) / 255 + 16)
+
+/**
+ * @brief Compress an image into the sequence stream of unpack.h.
+ * @param in image data.
+ * @param len image length.
+ * @param out stream, at least HOST_PACK_BOUND(len) bytes.
+ * @return uint32_t stream length, 0 if failed.
+ */
+uint32_t host_pack(const uint8_t *in, uint32_t len, uint8_t *out);
+
+#endif /* HOST_PACK_H */
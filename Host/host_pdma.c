@@ -0,0 +1,221 @@
+/**
+ * @file host_pdma.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - PDMA channels serving the SPI2/QSPI0 requests.
+ *
+ * A channel is armed by PDMA_SetTransferMode() in basic mode and waits for the
+ * request source it was given. SPI_TRIGGER_TX_RX_PDMA() runs the armed TX and
+ * RX channels of that port byte by byte through the emulated flash, then sets
+ * their transfer done flags and calls PDMA_IRQHandler() if one of them has the
+ * interrupt enabled. The peripheral side addresses are not used, the request
+ * source tells the port.
+ *
+ * With host_pdma_set_overlap() the transfer stays in flight, its interrupt
+ * held back, until the CPU waits for it in __WFI(), drives /CS or triggers
+ * the next one.
+ */
+
+#include <string.h>
+#include "NuMicro.h"
+#include "host.h"
+
+struct host_pdma {
+    uint32_t chctl;
+    uint32_t inten;
+    uint32_t tdsts;
+    uint32_t abtsts;
+    struct {
+        uintptr_t sa;
+        uintptr_t da;
+        uint32_t ctl;
+        uint32_t cnt;
+        uint32_t req;
+        uint8_t armed;
+    } dsct[PDMA_CH_MAX];
+};
+
+PDMA_T host_pdma;
+
+/* The transfer in flight, see host_pdma_set_overlap(). */
+static host_pdma_overlap_t overlap_fn;
+static int in_flight;
+static int irq_pending;
+static host_stats_t flight;       // counters of the transfer
+static host_stats_t flight_mark;  // host_stats when it was triggered
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static int pdma_find(PDMA_T *pdma, uint32_t req)
+{
+    for (uint32_t ch = 0; ch < PDMA_CH_MAX; ch++) {
+        if ((pdma->chctl & (1UL << ch)) && pdma->dsct[ch].armed &&
+            pdma->dsct[ch].req == req)
+            return ch;
+    }
+    return -1;
+}
+
+/**
+ * @brief d = a - b field by field, 0 where a counter was reset meanwhile.
+ */
+static void pdma_stats_sub(host_stats_t *d, const host_stats_t *a,
+                           const host_stats_t *b)
+{
+    const uint64_t *pa = (const uint64_t *) a;
+    const uint64_t *pb = (const uint64_t *) b;
+    uint64_t *pd = (uint64_t *) d;
+
+    for (uint32_t i = 0; i < sizeof(host_stats_t) / sizeof(uint64_t); i++)
+        pd[i] = (pa[i] >= pb[i]) ? pa[i] - pb[i] : pa[i];
+}
+
+/*******************************************************************************
+ * PDMA Driver
+ ******************************************************************************/
+void PDMA_Open(PDMA_T *pdma, uint32_t u32Mask)
+{
+    for (uint32_t ch = 0; ch < PDMA_CH_MAX; ch++) {
+        if (u32Mask & (1UL << ch))
+            memset(&pdma->dsct[ch], 0, sizeof(pdma->dsct[ch]));
+    }
+    pdma->chctl |= u32Mask;
+}
+
+void PDMA_SetTransferCnt(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32Width,
+                         uint32_t u32TransCount)
+{
+    (void) u32Width;  // 8-bit only
+    pdma->dsct[u32Ch].cnt = u32TransCount;
+}
+
+void PDMA_SetTransferAddr(PDMA_T *pdma, uint32_t u32Ch, uintptr_t u32SrcAddr,
+                          uint32_t u32SrcCtrl, uintptr_t u32DstAddr,
+                          uint32_t u32DstCtrl)
+{
+    pdma->dsct[u32Ch].sa = u32SrcAddr;
+    pdma->dsct[u32Ch].da = u32DstAddr;
+    pdma->dsct[u32Ch].ctl = u32SrcCtrl | u32DstCtrl;
+}
+
+void PDMA_SetTransferMode(PDMA_T *pdma, uint32_t u32Ch,
+                          uint32_t u32Peripheral, uint32_t u32ScatterEn,
+                          uint32_t u32DescAddr)
+{
+    (void) u32ScatterEn;  // basic mode only
+    (void) u32DescAddr;
+    pdma->dsct[u32Ch].req = u32Peripheral;
+    pdma->dsct[u32Ch].armed = 1;
+}
+
+void PDMA_SetBurstType(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32BurstType,
+                       uint32_t u32BurstSize)
+{
+    (void) pdma;
+    (void) u32Ch;
+    (void) u32BurstType;
+    (void) u32BurstSize;
+}
+
+void PDMA_EnableInt(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32Mask)
+{
+    (void) u32Mask;  // transfer done only
+    pdma->inten |= 1UL << u32Ch;
+}
+
+void PDMA_DisableInt(PDMA_T *pdma, uint32_t u32Ch, uint32_t u32Mask)
+{
+    (void) u32Mask;
+    pdma->inten &= ~(1UL << u32Ch);
+}
+
+/*******************************************************************************
+ * PDMA Register Access
+ ******************************************************************************/
+uint32_t host_pdma_get_sts(PDMA_T *pdma, int abort)
+{
+    return abort ? pdma->abtsts : pdma->tdsts;
+}
+
+void host_pdma_clr_sts(PDMA_T *pdma, int abort, uint32_t mask)
+{
+    if (abort)
+        pdma->abtsts &= ~mask;
+    else
+        pdma->tdsts &= ~mask;
+}
+
+void host_pdma_set_overlap(host_pdma_overlap_t fn)
+{
+    host_pdma_land();
+    overlap_fn = fn;
+}
+
+void host_pdma_land(void)
+{
+    host_stats_t meanwhile;
+
+    if (in_flight) {
+        in_flight = 0;
+        pdma_stats_sub(&meanwhile, &host_stats, &flight_mark);
+        if (overlap_fn)
+            overlap_fn(&flight, &meanwhile);
+    }
+    if (irq_pending) {
+        irq_pending = 0;
+        PDMA_IRQHandler();
+    }
+}
+
+void host_pdma_wfi(void)
+{
+    host_pdma_land();
+}
+
+void host_pdma_service(SPI_T *spi, uint32_t tx_req, uint32_t rx_req)
+{
+    PDMA_T *pdma = &host_pdma;
+    int tx = pdma_find(pdma, tx_req);
+    int rx = pdma_find(pdma, rx_req);
+    uint32_t done = 0;
+    host_stats_t start;
+
+    // the master only clocks what the TX channel writes
+    if (tx < 0)
+        return;
+    host_pdma_land();
+    start = host_stats;
+
+    const uint8_t *src = (const uint8_t *) pdma->dsct[tx].sa;
+    uint32_t src_fix = (pdma->dsct[tx].ctl & PDMA_SAR_FIX) == PDMA_SAR_FIX;
+    uint32_t n = pdma->dsct[tx].cnt;
+
+    for (uint32_t i = 0; i < n; i++) {
+        host_spi_write_tx(spi, src[src_fix ? 0 : i]);
+        if (rx >= 0 && i < pdma->dsct[rx].cnt) {
+            uint8_t *dst = (uint8_t *) pdma->dsct[rx].da;
+            uint32_t dst_fix =
+                (pdma->dsct[rx].ctl & PDMA_DAR_FIX) == PDMA_DAR_FIX;
+            dst[dst_fix ? 0 : i] = host_spi_read_rx(spi);
+        }
+    }
+    host_stats.spi_pdma_bytes += n;
+    if (overlap_fn) {
+        pdma_stats_sub(&flight, &host_stats, &start);
+        flight_mark = host_stats;
+        in_flight = 1;
+    }
+
+    pdma->dsct[tx].armed = 0;
+    done |= 1UL << tx;
+    if (rx >= 0) {
+        pdma->dsct[rx].armed = 0;
+        done |= 1UL << rx;
+    }
+    pdma->tdsts |= done;
+    if ((pdma->inten & done) && in_flight)
+        irq_pending = 1;  // when the CPU waits for it
+    else if (pdma->inten & done)
+        PDMA_IRQHandler();
+}
@@ -0,0 +1,550 @@
+/**
+ * @file host_prog.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - programmer side of the boot protocol.
+ */
+
+#include "host_prog.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "boot_system.h"
+#include "bootprotocol.h"
+#include "crc32.h"
+#include "delta.h"
+#include "device.h"
+#include "host.h"
+#include "mbedtls/sha256.h"
+#include "slot.h"
+
+static pthread_t device_thread;
+static int device_fd = -1;
+static uint8_t prog_version = BL_PROTOCOL_V1;
+static uint16_t prog_pgsz = 512;
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static void *device_main(void *arg)
+{
+    APROM_update_enable();
+    establish_connection();
+    bl_command_process();
+    return NULL;
+}
+
+static int write_all(int fd, const uint8_t *buf, uint32_t len)
+{
+    while (len) {
+        ssize_t res = write(fd, buf, len);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return -1;
+        buf += res;
+        len -= res;
+    }
+    return 0;
+}
+
+static int read_all(int fd, uint8_t *buf, uint32_t len)
+{
+    while (len) {
+        ssize_t res = read(fd, buf, len);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return -1;
+        buf += res;
+        len -= res;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int host_device_start(void)
+{
+    int sv[2];
+
+    // a closed peer must end the bootloader thread, not the whole process
+    signal(SIGPIPE, SIG_IGN);
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+        return -1;
+    device_fd = sv[1];
+    host_com_channel_open(device_fd);
+    if (pthread_create(&device_thread, NULL, device_main, NULL)) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    return sv[0];
+}
+
+void host_device_stop(int fd)
+{
+    shutdown(fd, SHUT_RDWR);
+    pthread_join(device_thread, NULL);
+    close(device_fd);
+    close(fd);
+}
+
+static int prog_put(int fd,
+                    uint8_t cmd,
+                    const uint8_t *data,
+                    uint16_t len,
+                    uint8_t corrupt)
+{
+    uint8_t head[6] = {HEADER, HEADER, HEADER, cmd, len >> 8, len & 0xFF};
+    uint8_t chksum = corrupt;
+    uint32_t crc;
+
+    if (prog_version == BL_PROTOCOL_V2) {
+        head[0] = head[1] = head[2] = HEADER_V2;
+        crc = crc32_update(crc32_update(0, head, 6), data, len) ^ corrupt;
+        if (write_all(fd, head, sizeof(head)) || write_all(fd, data, len) ||
+            write_all(fd, (uint8_t *) &crc, 4))
+            return -1;
+        return 0;
+    }
+
+    for (uint16_t i = 0; i < len; i++)
+        chksum += data[i];
+
+    if (write_all(fd, head, sizeof(head)) || write_all(fd, data, len) ||
+        write_all(fd, &chksum, 1))
+        return -1;
+    return 0;
+}
+
+void host_prog_set_version(uint8_t version)
+{
+    prog_version = version;
+}
+
+int host_prog_put(int fd, uint8_t cmd, const uint8_t *data, uint16_t len)
+{
+    return prog_put(fd, cmd, data, len, 0);
+}
+
+int host_prog_get(int fd, uint8_t *cmd, uint8_t *data, uint16_t *len)
+{
+    uint8_t head[6];
+    uint8_t header = (prog_version == BL_PROTOCOL_V2) ? HEADER_V2 : HEADER;
+    uint8_t chksum = 0, sum;
+    uint32_t crc;
+
+    if (read_all(fd, head, sizeof(head)))
+        return -1;
+    if (head[0] != header || head[1] != header || head[2] != header)
+        return -1;
+
+    *cmd = head[3];
+    *len = (head[4] << 8) | head[5];
+    if (read_all(fd, data, *len))
+        return -1;
+
+    if (prog_version == BL_PROTOCOL_V2) {
+        if (read_all(fd, (uint8_t *) &crc, 4))
+            return -1;
+        crc ^= crc32_update(crc32_update(0, head, 6), data, *len);
+        return crc ? -1 : 0;
+    }
+
+    if (read_all(fd, &sum, 1))
+        return -1;
+    for (uint16_t i = 0; i < *len; i++)
+        chksum += data[i];
+    return (chksum == sum) ? 0 : -1;
+}
+
+int host_prog_cmd(int fd,
+                  uint8_t cmd,
+                  const uint8_t *data,
+                  uint16_t len,
+                  uint8_t *resp,
+                  uint16_t *resp_len)
+{
+    static uint8_t buf[65536];
+    uint8_t rcmd;
+    uint16_t rlen;
+
+    if (host_prog_put(fd, cmd, data, len) ||
+        host_prog_get(fd, &rcmd, buf, &rlen) || rlen == 0)
+        return -1;
+
+    if (resp)
+        memcpy(resp, buf, rlen);
+    if (resp_len)
+        *resp_len = rlen;
+    return buf[0];
+}
+
+int host_prog_set_baud(int fd, uint32_t baud)
+{
+    uint8_t resp[16];
+    uint16_t len;
+
+    if (host_prog_cmd(fd, CMD_SET_BAUD, (uint8_t *) &baud, 4, resp, &len) !=
+            ACK ||
+        len != 10)
+        return -1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK)
+        return -1;
+    return 0;
+}
+
+int host_prog_set_pgsz(int fd, uint16_t size)
+{
+    uint8_t resp[16];
+    uint16_t len;
+
+    if (host_prog_cmd(fd, CMD_FLASH_SET_PGSZ, (uint8_t *) &size, 2, NULL,
+                      NULL) != ACK ||
+        host_prog_cmd(fd, CMD_FLASH_GET_PGSZ, NULL, 0, resp, &len) != ACK ||
+        len != 3 || (resp[1] | (resp[2] << 8)) != size)
+        return -1;
+    prog_pgsz = size;
+    return 0;
+}
+
+int host_prog_erase(int fd, uint32_t addr, uint32_t len)
+{
+    uint8_t pac[8];
+
+    len = (len + HOST_SYNC_PAGE - 1) & ~(HOST_SYNC_PAGE - 1UL);
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &len, 4);
+    if (host_prog_cmd(fd, CMD_FLASH_ERASE_SECTOR, pac, 8, NULL, NULL) != ACK)
+        return -1;
+    return 0;
+}
+
+int host_prog_write_window(int fd,
+                           uint32_t addr,
+                           const uint8_t *image,
+                           uint32_t len,
+                           uint8_t window,
+                           int32_t corrupt_seq,
+                           uint32_t *syncs)
+{
+    static uint8_t pac[8 + 4096];
+    static uint8_t resp[65536];
+    uint32_t pgsz = prog_pgsz;
+    uint32_t count = len / pgsz;
+    uint32_t next = 0, acked = 0, inflight = 0;
+    uint8_t rcmd;
+    uint16_t rlen;
+    uint8_t *state;  // PAGE_TODO, PAGE_SENT or PAGE_DONE
+    int res = -1;
+
+    enum { PAGE_TODO, PAGE_SENT, PAGE_DONE };
+
+    if (count > 0xFFFF || !(state = calloc(count + 1, 1)))
+        return -1;
+    if (syncs)
+        *syncs = 0;
+
+    pac[0] = window;
+    if (host_prog_cmd(fd, CMD_FLASH_WINDOW_OPEN, pac, 1, resp, &rlen) != ACK ||
+        rlen != 2)
+        goto out;
+    window = resp[1];
+
+    while (acked < count) {
+        // keep the window full
+        while (next < count && inflight < window) {
+            if (state[next] != PAGE_TODO) {
+                next++;
+                continue;
+            }
+            uint32_t page_addr = addr + next * pgsz;
+            pac[0] = next & 0xFF;
+            pac[1] = next >> 8;
+            pac[2] = pac[3] = 0;
+            memcpy(pac + 4, &page_addr, 4);
+            memcpy(pac + 8, image + next * pgsz, pgsz);
+            if (prog_put(fd, CMD_FLASH_WINDOW_WRITE, pac, 8 + pgsz,
+                         (int32_t) next == corrupt_seq))
+                goto out;
+            if ((int32_t) next == corrupt_seq)
+                corrupt_seq = -1;
+            state[next++] = PAGE_SENT;
+            inflight++;
+        }
+
+        // everything is in flight, ask for the missing ones
+        uint8_t sync = (next == count);
+        if (sync) {
+            pac[0] = count & 0xFF;
+            pac[1] = count >> 8;
+            if (host_prog_put(fd, CMD_FLASH_WINDOW_SYNC, pac, 2))
+                goto out;
+            if (syncs)
+                (*syncs)++;
+        }
+
+        do {
+            if (host_prog_get(fd, &rcmd, resp, &rlen) || rlen != 3)
+                goto out;
+            uint16_t seq = resp[1] | (resp[2] << 8);
+            if (rcmd != CMD_FLASH_WINDOW_WRITE || seq >= count ||
+                state[seq] != PAGE_SENT)
+                continue;
+            state[seq] = (resp[0] == ACK) ? PAGE_DONE : PAGE_TODO;
+            acked += (resp[0] == ACK);
+            inflight--;
+            if (seq < next)
+                next = seq;
+        } while (sync && rcmd != CMD_FLASH_WINDOW_SYNC);
+
+        // the bootloader answered everything sent before the sync
+        if (sync) {
+            for (uint32_t seq = 0; seq < count; seq++) {
+                if (state[seq] == PAGE_SENT)
+                    state[seq] = PAGE_TODO;
+            }
+            inflight = 0;
+            next = 0;
+        }
+    }
+    res = 0;
+
+out:
+    free(state);
+    return res;
+}
+
+int host_prog_write_delta(int fd,
+                          const uint8_t *ops,
+                          uint32_t ops_len,
+                          uint32_t size,
+                          uint32_t crc,
+                          uint16_t *rewritten)
+{
+    static uint8_t pac[4 + 512];
+    uint8_t resp[16];
+    uint32_t pos = 0, ofs = 0;
+    uint16_t len;
+
+    memcpy(pac, &size, 4);
+    memcpy(pac + 4, &crc, 4);
+    if (host_prog_cmd(fd, CMD_FLASH_DELTA_BEGIN, pac, 8, NULL, NULL) != ACK)
+        return -1;
+
+    while (pos < ops_len) {
+        uint32_t start = ofs, n = 0;
+
+        // whole ops only, as many as fit into the packet
+        while (pos + n < ops_len) {
+            const uint8_t *op = ops + pos + n;
+            uint32_t op_len, out;
+            if (op[0] == DELTA_OP_COPY) {
+                op_len = DELTA_COPY_SIZE;
+                memcpy(&out, op + 5, 4);
+            } else {
+                out = op[1] | (op[2] << 8);
+                op_len = DELTA_INSERT_HEAD + out;
+            }
+            if (4 + n + op_len > sizeof(pac))
+                break;
+            n += op_len;
+            ofs += out;
+        }
+        if (n == 0)
+            return -1;
+
+        memcpy(pac, &start, 4);
+        memcpy(pac + 4, ops + pos, n);
+        if (host_prog_cmd(fd, CMD_FLASH_DELTA_DATA, pac, 4 + n, NULL, NULL) !=
+            ACK)
+            return -1;
+        pos += n;
+    }
+
+    if (host_prog_cmd(fd, CMD_FLASH_DELTA_END, NULL, 0, resp, &len) != ACK ||
+        len != 3)
+        return -1;
+    if (rewritten)
+        memcpy(rewritten, resp + 1, 2);
+    return 0;
+}
+
+int host_prog_write_packed(int fd,
+                           uint32_t addr,
+                           const uint8_t *stream,
+                           uint32_t stream_len,
+                           uint32_t size)
+{
+    static uint8_t pac[4 + 512];
+    uint8_t resp[16];
+    uint32_t written = 0;
+    uint16_t len;
+
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &size, 4);
+    if (host_prog_cmd(fd, CMD_FLASH_UNPACK_BEGIN, pac, 8, NULL, NULL) != ACK)
+        return -1;
+
+    // the stream is cut into full packets, sequences may span them
+    for (uint32_t ofs = 0; ofs < stream_len; ofs += 512) {
+        uint32_t n = (stream_len - ofs < 512) ? stream_len - ofs : 512;
+
+        memcpy(pac, &ofs, 4);
+        memcpy(pac + 4, stream + ofs, n);
+        if (host_prog_cmd(fd, CMD_FLASH_UNPACK_DATA, pac, 4 + n, resp, &len) !=
+                ACK ||
+            len != 5)
+            return -1;
+        memcpy(&written, resp + 1, 4);
+    }
+    return (written == size) ? 0 : -1;
+}
+
+int host_prog_verify(int fd, uint32_t addr, const uint8_t *image, uint32_t len)
+{
+    static const uint8_t pad[512] = {[0 ... 511] = 0xFF};
+    uint32_t range = (len + 511) & ~511UL;
+    uint32_t crc, dev_crc;
+    uint8_t pac[8], resp[16];
+    uint16_t resp_len;
+
+    crc = crc32_update(crc32_update(0, image, len), pad, range - len);
+
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &range, 4);
+    if (host_prog_cmd(fd, CMD_FLASH_VERIFY, pac, 8, resp, &resp_len) != ACK ||
+        resp_len != 5)
+        return -1;
+    memcpy(&dev_crc, resp + 1, 4);
+    return (dev_crc == crc) ? 0 : 1;
+}
+
+int host_prog_write_slot(int fd,
+                         uint8_t slot,
+                         uint32_t load,
+                         const uint8_t *image,
+                         uint32_t len)
+{
+    static uint8_t pac[4 + 4096];
+    uint32_t base = slot_base(slot);
+    uint32_t erase[2] = {base, EXT_FLASH_SLOT_SIZE};
+    slot_header_t hdr = {
+        .magic = SLOT_MAGIC,
+        .size = len,
+        .load = load,
+        .crc = crc32_update(0, image, len),
+    };
+
+    mbedtls_sha256(image, len, hdr.sha256, 0);
+    hdr.hdr_crc = crc32_update(0, (const uint8_t *) &hdr,
+                               offsetof(slot_header_t, hdr_crc));
+
+    if (host_prog_cmd(fd, CMD_EXT_FLASH_ERASE_SECTOR, (uint8_t *) erase,
+                      sizeof(erase), NULL, NULL) != ACK)
+        return -1;
+    for (uint32_t ofs = 0; ofs < len; ofs += 4096) {
+        uint32_t n = (len - ofs < 4096) ? len - ofs : 4096;
+        uint32_t addr = base + ofs;
+        memcpy(pac, &addr, 4);
+        memcpy(pac + 4, image + ofs, n);
+        if (host_prog_cmd(fd, CMD_EXT_FLASH_SLOT_WRITE, pac, 4 + n, NULL,
+                          NULL) != ACK)
+            return -1;
+    }
+
+    // the header last, a slot cut short has none
+    uint32_t addr = base + SLOT_HEADER_OFS;
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &hdr, sizeof(hdr));
+    if (host_prog_cmd(fd, CMD_EXT_FLASH_SLOT_WRITE, pac, 4 + sizeof(hdr), NULL,
+                      NULL) != ACK)
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Page of the image at ofs, padded with 0xFF.
+ */
+static void sync_page_fill(uint8_t *page,
+                           const uint8_t *image,
+                           uint32_t len,
+                           uint32_t ofs)
+{
+    memset(page, 0xFF, HOST_SYNC_PAGE);
+    if (ofs < len)
+        memcpy(page, image + ofs,
+               (len - ofs < HOST_SYNC_PAGE) ? len - ofs : HOST_SYNC_PAGE);
+}
+
+int host_prog_sync_app(int fd,
+                       const uint8_t *image,
+                       uint32_t len,
+                       uint16_t *rewritten)
+{
+    static uint8_t page[HOST_SYNC_PAGE];
+    static uint8_t pac[4 + HOST_SYNC_PAGE];
+    const uint32_t pages = (USER_APP_SIZE - USER_APP_START) / HOST_SYNC_PAGE;
+    uint8_t resp[32];
+    uint16_t resp_len, count = 0;
+
+    // the rows written must not reach into the next FMC page
+    if (len > USER_APP_SIZE - USER_APP_START || HOST_SYNC_PAGE % prog_pgsz)
+        return -1;
+
+    for (uint32_t first = 0; first < pages; first += BL_SYNC_PAGES_MAX) {
+        uint32_t n = pages - first;
+        uint32_t addr = USER_APP_START + first * HOST_SYNC_PAGE;
+
+        if (n > BL_SYNC_PAGES_MAX)
+            n = BL_SYNC_PAGES_MAX;
+
+        // manifest: the CRC-32 of every page, padded with 0xFF
+        memcpy(pac, &addr, 4);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t ofs = (first + i) * HOST_SYNC_PAGE;
+            uint32_t crc;
+            sync_page_fill(page, image, len, ofs);
+            crc = crc32_update(0, page, HOST_SYNC_PAGE);
+            memcpy(pac + 4 + i * 4, &crc, 4);
+        }
+        if (host_prog_cmd(fd, CMD_FLASH_SYNC_PAGE, pac, 4 + n * 4, resp,
+                          &resp_len) != ACK ||
+            resp_len != 1 + (n + 7) / 8)
+            return -1;
+
+        // the erased pages need their content, all 0xFF rows are done
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t ofs = (first + i) * HOST_SYNC_PAGE;
+
+            if (!(resp[1 + i / 8] & (1 << (i % 8))))
+                continue;
+            count++;
+            sync_page_fill(page, image, len, ofs);
+            for (uint32_t row = 0; row < HOST_SYNC_PAGE; row += prog_pgsz) {
+                uint32_t row_addr = USER_APP_START + ofs + row;
+                uint32_t j = 0;
+                while (j < prog_pgsz && page[row + j] == 0xFF)
+                    j++;
+                if (j == prog_pgsz)
+                    continue;
+                memcpy(pac, &row_addr, 4);
+                memcpy(pac + 4, page + row, prog_pgsz);
+                if (host_prog_cmd(fd, CMD_FLASH_WRITE, pac, 4 + prog_pgsz,
+                                  NULL, NULL) != ACK)
+                    return -1;
+            }
+        }
+    }
+
+    if (rewritten)
+        *rewritten = count;
+    return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file host_prog.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - programmer side of the boot protocol.
+ *
+ * Minimal programmer used by the host tests and benchmarks. The bootloader
+ * runs in its own thread and talks to the programmer over a socketpair.
+ */
+
+#ifndef HOST_PROG_H
+#define HOST_PROG_H
+
+#include <stdint.h>
+
+/**
+ * @brief Start the bootloader thread.
+ *
+ *  - APROM_update_enable()
+ *  - establish_connection()
+ *  - bl_command_process()
+ *
+ * @return int programmer end of the channel, -1 if failed.
+ */
+int host_device_start(void);
+
+/**
+ * @brief Close the channel and wait for the bootloader thread to finish.
+ * @param fd programmer end returned by host_device_start().
+ */
+void host_device_stop(int fd);
+
+/**
+ * @brief Select the framing of the following packets.
+ * @param version BL_PROTOCOL_V1 (default) or BL_PROTOCOL_V2.
+ */
+void host_prog_set_version(uint8_t version);
+
+/**
+ * @brief Send a packet to the bootloader.
+ * @return int 0: successed, -1: failed.
+ */
+int host_prog_put(int fd, uint8_t cmd, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Receive a packet from the bootloader.
+ * @param data buffer of at least 65535 bytes.
+ * @return int 0: successed, -1: failed (I/O error or bad checksum).
+ */
+int host_prog_get(int fd, uint8_t *cmd, uint8_t *data, uint16_t *len);
+
+/**
+ * @brief Send a command and wait for its response.
+ * @param resp response data buffer, NULL to discard.
+ * @param resp_len response data length, NULL to discard.
+ * @return int first response byte (ACK / NACK), -1 if failed.
+ */
+int host_prog_cmd(int fd,
+                  uint8_t cmd,
+                  const uint8_t *data,
+                  uint16_t len,
+                  uint8_t *resp,
+                  uint16_t *resp_len);
+
+/**
+ * @brief Negotiate a new line rate with CMD_SET_BAUD.
+ *
+ * The host channel has no line rate, the programmer only confirms the switch
+ * with the CMD_CHK_PROTOCOL ping.
+ *
+ * @param baud new baud rate.
+ * @return int 0: switched, -1: refused or not confirmed.
+ */
+int host_prog_set_baud(int fd, uint32_t baud);
+
+/**
+ * @brief Set the flash page size with CMD_FLASH_SET_PGSZ.
+ *
+ * The following windowed writes and page syncs use pages of this size.
+ *
+ * @param size 256 * N up to 4096.
+ * @return int 0: successed, -1: refused.
+ */
+int host_prog_set_pgsz(int fd, uint16_t size);
+
+/**
+ * @brief Schedule the FMC pages an image covers for erasing with
+ *        CMD_FLASH_ERASE_SECTOR.
+ * @param addr APROM address of the image, FMC page aligned.
+ * @param len image length, rounded up to whole FMC pages.
+ * @return int 0: successed, -1: refused.
+ */
+int host_prog_erase(int fd, uint32_t addr, uint32_t len);
+
+/**
+ * @brief Program an image with the windowed flash write commands.
+ * @param addr APROM address of the image, page aligned.
+ * @param image image data.
+ * @param len image length, multiple of the page size (host_prog_set_pgsz()).
+ * @param window number of packets kept in flight.
+ * @param corrupt_seq sequence number sent once with a bad checksum to
+ *        exercise the retransmission, -1 for none.
+ * @param syncs number of CMD_FLASH_WINDOW_SYNC round trips, NULL to discard.
+ * @return int 0: successed, -1: failed.
+ */
+int host_prog_write_window(int fd,
+                           uint32_t addr,
+                           const uint8_t *image,
+                           uint32_t len,
+                           uint8_t window,
+                           int32_t corrupt_seq,
+                           uint32_t *syncs);
+
+/**
+ * @brief Install an image with the delta update commands.
+ * @param ops op stream from host_delta_encode().
+ * @param ops_len op stream length.
+ * @param size new image size.
+ * @param crc CRC-32 of the new image.
+ * @param rewritten number of FMC pages the bootloader rewrote, NULL to
+ *        discard.
+ * @return int 0: successed, -1: failed.
+ */
+int host_prog_write_delta(int fd,
+                          const uint8_t *ops,
+                          uint32_t ops_len,
+                          uint32_t size,
+                          uint32_t crc,
+                          uint16_t *rewritten);
+
+/**
+ * @brief Program an image with the compressed flash write commands.
+ * @param addr APROM address of the image, page aligned and erased.
+ * @param stream compressed image from host_pack().
+ * @param stream_len compressed image length.
+ * @param size image length.
+ * @return int 0: successed, -1: failed.
+ */
+int host_prog_write_packed(int fd,
+                           uint32_t addr,
+                           const uint8_t *stream,
+                           uint32_t stream_len,
+                           uint32_t size);
+
+/**
+ * @brief Verify APROM against an image with CMD_FLASH_VERIFY.
+ * @param addr APROM address of the image, multiple of 512.
+ * @param image image data.
+ * @param len image length, the range checked is padded with 0xFF to a
+ *        multiple of 512.
+ * @return int 0: the range matches, 1: it differs, -1: failed.
+ */
+int host_prog_verify(int fd, uint32_t addr, const uint8_t *image, uint32_t len);
+
+/**
+ * @brief Store an image in a W25Q128JV slot with its header, see slot.h.
+ *
+ * Erases the slot, writes the image with CMD_EXT_FLASH_SLOT_WRITE and then
+ * the header.
+ *
+ * @param slot slot number.
+ * @param load APROM address CMD_PROG_EXT_FLASH_SLOT installs it to.
+ * @param image image data.
+ * @param len image length, multiple of 4.
+ * @return int 0: successed, -1: failed.
+ */
+int host_prog_write_slot(int fd,
+                         uint8_t slot,
+                         uint32_t load,
+                         const uint8_t *image,
+                         uint32_t len);
+
+/**
+ * @brief FMC page size the CMD_FLASH_SYNC_PAGE manifest is made of.
+ */
+#define HOST_SYNC_PAGE 4096
+
+/**
+ * @brief Install an image with the page sync command.
+ *
+ * Sends the manifest of the whole user app section, the image padded with
+ * 0xFF, then programs the pages the bootloader erased. The page size set by
+ * host_prog_set_pgsz() must divide HOST_SYNC_PAGE.
+ *
+ * @param image image data, placed at USER_APP_START.
+ * @param len image length.
+ * @param rewritten number of FMC pages erased and programmed, NULL to
+ *        discard.
+ * @return int 0: successed, -1: failed.
+ */
+int host_prog_sync_app(int fd,
+                       const uint8_t *image,
+                       uint32_t len,
+                       uint16_t *rewritten);
+
+#endif /* HOST_PROG_H */
@@ -0,0 +1,67 @@
+/**
+ * @file host_sha256_dma.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - SHA-256 parts hashed by the software path of
+ *        sha256_alt.c, same digest and part rules as the CRPT engine in
+ *        sha256_dma.c.
+ */
+
+#include "sha256_dma.h"
+#include "host.h"
+#include "mbedtls/sha256.h"
+
+#define FAILED    1
+#define SUCCESSED 0
+
+static mbedtls_sha256_context sha_ctx;
+static uint8_t sha_error;  // reported by the next sha256_dma_wait()
+static uint8_t sha_held;   // a digest is between start and digest
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+uint8_t sha256_dma_start(void)
+{
+    if (sha_held)
+        return FAILED;
+    sha_held = 1;
+
+    mbedtls_sha256_init(&sha_ctx);
+    mbedtls_sha256_starts(&sha_ctx, 0);
+    sha256_alt_software(&sha_ctx);  // this is the engine
+    sha_error = 0;
+    return SUCCESSED;
+}
+
+void sha256_dma_update(const uint8_t *buf, uint32_t len, uint8_t last)
+{
+    // the engine fetches words and cascades whole blocks only
+    if (((uintptr_t) buf & 3) || (!last && (len % SHA256_DMA_BLOCK))) {
+        sha_error = 1;
+        return;
+    }
+    mbedtls_sha256_update(&sha_ctx, buf, len);
+    host_stats.sha_dma_bytes += len;
+    host_stats.sha_dma_parts++;
+}
+
+uint8_t sha256_dma_wait(void)
+{
+    uint8_t err = sha_error;
+
+    sha_error = 0;
+    return err ? FAILED : SUCCESSED;
+}
+
+void sha256_dma_digest(uint8_t digest[32])
+{
+    mbedtls_sha256_finish(&sha_ctx, digest);
+    sha256_dma_stop();
+}
+
+void sha256_dma_stop(void)
+{
+    mbedtls_sha256_free(&sha_ctx);
+    sha_held = 0;
+}
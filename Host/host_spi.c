@@ -0,0 +1,470 @@
+/**
+ * @file host_spi.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - SPI2 with an emulated W25Q128JV attached.
+ *
+ * The emulation decodes the instruction stream clocked through SPI_WRITE_TX()
+ * between SPI_SET_SS_LOW() and SPI_SET_SS_HIGH(), so the real w25q128jv.c
+ * driver runs unmodified. Program and erase instructions are executed when
+ * /CS is driven high and complete immediately (BUSY never reads back set).
+ *
+ * With host_spi_flash_set_timing() they take their typical time instead,
+ * counted in SPI clocks. While BUSY only the status registers can be read
+ * and Erase/Program Suspend is accepted, the array changes at completion.
+ * A suspended operation leaves its range unreadable until it is resumed and
+ * completes. A suspend sooner than tSUS after a resume takes back the time
+ * the operation ran since, it never completes under suspends that close.
+ *
+ * The flash is wired to QSPI0 after host_spi_flash_open(), or to SPI2 with
+ * host_spi_flash_wire(). The other port clocks into nothing and reads 0xFF,
+ * its bytes are not counted in host_stats. The quad instructions are only
+ * accepted with the QE bit set, and every byte has to be clocked with the
+ * lane count and direction of its phase, otherwise the rest of the
+ * instruction is ignored like the flash would decode garbage.
+ *
+ * Reference: w25q128jv datasheet 8.1.2 Instruction Set Table 1 and 2
+ */
+
+#include <string.h>
+#include "NuMicro.h"
+#include "host.h"
+
+#define NOR_PAGE_SIZE   (256U)
+#define NOR_SECTOR_SIZE (4096U)
+#define NOR_BLOCK32     (32768U)
+#define NOR_BLOCK64     (65536U)
+#define NOR_ADDR_MASK   (HOST_W25Q128JV_SIZE - 1)
+
+#define SR1_BUSY (1U << 0)
+#define SR1_WEL  (1U << 1)
+#define SR2_QE   (1U << 1)
+#define SR2_SUS  (1U << 7)
+
+/* Typical times, w25q128jv datasheet 9.6 AC Electrical Characteristics, in
+ * microseconds. tSUS is the maximum from suspend until BUSY clears. */
+#define NOR_T_PP  400U
+#define NOR_T_SE  45000U
+#define NOR_T_BE1 120000U
+#define NOR_T_BE2 150000U
+#define NOR_T_CE  40000000U
+#define NOR_T_SUS 20U
+
+/* SPI clocks per microsecond, SPI2/QSPI0 at 20 MHz */
+#define NOR_CLK_PER_US 20U
+
+/* Lanes of one byte of an instruction. */
+enum { LANE_SINGLE, LANE_QUAD_OUT, LANE_QUAD_IN, LANE_QUAD_ANY };
+
+SPI_T host_spi2;
+QSPI_T host_qspi0;
+
+static uint8_t *nor;
+static uint8_t sr1, sr2, sr3;
+static SPI_T *wired;  // the port the flash answers on
+
+/* Current instruction, valid while /CS is low. */
+static int selected;
+static uint8_t cmd;
+static uint32_t count;
+static uint32_t addr;
+static uint8_t page_buf[NOR_PAGE_SIZE];
+
+/* Program or erase in progress, timed by host_spi_flash_set_timing(). */
+static int timing;
+static uint64_t clocks;     // SPI clocks since open
+static uint64_t busy_until; // BUSY clears at this clock
+static uint64_t busy_left;  // clocks left of the suspended operation
+static uint64_t resumed_at; // clock of the last resume, 0: not resumed
+static int suspended;
+static uint8_t op_cmd;
+static uint32_t op_addr;
+static uint8_t op_buf[NOR_PAGE_SIZE];
+
+static const uint8_t jedec_id[3] = {0xEF, 0x40, 0x18};
+static const uint8_t unique_id[8] = {0xD2, 0x6A, 0x38, 0x42,
+                                     0x17, 0x53, 0x2C, 0x25};
+
+/*******************************************************************************
+ * Static Functions
+ ******************************************************************************/
+static void nor_erase(uint32_t base, uint32_t bytes)
+{
+    base &= NOR_ADDR_MASK & ~(bytes - 1);
+    memset(nor + base, 0xFF, bytes);
+    host_stats.nor_erase++;
+}
+
+static void nor_program(uint32_t base, const uint8_t *data)
+{
+    base &= NOR_ADDR_MASK & ~(NOR_PAGE_SIZE - 1);
+    for (uint32_t i = 0; i < NOR_PAGE_SIZE; i++)
+        nor[base + i] &= data[i];
+    host_stats.nor_program++;
+}
+
+/**
+ * @brief Bytes covered by a program or erase instruction.
+ */
+static uint32_t nor_op_size(uint8_t op)
+{
+    switch (op) {
+    case 0x02:
+    case 0x32:
+        return NOR_PAGE_SIZE;
+    case 0x20:
+        return NOR_SECTOR_SIZE;
+    case 0x52:
+        return NOR_BLOCK32;
+    case 0xD8:
+        return NOR_BLOCK64;
+    default:
+        return HOST_W25Q128JV_SIZE;
+    }
+}
+
+static void nor_apply(uint8_t op, uint32_t base, const uint8_t *data)
+{
+    if (op == 0x02 || op == 0x32)
+        nor_program(base, data);
+    else
+        nor_erase(base, nor_op_size(op));
+}
+
+/**
+ * @brief Start a program or erase, done at once unless timed.
+ */
+static void nor_start(uint32_t t_us)
+{
+    uint32_t base = (cmd == 0xC7 || cmd == 0x60) ? 0 : addr;
+
+    if (!timing) {
+        nor_apply(cmd, base, page_buf);
+        return;
+    }
+    op_cmd = cmd;
+    op_addr = base;
+    memcpy(op_buf, page_buf, NOR_PAGE_SIZE);
+    busy_until = clocks + (uint64_t) t_us * NOR_CLK_PER_US;
+    resumed_at = 0;
+    sr1 |= SR1_BUSY;
+}
+
+/**
+ * @brief Clear BUSY when its time is up, completing the operation.
+ */
+static void nor_tick(void)
+{
+    if (!(sr1 & SR1_BUSY) || clocks < busy_until)
+        return;
+    sr1 &= ~SR1_BUSY;
+    if (!suspended)
+        nor_apply(op_cmd, op_addr, op_buf);
+}
+
+/**
+ * @brief Whether addr is inside the range of the suspended operation.
+ */
+static int nor_suspended_at(uint32_t at)
+{
+    uint32_t size = nor_op_size(op_cmd);
+
+    return suspended && (at & NOR_ADDR_MASK & ~(size - 1)) ==
+                            (op_addr & NOR_ADDR_MASK & ~(size - 1));
+}
+
+/**
+ * @brief Lanes of byte n of the current instruction, the host side direction.
+ */
+static int nor_lanes(uint32_t n)
+{
+    switch (cmd) {
+    case 0xEB:  // Fast Read Quad I/O: address, M7-0, 4 dummy clocks, data
+        if (n <= 4)
+            return LANE_QUAD_OUT;
+        return (n <= 6) ? LANE_QUAD_ANY : LANE_QUAD_IN;
+    case 0x6B:  // Fast Read Quad Output: address, 8 dummy clocks, data
+        return (n <= 4) ? LANE_SINGLE : LANE_QUAD_IN;
+    case 0x32:  // Quad Input Page Program: address, data
+        return (n <= 3) ? LANE_SINGLE : LANE_QUAD_OUT;
+    default:
+        return LANE_SINGLE;
+    }
+}
+
+/**
+ * @brief Execute the latched instruction on /CS rising edge.
+ */
+static void nor_execute(void)
+{
+    switch (cmd) {
+    case 0x06:  // Write Enable
+        sr1 |= SR1_WEL;
+        return;
+    case 0x04:  // Write Disable
+        sr1 &= ~SR1_WEL;
+        return;
+    case 0x75:  // Erase/Program Suspend, not for Chip Erase
+        if (count == 1 && (sr1 & SR1_BUSY) && !suspended &&
+            nor_op_size(op_cmd) < HOST_W25Q128JV_SIZE) {
+            // busy_left stays as resumed without tSUS of progress
+            if (resumed_at &&
+                clocks - resumed_at < NOR_T_SUS * NOR_CLK_PER_US)
+                host_stats.nor_suspend_early++;
+            else
+                busy_left = busy_until - clocks;
+            busy_until = clocks + NOR_T_SUS * NOR_CLK_PER_US;
+            suspended = 1;
+            sr2 |= SR2_SUS;
+            host_stats.nor_suspend++;
+        }
+        return;
+    case 0x7A:  // Erase/Program Resume
+        if (count == 1 && suspended && !(sr1 & SR1_BUSY)) {
+            busy_until = clocks + busy_left;
+            resumed_at = clocks;
+            suspended = 0;
+            sr2 &= ~SR2_SUS;
+            sr1 |= SR1_BUSY;
+        }
+        return;
+    default:
+        break;
+    }
+
+    if (!(sr1 & SR1_WEL))
+        return;
+
+    switch (cmd) {
+    case 0x02:  // Page Program
+    case 0x32:  // Quad Input Page Program
+        if (count > 4)
+            nor_start(NOR_T_PP);
+        break;
+    case 0x20:  // Sector Erase (4KB)
+        if (count == 4)
+            nor_start(NOR_T_SE);
+        break;
+    case 0x52:  // Block Erase (32KB)
+        if (count == 4)
+            nor_start(NOR_T_BE1);
+        break;
+    case 0xD8:  // Block Erase (64KB)
+        if (count == 4)
+            nor_start(NOR_T_BE2);
+        break;
+    case 0xC7:  // Chip Erase
+    case 0x60:
+        if (count == 1)
+            nor_start(NOR_T_CE);
+        break;
+    case 0x01:  // Write Status Register-1
+        if (count == 2)
+            sr1 = (sr1 & (SR1_BUSY | SR1_WEL)) | (addr & 0xFC);
+        break;
+    case 0x31:  // Write Status Register-2
+        if (count == 2)
+            sr2 = addr & 0xFF;
+        break;
+    case 0x11:  // Write Status Register-3
+        if (count == 2)
+            sr3 = addr & 0xFF;
+        break;
+    default:
+        return;
+    }
+    sr1 &= ~SR1_WEL;
+}
+
+/**
+ * @brief Shift one byte of the current instruction.
+ * @return uint8_t the byte driven on MISO.
+ */
+static uint8_t nor_shift(uint8_t mosi, int lanes)
+{
+    uint32_t n = count++;
+
+    if (n == 0) {
+        cmd = (lanes == LANE_SINGLE) ? mosi : 0x00;
+        addr = 0;
+        if ((cmd == 0xEB || cmd == 0x6B || cmd == 0x32) && !(sr2 & SR2_QE))
+            cmd = 0x00;  // IO2/IO3 are /WP and /HOLD
+        if ((sr1 & SR1_BUSY) && cmd != 0x05 && cmd != 0x35 && cmd != 0x15 &&
+            cmd != 0x75)
+            cmd = 0x00;  // busy, status and suspend only
+        if (suspended && (nor_op_size(cmd) < HOST_W25Q128JV_SIZE ||
+                          cmd == 0xC7 || cmd == 0x60 || cmd == 0x01 ||
+                          cmd == 0x31 || cmd == 0x11))
+            cmd = 0x00;  // no program, erase or status write while suspended
+        if (cmd == 0x02 || cmd == 0x32)
+            memset(page_buf, 0xFF, NOR_PAGE_SIZE);
+        return 0xFF;
+    }
+
+    int expect = nor_lanes(n);
+    if (lanes != expect &&
+        !(expect == LANE_QUAD_ANY && lanes != LANE_SINGLE)) {
+        cmd = 0x00;
+        return 0xFF;
+    }
+
+    switch (cmd) {
+    case 0x05:  // Read Status Register-1
+        return sr1;
+    case 0x35:  // Read Status Register-2
+        return sr2;
+    case 0x15:  // Read Status Register-3
+        return sr3;
+    case 0x01:  // Write Status Register-1/2/3
+    case 0x31:
+    case 0x11:
+        if (n == 1)
+            addr = mosi;
+        return 0xFF;
+    case 0x9F:  // JEDEC ID
+        return (n <= 3) ? jedec_id[n - 1] : 0xFF;
+    case 0x4B:  // Read Unique ID, 4 dummy bytes
+        return (n >= 5 && n <= 12) ? unique_id[n - 5] : 0xFF;
+    case 0x03:  // Read Data
+    case 0x0B:  // Fast Read, 1 dummy byte
+    case 0x6B:  // Fast Read Quad Output, 1 dummy byte
+    case 0xEB:  // Fast Read Quad I/O, M7-0 and 2 dummy bytes
+    case 0x02:  // Page Program
+    case 0x32:  // Quad Input Page Program
+    case 0x20:  // Erase
+    case 0x52:
+    case 0xD8:
+        if (n <= 3) {
+            addr = (addr << 8) | mosi;
+            return 0xFF;
+        }
+        break;
+    default:
+        return 0xFF;
+    }
+
+    if (cmd == 0x02 || cmd == 0x32) {
+        page_buf[addr & (NOR_PAGE_SIZE - 1)] = mosi;
+        addr = (addr & ~(NOR_PAGE_SIZE - 1)) | ((addr + 1) & (NOR_PAGE_SIZE - 1));
+        return 0xFF;
+    }
+    if ((cmd == 0x0B || cmd == 0x6B) && n == 4)
+        return 0xFF;
+    if (cmd == 0xEB && n <= 6)
+        return 0xFF;
+    if (cmd == 0x03 || cmd == 0x0B || cmd == 0x6B || cmd == 0xEB) {
+        if (nor_suspended_at(addr++))
+            return 0x00;  // half programmed or erased
+        return nor[(addr - 1) & NOR_ADDR_MASK];
+    }
+    return 0xFF;
+}
+
+/*******************************************************************************
+ * Host Control
+ ******************************************************************************/
+int host_spi_flash_open(const char *path)
+{
+    host_spi_flash_close();
+    nor = host_map_image(path, HOST_W25Q128JV_SIZE);
+    sr1 = sr2 = sr3 = 0;
+    wired = QSPI0;
+    selected = 0;
+    timing = 0;
+    clocks = 0;
+    resumed_at = 0;
+    suspended = 0;
+    return nor ? 0 : -1;
+}
+
+void host_spi_flash_close(void)
+{
+    if (nor)
+        host_unmap_image(nor, HOST_W25Q128JV_SIZE);
+    nor = NULL;
+}
+
+uint8_t *host_spi_flash_mem(void)
+{
+    return nor;
+}
+
+void host_spi_flash_set_qe(int qe)
+{
+    sr2 = qe ? (sr2 | SR2_QE) : (sr2 & ~SR2_QE);
+}
+
+void host_spi_flash_set_timing(int enable)
+{
+    timing = enable;
+}
+
+void host_spi_flash_elapse(uint32_t us)
+{
+    clocks += (uint64_t) us * NOR_CLK_PER_US;
+    nor_tick();
+}
+
+uint32_t host_spi_flash_us(void)
+{
+    return clocks / NOR_CLK_PER_US;
+}
+
+void host_spi_flash_wire(struct host_spi *port)
+{
+    wired = port;
+}
+
+int host_spi_flash_busy(void)
+{
+    return (sr1 & SR1_BUSY) || suspended;
+}
+
+/*******************************************************************************
+ * SPI Register Access
+ ******************************************************************************/
+void host_spi_write_tx(SPI_T *spi, uint32_t data)
+{
+    int lanes = LANE_SINGLE;
+
+    spi->TX = data;
+    if (spi != wired) {
+        spi->RX = 0xFF;  // MISO pulled up, nothing attached
+        return;
+    }
+    host_stats.spi_bytes++;
+    if (spi->quad) {
+        host_stats.spi_quad_bytes++;
+        lanes = spi->output ? LANE_QUAD_OUT : LANE_QUAD_IN;
+    }
+    clocks += spi->quad ? 2 : 8;
+    nor_tick();
+    spi->RX = (selected && nor) ? nor_shift(data & 0xFF, lanes) : 0xFF;
+}
+
+uint32_t host_spi_read_rx(SPI_T *spi)
+{
+    return spi->RX;
+}
+
+void host_spi_set_quad(SPI_T *spi, int quad, int output)
+{
+    spi->quad = quad;
+    spi->output = output;
+}
+
+void host_spi_set_ss(SPI_T *spi, int level)
+{
+    host_pdma_land();  // the CPU is back on the bus
+    if (spi != wired)
+        return;
+    if (!level && !selected) {
+        selected = 1;
+        count = 0;
+        host_stats.spi_commands++;
+    } else if (level && selected) {
+        selected = 0;
+        if (count && nor)
+            nor_execute();
+    }
+}
@@ -0,0 +1,225 @@
+/**
+ * @file host_system.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Host build - boot_system.h stand-in and backend helpers.
+ *
+ * system_init() brings up the default backends when none were opened yet:
+ *
+ *  NUMBOOT_APROM : APROM image file (RAM-backed if unset)
+ *  NUMBOOT_NOR   : W25Q128JV image file (RAM-backed if unset)
+ *
+ * and attaches the communication channel to a new pty, whose name is printed
+ * for the programmer.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "NuMicro.h"
+#include "boot_system.h"
+#include "device.h"
+#include "host.h"
+
+host_stats_t host_stats;
+
+static uint8_t jumped;
+static uint32_t jump_vectors;
+static uint8_t led;
+static uint8_t initialized;
+
+static system_pdma_handler_t pdma_handlers[PDMA_CH_MAX];
+
+/*******************************************************************************
+ * Interrupt Handler
+ ******************************************************************************/
+void PDMA_IRQHandler(void)
+{
+    uint32_t abort = PDMA_GET_ABORT_STS(PDMA);
+    uint32_t done = PDMA_GET_TD_STS(PDMA);
+    uint32_t pending = abort | done;
+
+    PDMA_CLR_ABORT_FLAG(PDMA, abort);
+    PDMA_CLR_TD_FLAG(PDMA, done);
+    for (uint32_t ch = 0; pending; ch++, pending >>= 1) {
+        if ((pending & 1) && pdma_handlers[ch])
+            pdma_handlers[ch]();
+    }
+}
+
+/*******************************************************************************
+ * Backend Helper
+ ******************************************************************************/
+void host_stats_reset(void)
+{
+    memset(&host_stats, 0, sizeof(host_stats));
+}
+
+uint8_t *host_map_image(const char *path, uint32_t size)
+{
+    void *image;
+
+    if (!path) {
+        image = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (image == MAP_FAILED)
+            return NULL;
+        memset(image, 0xFF, size);
+        return image;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) || ftruncate(fd, size)) {
+        close(fd);
+        return NULL;
+    }
+
+    image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED)
+        return NULL;
+
+    // erase the part of the image the file did not cover
+    if ((uint32_t) st.st_size < size)
+        memset((uint8_t *) image + st.st_size, 0xFF, size - st.st_size);
+    return image;
+}
+
+void host_unmap_image(uint8_t *image, uint32_t size)
+{
+    msync(image, size, MS_SYNC);
+    munmap(image, size);
+}
+
+uint8_t host_system_jumped(void)
+{
+    return jumped;
+}
+
+uint32_t host_system_jump_vectors(void)
+{
+    return jump_vectors;
+}
+
+uint8_t host_system_led(void)
+{
+    return led;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void system_init(void)
+{
+    if (initialized)
+        return;
+    initialized = 1;
+
+    if (!host_fmc_mem() && host_fmc_open(getenv("NUMBOOT_APROM"))) {
+        perror("NUMBOOT_APROM");
+        exit(1);
+    }
+    if (!host_spi_flash_mem() && host_spi_flash_open(getenv("NUMBOOT_NOR"))) {
+        perror("NUMBOOT_NOR");
+        exit(1);
+    }
+
+    const char *pty = host_com_channel_open_pty();
+    if (!pty) {
+        perror("pty");
+        exit(1);
+    }
+    printf("NuM487BOOT host: communication channel on %s\n", pty);
+    fflush(stdout);
+}
+
+void system_deinit(void)
+{
+    host_fmc_close();
+    host_spi_flash_close();
+    initialized = 0;
+}
+
+void system_jump_to_app(void)
+{
+    jumped = 1;
+    jump_vectors = USER_APP_START;
+}
+
+void system_jump_to_xip(uint32_t vectors)
+{
+    jumped = 1;
+    jump_vectors = vectors;
+}
+
+uint8_t system_is_prog_mode(void)
+{
+    // There is no application to run on the host, always serve the programmer.
+    return 1;
+}
+
+void system_pdma_attach(uint32_t ch, system_pdma_handler_t handler)
+{
+    pdma_handlers[ch] = handler;
+}
+
+void system_spi_quad_pins(uint8_t quad)
+{
+    (void) quad;
+}
+
+void system_spi_flash_port(uint8_t qspi)
+{
+    (void) qspi;  // the emulated flash is wired by host_spi_flash_wire()
+}
+
+uint32_t system_get_tick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint32_t system_get_us(void)
+{
+    // the emulated SPI bus time, the clock the W25Q128JV model runs on
+    return host_spi_flash_us();
+}
+
+void system_delay_ms(uint32_t ms)
+{
+    usleep(ms * 1000);
+}
+
+void bootLED_on(void)
+{
+    led = 1;
+}
+
+void bootLED_off(void)
+{
+    led = 0;
+}
+
+void APROM_update_enable(void)
+{
+    SYS_UnlockReg();
+    FMC_Open();
+    FMC_ENABLE_AP_UPDATE();
+}
+
+void APROM_update_disable(void)
+{
+    FMC_DISABLE_AP_UPDATE();
+    FMC_Close();
+    SYS_LockReg();
+}
@@ -6,9 +6,17 @@
  *
  */
 
+#include <string.h>
+#include "device.h"
 #include "lfs.h"
+#include "lfs_port.h"
 #include "w25q128jv.h"
 
+/* Blocks below the image slots, and over the whole chip as formatted before
+ * there were slots. */
+#define LFS_PORT_BLOCKS      (EXT_FLASH_LFS_SIZE / 4096)
+#define LFS_PORT_CHIP_BLOCKS (EXT_FLASH_SIZE / 4096)
+
 /**
  * @brief   lfs porting Layer - "read" API.
  *          Read a region in a block. Negative error codes are propagated to the
@@ -26,7 +34,9 @@ static int lfs_deskio_read(const struct lfs_config *c,
                            void *buffer,
                            lfs_size_t size)
 {
-    w25q128jv_read_sector((uint8_t *) buffer, block, off, size);
+    // one Fast Read for the whole region, it stays inside the block
+    w25q128jv_read_bytes((uint8_t *) buffer, block * c->block_size + off,
+                         size);
     return LFS_ERR_OK;
 }
 
@@ -48,7 +58,9 @@ static int lfs_deskio_prog(const struct lfs_config *c,
                            const void *buffer,
                            lfs_size_t size)
 {
-    w25q128jv_write_sector((uint8_t *) buffer, block, off, size);
+    // queued, a later read of the block or lfs_deskio_sync() waits for it
+    w25q128jv_write_bytes_async((const uint8_t *) buffer,
+                                block * c->block_size + off, size);
     return LFS_ERR_OK;
 }
 
@@ -64,7 +76,7 @@ static int lfs_deskio_prog(const struct lfs_config *c,
  */
 static int lfs_deskio_erase(const struct lfs_config *c, lfs_block_t block)
 {
-    w25q128jv_erase_sector(block);
+    w25q128jv_erase_sector_async(block);
     return LFS_ERR_OK;
 }
 
@@ -77,18 +89,30 @@ static int lfs_deskio_erase(const struct lfs_config *c, lfs_block_t block)
  */
 static int lfs_deskio_sync(const struct lfs_config *c)
 {
+    w25q128jv_flush();
     return LFS_ERR_OK;
 }
 
+/* One W25Q128JV page per cache fill, LittleFS bypasses the cache only for
+ * reads up to the end of a block. With 16 bytes every read of the data was a
+ * separate Fast Read. */
+#define LFS_PORT_CACHE_SIZE 256
+
 // Static allocated memory buffer
-__attribute__((__aligned__(4))) static uint8_t read_buffer[16];
-__attribute__((__aligned__(4))) static uint8_t prog_buffer[16];
+__attribute__((__aligned__(4))) static uint8_t read_buffer[LFS_PORT_CACHE_SIZE];
+__attribute__((__aligned__(4))) static uint8_t prog_buffer[LFS_PORT_CACHE_SIZE];
 __attribute__((__aligned__(4))) static uint8_t lookahead_buffer[16];
+__attribute__((__aligned__(4))) static uint8_t file_buffer[LFS_PORT_CACHE_SIZE];
 
 lfs_t lfs_w25q128jv;
 lfs_file_t lfs_file_w25q128jv;
 
-const struct lfs_config cfg = {
+// lfs_file_w25q128jv cache, instead of a malloc() per open
+const struct lfs_file_config lfs_file_cfg_w25q128jv = {
+    .buffer = file_buffer,
+};
+
+struct lfs_config cfg = {
     // block device operations
     .read = lfs_deskio_read,
     .prog = lfs_deskio_prog,
@@ -98,9 +122,9 @@ const struct lfs_config cfg = {
     // block device configuration
     .read_size = 16,
     .prog_size = 16,
-    .block_size = 4096,   // flash sector
-    .block_count = 4096,  // flash sector count
-    .cache_size = 16,
+    .block_size = 4096,  // flash sector
+    .block_count = LFS_PORT_BLOCKS,  // lfs_port_mount() picks the layout
+    .cache_size = LFS_PORT_CACHE_SIZE,
     .lookahead_size = 16,
     .block_cycles = 500,
 
@@ -109,3 +133,71 @@ const struct lfs_config cfg = {
     .prog_buffer = prog_buffer,
     .lookahead_buffer = lookahead_buffer,
 };
+
+static uint8_t layout = LFS_PORT_UNKNOWN;
+
+/**
+ * @brief Whether the root directory holds nothing but path.
+ */
+static uint8_t lfs_port_only(const char *path)
+{
+    lfs_dir_t dir;
+    struct lfs_info info;
+    uint8_t only = 1;
+
+    if (lfs_dir_open(&lfs_w25q128jv, &dir, "/"))
+        return 0;
+    while (only && lfs_dir_read(&lfs_w25q128jv, &dir, &info) > 0) {
+        if (strcmp(info.name, ".") && strcmp(info.name, "..") &&
+            strcmp(info.name, path + 1))
+            only = 0;
+    }
+    lfs_dir_close(&lfs_w25q128jv, &dir);
+    return only;
+}
+
+int lfs_port_mount(void)
+{
+    int err;
+
+    cfg.block_count = LFS_PORT_BLOCKS;
+    err = lfs_mount(&lfs_w25q128jv, &cfg);
+    if (err) {
+        cfg.block_count = LFS_PORT_CHIP_BLOCKS;
+        err = lfs_mount(&lfs_w25q128jv, &cfg);
+    }
+    if (err) {
+        cfg.block_count = LFS_PORT_BLOCKS;
+        layout = LFS_PORT_NONE;
+    } else if (cfg.block_count == LFS_PORT_CHIP_BLOCKS) {
+        layout = LFS_PORT_CHIP;
+    } else {
+        layout = LFS_PORT_SLOTS;
+    }
+    return err;
+}
+
+int lfs_port_mount_write(const char *path)
+{
+    if (!lfs_port_mount()) {
+        if (layout != LFS_PORT_CHIP || !lfs_port_only(path))
+            return LFS_ERR_OK;
+        // nothing is lost, the caller rewrites path
+        lfs_unmount(&lfs_w25q128jv);
+    }
+
+    cfg.block_count = LFS_PORT_BLOCKS;
+    layout = LFS_PORT_NONE;
+    if (lfs_format(&lfs_w25q128jv, &cfg) ||
+        lfs_mount(&lfs_w25q128jv, &cfg))
+        return LFS_ERR_CORRUPT;
+    layout = LFS_PORT_SLOTS;
+    return LFS_ERR_OK;
+}
+
+uint8_t lfs_port_layout(void)
+{
+    if (layout == LFS_PORT_UNKNOWN && !lfs_port_mount())
+        lfs_unmount(&lfs_w25q128jv);
+    return layout;
+}
@@ -14,6 +14,42 @@
 extern lfs_t lfs_w25q128jv;
 extern lfs_file_t lfs_file_w25q128jv;
 
+/* Static cache of lfs_file_w25q128jv, open it with lfs_file_opencfg(). */
+extern const struct lfs_file_config lfs_file_cfg_w25q128jv;
+
+/* Mounted as lfs_port_mount() found it, block_count tells the layout. */
 extern struct lfs_config cfg;
 
+#define LFS_PORT_UNKNOWN 0  // not mounted yet
+#define LFS_PORT_NONE    1  // no filesystem, blank or corrupted
+#define LFS_PORT_SLOTS   2  // below the image slots
+#define LFS_PORT_CHIP    3  // over the whole chip, formatted before the slots
+
+/**
+ * @brief Mount the filesystem below the image slots, or one formatted over
+ *        the whole chip before there were slots. Never formats.
+ * @return int LFS error, LFS_ERR_OK when mounted.
+ */
+int lfs_port_mount(void);
+
+/**
+ * @brief Mount to write path, the caller removes or truncates it.
+ *
+ *  A chip without a filesystem is formatted below the image slots. A
+ *  filesystem over the whole chip holding nothing but path is formatted below
+ *  the slots too, that is the migration to the slot layout. With any other
+ *  file it is kept and the slots stay unavailable.
+ *
+ * @param path file in the root directory, "/boot".
+ * @return int LFS error, LFS_ERR_OK when mounted.
+ */
+int lfs_port_mount_write(const char *path);
+
+/**
+ * @brief Layout of the external flash, mounted once to find out.
+ * @return uint8_t LFS_PORT_NONE, LFS_PORT_SLOTS or LFS_PORT_CHIP, the image
+ *         slots are part of the filesystem with LFS_PORT_CHIP.
+ */
+uint8_t lfs_port_layout(void);
+
 #endif /* LFS_PORT_H */
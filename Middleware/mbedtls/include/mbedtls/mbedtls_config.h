@@ -51,6 +51,11 @@
  * by default. */
 #define MBEDTLS_SHA224_C
 #define MBEDTLS_SHA256_C
+/* SHA-256 by the CRPT engine, see sha256_alt.h. sha256_sw.c builds the
+ * stock sha256.c without it as the software path. */
+#if !defined(SHA256_SW_BUILD)
+#define MBEDTLS_SHA256_ALT
+#endif
 #define MBEDTLS_SSL_CLI_C
 #define MBEDTLS_SSL_SRV_C
 #define MBEDTLS_SSL_TLS_C
@@ -0,0 +1,51 @@
+/**
+ * @file sha256_alt.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief MBEDTLS_SHA256_ALT - SHA-256 by the M480 CRPT engine.
+ *
+ * A message is held in the context until it outgrows SHA256_ALT_BUFSIZE,
+ * then it is fed to the CRPT engine by DMA, straight from the caller's buffer
+ * when word aligned. Shorter messages, SHA-224 and a second message while
+ * the engine already holds one are hashed in software. The engine is claimed
+ * through sha256_dma_start(), so a slot_install() running meanwhile is
+ * refused and a message arriving during one goes to software, which is the
+ * library's own code (sha256_sw.h). The engine cannot hand its intermediate
+ * digest back, so a message stays on the path it started on until
+ * mbedtls_sha256_finish(). A clone of an engine message cannot be made: the
+ * copy fails every update and finish with
+ * MBEDTLS_ERR_PLATFORM_FEATURE_UNSUPPORTED, the original goes on.
+ */
+
+#ifndef SHA256_ALT_H
+#define SHA256_ALT_H
+
+#include <stdint.h>
+#include "sha256_sw.h"
+
+/**
+ * @brief Bytes held before a message picks its path, a multiple of 64.
+ */
+#define SHA256_ALT_BUFSIZE 128
+
+#define SHA256_ALT_NONE  0  // not decided yet, the message is in buffer
+#define SHA256_ALT_SW    1  // software, the message is in sw
+#define SHA256_ALT_CRPT  2  // CRPT engine, 1 to SHA256_ALT_BUFSIZE bytes held
+#define SHA256_ALT_DONE  3  // finished on the engine
+#define SHA256_ALT_CLONE 4  // a clone of an engine message, fails
+
+typedef struct mbedtls_sha256_context {
+    unsigned char buffer[SHA256_ALT_BUFSIZE];  // word aligned, first
+    uint32_t used;      // bytes in buffer
+    int is224;
+    int path;
+    sha256_sw_t sw;     // the stock context of the software path
+} mbedtls_sha256_context;
+
+/**
+ * @brief Keep a message off the CRPT engine, call after
+ *        mbedtls_sha256_starts(). For hashing beside sha256_dma.h users.
+ */
+void sha256_alt_software(mbedtls_sha256_context *ctx);
+
+#endif /* SHA256_ALT_H */
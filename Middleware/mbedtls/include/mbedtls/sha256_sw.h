@@ -0,0 +1,42 @@
+/**
+ * @file sha256_sw.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief mbedtls' own software SHA-256, the fallback of sha256_alt.c.
+ *
+ * sha256_sw.c builds the stock sha256.c once more without MBEDTLS_SHA256_ALT
+ * and under other names, so the software path is the library's code.
+ */
+
+#ifndef SHA256_SW_H
+#define SHA256_SW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Room for the stock mbedtls_sha256_context, sha256_sw.c checks it.
+ */
+#define SHA256_SW_WORDS 27
+
+typedef struct sha256_sw {
+    uint32_t words[SHA256_SW_WORDS];
+} sha256_sw_t;
+
+/**
+ * @brief mbedtls_sha256_starts() of the stock library.
+ */
+int sha256_sw_starts(sha256_sw_t *sw, int is224);
+
+/**
+ * @brief mbedtls_sha256_update() of the stock library.
+ */
+int sha256_sw_update(sha256_sw_t *sw, const unsigned char *input,
+                     size_t ilen);
+
+/**
+ * @brief mbedtls_sha256_finish() of the stock library.
+ */
+int sha256_sw_finish(sha256_sw_t *sw, unsigned char *output);
+
+#endif /* SHA256_SW_H */
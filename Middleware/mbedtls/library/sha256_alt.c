@@ -0,0 +1,222 @@
+/**
+ * @file sha256_alt.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief MBEDTLS_SHA256_ALT - SHA-256 by the M480 CRPT engine, software for
+ *        short messages.
+ *
+ * The engine runs a cascade of DMA parts, whole blocks but the last, and
+ * keeps its state to itself. mbedtls_sha256_update() sends whatever whole
+ * blocks it can and waits for them, the last 1 to 128 bytes stay in the
+ * context for mbedtls_sha256_finish() to send as the last part. The software
+ * path is the stock sha256.c, built by sha256_sw.c.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SHA256_ALT)
+
+#include <string.h>
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha256_sw.h"
+#include "sha256_dma.h"
+
+#define SHA256_BLOCK 64
+
+/* The context whose message the engine holds, NULL when free. */
+static mbedtls_sha256_context *sha256_alt_owner;
+
+/*******************************************************************************
+ * Software
+ ******************************************************************************/
+/**
+ * @brief Take a held message to the library's software path.
+ */
+static int sha256_sw_begin(mbedtls_sha256_context *ctx)
+{
+    int ret;
+
+    ctx->path = SHA256_ALT_SW;
+    if ((ret = sha256_sw_starts(&ctx->sw, ctx->is224)) != 0)
+        return ret;
+    ret = sha256_sw_update(&ctx->sw, ctx->buffer, ctx->used);
+    ctx->used = 0;
+    return ret;
+}
+
+/*******************************************************************************
+ * CRPT
+ ******************************************************************************/
+static int sha256_crpt_part(const unsigned char *buf, size_t len, int last)
+{
+    sha256_dma_update(buf, len, last);
+    return sha256_dma_wait() ? MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED : 0;
+}
+
+/**
+ * @brief Send whole blocks of the held bytes and input, hold the rest. At
+ *        least one byte stays held for the last part.
+ */
+static int sha256_crpt_update(mbedtls_sha256_context *ctx,
+                              const unsigned char *input, size_t ilen)
+{
+    size_t fill;
+    int ret;
+
+    while (ilen) {
+        // aligned input goes to the engine in place, in one part
+        if (!ctx->used && !((uintptr_t) input & 3) && ilen > SHA256_BLOCK) {
+            fill = (ilen - 1) & ~(size_t) (SHA256_BLOCK - 1);
+            if ((ret = sha256_crpt_part(input, fill, 0)) != 0)
+                return ret;
+            input += fill;
+            ilen -= fill;
+            continue;
+        }
+
+        fill = SHA256_ALT_BUFSIZE - ctx->used;
+        if (fill > ilen)
+            fill = ilen;
+        memcpy(ctx->buffer + ctx->used, input, fill);
+        ctx->used += fill;
+        input += fill;
+        ilen -= fill;
+
+        if (ctx->used == SHA256_ALT_BUFSIZE && ilen) {
+            if ((ret = sha256_crpt_part(ctx->buffer, ctx->used, 0)) != 0)
+                return ret;
+            ctx->used = 0;
+        }
+    }
+    return 0;
+}
+
+static void sha256_crpt_release(mbedtls_sha256_context *ctx)
+{
+    if (sha256_alt_owner == ctx) {
+        sha256_alt_owner = NULL;
+        sha256_dma_stop();
+    }
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    if (ctx == NULL)
+        return;
+
+    sha256_crpt_release(ctx);
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst,
+                          const mbedtls_sha256_context *src)
+{
+    if (dst == src)
+        return;
+
+    sha256_crpt_release(dst);
+    if (src->path != SHA256_ALT_CRPT) {
+        *dst = *src;
+        return;
+    }
+
+    // one message at a time in the engine, its state cannot be copied
+    mbedtls_platform_zeroize(dst, sizeof(mbedtls_sha256_context));
+    dst->path = SHA256_ALT_CLONE;
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    if (is224 != 0 && is224 != 1)
+        return MBEDTLS_ERR_SHA256_BAD_INPUT_DATA;
+
+    sha256_crpt_release(ctx);
+    ctx->used = 0;
+    ctx->is224 = is224;
+    ctx->path = SHA256_ALT_NONE;
+    // the engine is set up for SHA-256 only
+    return is224 ? sha256_sw_begin(ctx) : 0;
+}
+
+void sha256_alt_software(mbedtls_sha256_context *ctx)
+{
+    if (ctx->path == SHA256_ALT_NONE)
+        (void) sha256_sw_begin(ctx);
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx,
+                          const unsigned char *input, size_t ilen)
+{
+    int ret;
+
+    if (ilen == 0)
+        return 0;
+
+    switch (ctx->path) {
+        case SHA256_ALT_NONE:
+            if (ctx->used + ilen <= SHA256_ALT_BUFSIZE) {
+                memcpy(ctx->buffer + ctx->used, input, ilen);
+                ctx->used += ilen;
+                return 0;
+            }
+            // the engine is taken by another message or slot_install()
+            if (sha256_dma_start()) {
+                if ((ret = sha256_sw_begin(ctx)) != 0)
+                    return ret;
+                break;
+            }
+            sha256_alt_owner = ctx;
+            ctx->path = SHA256_ALT_CRPT;
+            return sha256_crpt_update(ctx, input, ilen);
+        case SHA256_ALT_SW:
+            break;
+        case SHA256_ALT_CRPT:
+            return sha256_crpt_update(ctx, input, ilen);
+        case SHA256_ALT_CLONE:
+            return MBEDTLS_ERR_PLATFORM_FEATURE_UNSUPPORTED;
+        default:
+            return MBEDTLS_ERR_SHA256_BAD_INPUT_DATA;
+    }
+
+    return sha256_sw_update(&ctx->sw, input, ilen);
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx,
+                          unsigned char *output)
+{
+    int ret;
+
+    switch (ctx->path) {
+        case SHA256_ALT_NONE:
+            if ((ret = sha256_sw_begin(ctx)) != 0)
+                return ret;
+            /* fall through */
+        case SHA256_ALT_SW:
+            return sha256_sw_finish(&ctx->sw, output);
+        case SHA256_ALT_CRPT:
+            ret = sha256_crpt_part(ctx->buffer, ctx->used, 1);
+            if (ret == 0) {
+                sha256_dma_digest(output);
+                sha256_alt_owner = NULL;
+            }
+            sha256_crpt_release(ctx);
+            ctx->path = SHA256_ALT_DONE;
+            return ret;
+        case SHA256_ALT_CLONE:
+            return MBEDTLS_ERR_PLATFORM_FEATURE_UNSUPPORTED;
+        default:
+            return MBEDTLS_ERR_SHA256_BAD_INPUT_DATA;
+    }
+}
+
+#endif /* MBEDTLS_SHA256_ALT */
@@ -0,0 +1,50 @@
+/**
+ * @file sha256_sw.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief The stock sha256.c without MBEDTLS_SHA256_ALT, renamed for
+ *        sha256_alt.c to fall back on.
+ */
+
+#define SHA256_SW_BUILD
+
+#define mbedtls_sha256_context          sha256_lib_context
+#define mbedtls_sha256_init             sha256_lib_init
+#define mbedtls_sha256_free             sha256_lib_free
+#define mbedtls_sha256_clone            sha256_lib_clone
+#define mbedtls_sha256_starts           sha256_lib_starts
+#define mbedtls_sha256_update           sha256_lib_update
+#define mbedtls_sha256_finish           sha256_lib_finish
+#define mbedtls_sha256                  sha256_lib
+#define mbedtls_internal_sha256_process sha256_lib_process
+#define mbedtls_sha256_self_test        sha256_lib_self_test
+#define mbedtls_sha224_self_test        sha224_lib_self_test
+
+#include "sha256.c"
+#include "mbedtls/sha256_sw.h"
+
+#if defined(MBEDTLS_SHA256_C)
+
+typedef char sha256_sw_fits[
+    sizeof(sha256_lib_context) <= sizeof(sha256_sw_t) ? 1 : -1];
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int sha256_sw_starts(sha256_sw_t *sw, int is224)
+{
+    return sha256_lib_starts((sha256_lib_context *) sw, is224);
+}
+
+int sha256_sw_update(sha256_sw_t *sw, const unsigned char *input,
+                     size_t ilen)
+{
+    return sha256_lib_update((sha256_lib_context *) sw, input, ilen);
+}
+
+int sha256_sw_finish(sha256_sw_t *sw, unsigned char *output)
+{
+    return sha256_lib_finish((sha256_lib_context *) sw, output);
+}
+
+#endif /* MBEDTLS_SHA256_C */
@@ -0,0 +1,193 @@
+/**
+ * @file bench_host_00_program.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Programming throughput of a full user app image.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_prog.h"
+
+#define PAGESIZE    512
+#define BIGPAGESIZE 4096
+#define IMAGESIZE   (USER_APP_SIZE - BOOTLOADER_SIZE)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t pac[4 + PAGESIZE];
+static uint8_t big_pac[4 + BIGPAGESIZE];
+
+static const uint32_t bauds[] = {BENCH_BAUDRATE, 921600};
+static const uint8_t windows[] = {1, 2, 4, 16};
+
+int main()
+{
+    uint64_t rtt = 0;
+    double t0;
+    int fd;
+
+    printf("[bench_host_00]: program %lu KiB user app ...\n",
+           (unsigned long) (IMAGESIZE / 1024));
+
+    srand(0x487);
+    for (uint32_t i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+
+    host_stats_reset();
+    t0 = bench_now();
+
+    if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    rtt++;
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(pac, &addr, 4);
+        memcpy(pac + 4, image + ofs, PAGESIZE);
+        if (host_prog_cmd(fd, CMD_FLASH_WRITE, pac, sizeof(pac), NULL, NULL) !=
+            ACK)
+            return 1;
+        rtt++;
+    }
+
+    bench_report("erase all + write 512", IMAGESIZE, rtt, bench_now() - t0);
+
+    // ********************************************************************** //
+
+    // the window only pays while it is shorter than a frame's round trip
+    for (uint32_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+        if (host_prog_set_baud(fd, bauds[i]))
+            return 1;
+        bench_set_baudrate(bauds[i]);
+
+        for (uint32_t j = 0; j < sizeof(windows); j++) {
+            char name[32];
+            uint32_t syncs;
+
+            if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) !=
+                ACK)
+                return 1;
+            host_stats_reset();
+            t0 = bench_now();
+            if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) !=
+                ACK)
+                return 1;
+            if (host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE,
+                                       windows[j], -1, &syncs))
+                return 1;
+
+            // the erase and the window open are still stop-and-wait
+            bench_set_window(windows[j], IMAGESIZE / PAGESIZE);
+            snprintf(name, sizeof(name), "%u baud + window %u", bauds[i],
+                     windows[j]);
+            bench_report(name, IMAGESIZE, 2 + syncs, bench_now() - t0);
+            bench_set_window(0, 0);
+        }
+    }
+
+    // ********************************************************************** //
+
+    {
+        uint16_t rewritten;
+
+        // a typical update: a few functions change, the rest stays in place
+        for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += IMAGESIZE / 4)
+            image[ofs + 1234] ^= 0xFF;
+
+        // at the default rate, to compare with the first run
+        if (host_prog_set_baud(fd, BENCH_BAUDRATE))
+            return 1;
+        bench_set_baudrate(BENCH_BAUDRATE);
+        host_stats_reset();
+        t0 = bench_now();
+        if (host_prog_sync_app(fd, image, IMAGESIZE, &rewritten))
+            return 1;
+
+        // manifest packets and a stop-and-wait write per 512 bytes row
+        bench_report("sync page, 4 of 112 changed", IMAGESIZE,
+                     IMAGESIZE / (HOST_SYNC_PAGE * BL_SYNC_PAGES_MAX) + 1 +
+                         rewritten * (HOST_SYNC_PAGE / PAGESIZE),
+                     bench_now() - t0);
+    }
+
+    // ********************************************************************** //
+
+    {
+        uint32_t syncs;
+
+        // whole FMC pages, an eighth of the frames and of the turnarounds
+        if (host_prog_set_pgsz(fd, BIGPAGESIZE))
+            return 1;
+        host_stats_reset();
+        t0 = bench_now();
+        if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+            return 1;
+        for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += BIGPAGESIZE) {
+            uint32_t addr = USER_APP_START + ofs;
+            memcpy(big_pac, &addr, 4);
+            memcpy(big_pac + 4, image + ofs, BIGPAGESIZE);
+            if (host_prog_cmd(fd, CMD_FLASH_WRITE, big_pac, sizeof(big_pac),
+                              NULL, NULL) != ACK)
+                return 1;
+        }
+        bench_report("erase all + write 4096", IMAGESIZE,
+                     1 + IMAGESIZE / BIGPAGESIZE, bench_now() - t0);
+
+        if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+            return 1;
+        host_stats_reset();
+        t0 = bench_now();
+        if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+            return 1;
+        if (host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 16, -1,
+                                   &syncs))
+            return 1;
+        bench_set_window(16, IMAGESIZE / BIGPAGESIZE);
+        bench_report("erase all + window 16, 4096", IMAGESIZE, 2 + syncs,
+                     bench_now() - t0);
+        bench_set_window(0, 0);
+
+        if (host_prog_set_pgsz(fd, PAGESIZE))
+            return 1;
+    }
+
+    // ********************************************************************** //
+
+    {
+        static uint8_t resp[1 + PAGESIZE + 4];
+        uint16_t len;
+
+        host_stats_reset();
+        t0 = bench_now();
+        for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+            uint32_t addr = USER_APP_START + ofs;
+            if (host_prog_cmd(fd, CMD_FLASH_READ, (uint8_t *) &addr, 4, resp,
+                              &len) != ACK ||
+                memcmp(resp + 1, image + ofs, PAGESIZE))
+                return 1;
+        }
+        bench_report("verify by read 512", IMAGESIZE, IMAGESIZE / PAGESIZE,
+                     bench_now() - t0);
+
+        host_stats_reset();
+        t0 = bench_now();
+        if (host_prog_verify(fd, USER_APP_START, image, IMAGESIZE))
+            return 1;
+        bench_report("verify by checksum", IMAGESIZE, 1, bench_now() - t0);
+    }
+
+    host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL);
+    host_device_stop(fd);
+
+    return memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) ? 1 : 0;
+}
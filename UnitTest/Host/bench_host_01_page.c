@@ -0,0 +1,69 @@
+/**
+ * @file bench_host_01_page.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Per-page program time of flash_write_app_page().
+ *
+ * A word-aligned buffer takes the multi-word program path, the same buffer
+ * one byte off takes the word-by-word fallback.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "boot_system.h"
+#include "device.h"
+#include "flash.h"
+#include "host.h"
+#include "host_bench.h"
+
+#define PAGES 512
+
+static uint8_t page[4 + 512] __attribute__((__aligned__(4)));
+
+static int bench_pages(const char *name, uint8_t *buf)
+{
+    uint32_t pgsz = flash_get_pgsz();
+    double t0;
+
+    if (flash_erase_app_all())
+        return 1;
+    host_stats_reset();
+    t0 = bench_now();
+    for (uint32_t i = 0; i < PAGES; i++) {
+        if (flash_write_app_page(USER_APP_START + i * pgsz, buf))
+            return 1;
+    }
+    double host_s = bench_now() - t0;
+
+    printf("%-28s isp %5.1f/page  model %7.1f us/page  host %6.0f ns/page\n",
+           name, (double) host_stats.fmc_isp_program / PAGES,
+           bench_model_seconds(0) * 1e6 / PAGES, host_s * 1e9 / PAGES);
+
+    for (uint32_t i = 0; i < PAGES; i++) {
+        if (memcmp(host_fmc_mem() + USER_APP_START + i * pgsz, buf, pgsz))
+            return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    printf("[bench_host_01]: program %u pages of %u bytes ...\n", PAGES,
+           flash_get_pgsz());
+
+    srand(0x487);
+    for (uint32_t i = 0; i < sizeof(page); i++)
+        page[i] = rand();
+
+    if (host_fmc_open(NULL))
+        return 1;
+    APROM_update_enable();
+
+    if (bench_pages("word by word (unaligned)", page + 1) ||
+        bench_pages("multi-word (aligned)", page))
+        return 1;
+
+    APROM_update_disable();
+    host_fmc_close();
+    return 0;
+}
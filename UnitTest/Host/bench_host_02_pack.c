@@ -0,0 +1,137 @@
+/**
+ * @file bench_host_02_pack.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Compression ratio and programming time of compressed flash writes.
+ *
+ * Images:
+ *
+ *  synthetic     : code, strings, zeroed tables and 0xFF padding
+ *  host ELF      : this benchmark's executable, a real linked image
+ *  NUMBOOT_IMAGE : a board image (main.bin), if the variable is set
+ *
+ * Each is programmed raw with a window of 16 and compressed. The model does not
+ * count the decompression, a few CPU cycles per byte against 260 us of line
+ * time per byte at 38400 baud.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_pack.h"
+#include "host_prog.h"
+
+#define APPSIZE  (USER_APP_SIZE - USER_APP_START)
+#define PAGESIZE 512
+
+static uint8_t image[APPSIZE];
+static uint8_t stream[HOST_PACK_BOUND(APPSIZE)];
+
+static uint32_t load_image(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    uint32_t len;
+
+    if (!f)
+        return 0;
+    len = fread(image, 1, APPSIZE, f);
+    fclose(f);
+
+    // whole pages for the raw write, padded as in the erased flash
+    memset(image + len, 0xFF, APPSIZE - len);
+    return (len + 511) & ~511UL;
+}
+
+static uint32_t synthetic_image(void)
+{
+    static const char text[] = "flash_write_app_page failed\nUART0 overrun\n";
+    uint32_t pos = 0, len = 300 * 1024;
+
+    srand(0x487);
+    while (pos < len) {
+        uint32_t n = 256 + rand() % 4096;
+        int kind = rand() % 8;
+
+        if (n > len - pos)
+            n = len - pos;
+        for (uint32_t i = 0; i < n; i++) {
+            if (kind < 5)  // code dominates
+                image[pos + i] = (i & 1) ? 0x40 + rand() % 16 : rand();
+            else if (kind == 5)
+                image[pos + i] = text[i % (sizeof(text) - 1)];
+            else if (kind == 6)
+                image[pos + i] = 0x00;
+            else
+                image[pos + i] = 0xFF;
+        }
+        pos += n;
+    }
+    return len;
+}
+
+static int bench_image(int fd, const char *name, uint32_t len)
+{
+    uint32_t syncs, packed;
+    double t0;
+
+    t0 = bench_now();
+    packed = host_pack(image, len, stream);
+    double pack_s = bench_now() - t0;
+    if (!packed)
+        return 1;
+    printf("%s: %u B -> %u B (%.1f %%), host pack %.1f MiB/s\n", name, len,
+           packed, packed * 100.0 / len, len / 1048576.0 / pack_s);
+
+    if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    host_stats_reset();
+    t0 = bench_now();
+    if (host_prog_write_window(fd, USER_APP_START, image, len, 16, -1, &syncs))
+        return 1;
+    bench_set_window(16, len / PAGESIZE);
+    bench_report("  raw, window 16", len, 1 + syncs, bench_now() - t0);
+    bench_set_window(0, 0);
+
+    if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    host_stats_reset();
+    t0 = bench_now();
+    if (host_prog_write_packed(fd, USER_APP_START, stream, packed, len))
+        return 1;
+    bench_report("  packed, stop-and-wait", len, 1 + (packed + 511) / 512,
+                 bench_now() - t0);
+
+    return memcmp(host_fmc_mem() + USER_APP_START, image, len) ? 1 : 0;
+}
+
+int main()
+{
+    const char *path = getenv("NUMBOOT_IMAGE");
+    uint32_t len;
+    int fd;
+
+    printf("[bench_host_02]: compressed flash write ...\n");
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+
+    if (bench_image(fd, "synthetic", synthetic_image()))
+        return 1;
+    if (!(len = load_image("/proc/self/exe")) ||
+        bench_image(fd, "host ELF", len))
+        return 1;
+    if (path && (!(len = load_image(path)) || bench_image(fd, path, len)))
+        return 1;
+
+    host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL);
+    host_device_stop(fd);
+    return 0;
+}
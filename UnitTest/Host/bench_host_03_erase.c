@@ -0,0 +1,88 @@
+/**
+ * @file bench_host_03_erase.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Deferred erase, a 40 KiB image over a full user app section.
+ *
+ * The erases done while the pages are sent overlap with the line, the ones
+ * left for CMD_PROG_END do not, so the two phases are reported apart. Run at
+ * 921600 baud, where the line no longer hides the erase time.
+ *
+ * The same image is also written to APROM bank 1, where the flash operations
+ * run while the bootloader keeps receiving from bank 0.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_prog.h"
+
+#define IMAGESIZE (40 * 1024)
+#define PAGESIZE  512
+#define BAUDRATE  921600
+
+static uint8_t image[IMAGESIZE];
+
+static int session(const char *name, int erase_all, uint32_t addr)
+{
+    char row[32];
+    uint32_t syncs;
+    double t0;
+    int fd;
+
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK ||
+        host_prog_set_baud(fd, BAUDRATE))
+        return 1;
+    bench_set_baudrate(BAUDRATE);
+
+    memset(host_fmc_mem() + USER_APP_START, 0x00,
+           USER_APP_SIZE - USER_APP_START);
+    host_stats_reset();
+    t0 = bench_now();
+    if (erase_all) {
+        if (host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK)
+            return 1;
+    } else if (host_prog_erase(fd, addr, IMAGESIZE)) {
+        return 1;
+    }
+    if (host_prog_write_window(fd, addr, image, IMAGESIZE, 16, -1, &syncs))
+        return 1;
+    bench_set_window(16, IMAGESIZE / PAGESIZE);
+    snprintf(row, sizeof(row), "%s, window 16", name);
+    bench_report(row, IMAGESIZE, 2 + syncs, bench_now() - t0);
+    bench_set_window(0, 0);
+
+    host_stats_reset();
+    t0 = bench_now();
+    if (host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    snprintf(row, sizeof(row), "%s, prog end", name);
+    bench_report(row, 0, 1, bench_now() - t0);
+
+    host_device_stop(fd);
+    bench_set_baudrate(BENCH_BAUDRATE);
+    return memcmp(host_fmc_mem() + addr, image, IMAGESIZE) ? 1 : 0;
+}
+
+int main()
+{
+    printf("[bench_host_03]: erase for a %u KiB image ...\n", IMAGESIZE / 1024);
+
+    srand(0x03);
+    for (uint32_t i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+
+    if (session("erase all", 1, USER_APP_START) ||
+        session("erase image", 0, USER_APP_START) ||
+        session("bank 1 image", 0, APROM_BANK1_START))
+        return 1;
+    return 0;
+}
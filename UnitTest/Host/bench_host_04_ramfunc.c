@@ -0,0 +1,84 @@
+/**
+ * @file bench_host_04_ramfunc.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Windowed write into APROM bank 0 at high baud rates, with the
+ *        receive and flash write paths in APROM or in SRAM (.ramfunc).
+ *
+ * Every bank 0 program stalls instruction fetch from the bank the bootloader
+ * lives in. Run from APROM, the RX ISR waits too and a burst longer than the
+ * RX FIFO is lost, the bytes reported below would be resent by the window
+ * protocol. Run from SRAM, the ISR keeps draining into the ring buffer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_prog.h"
+
+#define PAGESIZE  4096
+#define IMAGESIZE (APROM_BANK1_START - USER_APP_START)
+
+static uint8_t image[IMAGESIZE];
+
+static const uint32_t bauds[] = {921600, 1500000, 3000000};
+
+int main()
+{
+    int fd;
+
+    printf("[bench_host_04]: %lu KiB into bank 0, %u byte pages ...\n",
+           (unsigned long) (IMAGESIZE / 1024), PAGESIZE);
+
+    srand(0x04);
+    for (uint32_t i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK ||
+        host_prog_set_pgsz(fd, PAGESIZE))
+        return 1;
+
+    for (uint32_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+        uint32_t syncs;
+        double t0;
+
+        if (host_prog_set_baud(fd, bauds[i]) ||
+            host_prog_erase(fd, USER_APP_START, IMAGESIZE))
+            return 1;
+        host_stats_reset();
+        t0 = bench_now();
+        if (host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 16,
+                                   -1, &syncs))
+            return 1;
+        t0 = bench_now() - t0;
+        if (memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE))
+            return 1;
+
+        // the same session, costed for both placements
+        bench_set_baudrate(bauds[i]);
+        bench_set_window(16, IMAGESIZE / PAGESIZE);
+        for (int ramfunc = 0; ramfunc <= 1; ramfunc++) {
+            char name[32];
+
+            bench_set_ramfunc(ramfunc);
+            snprintf(name, sizeof(name), "%s, %u baud",
+                     ramfunc ? "SRAM" : "APROM", bauds[i]);
+            bench_report(name, IMAGESIZE, 2 + syncs, t0);
+            printf("  %llu B lost to RX overruns\n",
+                   (unsigned long long) bench_model_overruns());
+        }
+        bench_set_window(0, 0);
+    }
+
+    host_prog_set_baud(fd, BENCH_BAUDRATE);
+    bench_set_baudrate(BENCH_BAUDRATE);
+    host_device_stop(fd);
+    return 0;
+}
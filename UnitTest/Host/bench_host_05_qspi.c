@@ -0,0 +1,90 @@
+/**
+ * @file bench_host_05_qspi.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief boot_from_fs() with the W25Q128JV data phases on one and four lanes.
+ *
+ * The SPI time is reported apart, boot_from_fs() also erases the whole user
+ * app section and programs the image, which quad SPI does not change.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_prog.h"
+#include "w25q128jv.h"
+
+#define PAGESIZE  512
+#define RECSIZE   (4 + PAGESIZE)
+#define IMAGESIZE (128 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t rec[RECSIZE];
+
+static int boot(int fd, int qe)
+{
+    uint64_t clocks;
+    double t0;
+
+    host_spi_flash_set_qe(qe);
+    w25q128jv_probe_quad();
+
+    host_stats_reset();
+    t0 = bench_now();
+    if (host_prog_cmd(fd, CMD_PROG_EXT_FLASH_BOOT, NULL, 0, NULL, NULL) !=
+        ACK)
+        return 1;
+    bench_report(qe ? "boot_from_fs, quad" : "boot_from_fs, single",
+                 IMAGESIZE, 1, bench_now() - t0);
+
+    clocks = (host_stats.spi_bytes - host_stats.spi_quad_bytes) * 8 +
+             host_stats.spi_quad_bytes * 2;
+    printf("  SPI %llu B in %llu commands, %llu B polled, %.1f ms\n",
+           (unsigned long long) host_stats.spi_bytes,
+           (unsigned long long) host_stats.spi_commands,
+           (unsigned long long) (host_stats.spi_bytes -
+                                 host_stats.spi_pdma_bytes),
+           clocks * 1e3 / BENCH_SPI_HZ +
+               host_stats.spi_commands * BENCH_SPI_CMD_US / 1e3);
+
+    return memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) ? 1 : 0;
+}
+
+int main()
+{
+    int fd;
+
+    printf("[bench_host_05]: boot a %u KiB image from LittleFS ...\n",
+           IMAGESIZE / 1024);
+
+    srand(0x05);
+    for (uint32_t i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK ||
+        host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(rec, &addr, 4);
+        memcpy(rec + 4, image + ofs, PAGESIZE);
+        if (host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL, NULL) !=
+            ACK)
+            return 1;
+    }
+    if (host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+
+    if (boot(fd, 0) || boot(fd, 1))
+        return 1;
+
+    host_device_stop(fd);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file bench_host_06_slot.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief The same image installed from a LittleFS file and from a raw slot.
+ *
+ * LittleFS reads metadata and the CTZ skip-list pointers around the data and
+ * erases the whole user app section, the slot is one Fast Read of the image
+ * and only the pages the image covers are erased.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_prog.h"
+#include "w25q128jv.h"
+
+#define PAGESIZE  512
+#define RECSIZE   (4 + PAGESIZE)
+#define IMAGESIZE (128 * 1024)
+#define SLOT      2
+
+static uint8_t image[IMAGESIZE];
+static uint8_t rec[RECSIZE];
+
+static int install(int fd, const char *name, uint8_t cmd, uint8_t *data,
+                   uint16_t len)
+{
+    uint64_t clocks;
+    double t0;
+
+    memset(host_fmc_mem() + USER_APP_START, 0x00, IMAGESIZE);
+    host_stats_reset();
+    t0 = bench_now();
+    if (host_prog_cmd(fd, cmd, data, len, NULL, NULL) != ACK)
+        return 1;
+    bench_report(name, IMAGESIZE, 1, bench_now() - t0);
+
+    clocks = (host_stats.spi_bytes - host_stats.spi_quad_bytes) * 8 +
+             host_stats.spi_quad_bytes * 2;
+    printf("  SPI %llu B in %llu commands, %.1f ms, %llu FMC erases\n",
+           (unsigned long long) host_stats.spi_bytes,
+           (unsigned long long) host_stats.spi_commands,
+           clocks * 1e3 / BENCH_SPI_HZ +
+               host_stats.spi_commands * BENCH_SPI_CMD_US / 1e3,
+           (unsigned long long) host_stats.fmc_isp_erase);
+
+    return memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) ? 1 : 0;
+}
+
+int main()
+{
+    uint8_t slot = SLOT;
+    int fd;
+
+    printf("[bench_host_06]: install a %u KiB image, file or slot ...\n",
+           IMAGESIZE / 1024);
+
+    srand(0x06);
+    for (uint32_t i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+    host_spi_flash_set_qe(1);
+    w25q128jv_probe_quad();
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK ||
+        host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(rec, &addr, 4);
+        memcpy(rec + 4, image + ofs, PAGESIZE);
+        if (host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL, NULL) !=
+            ACK)
+            return 1;
+    }
+    if (host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) != ACK)
+        return 1;
+    if (host_prog_write_slot(fd, SLOT, USER_APP_START, image, IMAGESIZE))
+        return 1;
+
+    if (install(fd, "boot_from_fs", CMD_PROG_EXT_FLASH_BOOT, NULL, 0) ||
+        install(fd, "slot_install", CMD_PROG_EXT_FLASH_SLOT, &slot, 1))
+        return 1;
+
+    host_device_stop(fd);
+    return 0;
+}
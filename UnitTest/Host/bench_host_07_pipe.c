@@ -0,0 +1,192 @@
+/**
+ * @file bench_host_07_pipe.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Stages of a slot install, read and program in turn or overlapped.
+ *
+ * The host PDMA completes at once, so the overlap is not measured but laid
+ * out: every 4 KiB chunk is read and programmed as slot_install() does, the
+ * modeled SPI and FMC time of each is taken apart, and the two schedules are
+ * summed from them. With one buffer a chunk is read, then programmed; with
+ * two the read of chunk n + 1 runs beside the program of chunk n.
+ *
+ * slot_install() itself is modeled with bench_set_pdma_overlap(): each PDMA
+ * read hides behind the FMC work done before the driver waits for it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "bootprotocol.h"
+#include "crc32.h"
+#include "device.h"
+#include "flash.h"
+#include "host.h"
+#include "host_bench.h"
+#include "host_prog.h"
+#include "slot.h"
+#include "w25q128jv.h"
+
+#define IMAGESIZE (128 * 1024)
+#define CHUNK     FMC_FLASH_PAGE_SIZE
+#define CHUNKS    (IMAGESIZE / CHUNK)
+#define SLOT      4
+
+static uint8_t image[IMAGESIZE];
+static uint8_t buf0[CHUNK] __attribute__((__aligned__(4)));
+static uint8_t buf1[CHUNK] __attribute__((__aligned__(4)));
+
+struct stages {
+    host_stats_t mark;     // counters at the end of the last stage
+    double read[CHUNKS];   // SPI, microseconds
+    double prog[CHUNKS];   // FMC program and deferred erase, microseconds
+    double crc;            // CRC-32 on the host, seconds
+    uint32_t n;
+    uint32_t dest;
+    uint32_t sum;
+};
+
+/**
+ * @brief host_stats since the last mark, then mark again.
+ */
+static host_stats_t stages_take(struct stages *st)
+{
+    host_stats_t delta;
+    const uint64_t *now = (const uint64_t *) &host_stats;
+    uint64_t *d = (uint64_t *) &delta;
+    uint64_t *mark = (uint64_t *) &st->mark;
+
+    for (uint32_t i = 0; i < sizeof(host_stats_t) / sizeof(uint64_t); i++) {
+        d[i] = now[i] - mark[i];
+        mark[i] = now[i];
+    }
+    return delta;
+}
+
+/**
+ * @brief slot_install()'s chunk handler, stage by stage.
+ */
+static uint8_t stage_chunk(void *ctx, const uint8_t *pbuf, uint32_t addr,
+                           uint32_t bytes)
+{
+    struct stages *st = ctx;
+    host_stats_t d;
+    double t0;
+
+    (void) addr;
+    d = stages_take(st);
+    st->read[st->n] = bench_spi_us(&d);
+
+    t0 = bench_now();
+    st->sum = crc32_update(st->sum, pbuf, bytes);
+    st->crc += bench_now() - t0;
+
+    if (flash_write_app(st->dest, pbuf, bytes))
+        return 0;
+    d = stages_take(st);
+    st->prog[st->n] = bench_fmc_us(&d);
+    st->dest += bytes;
+    st->n++;
+    return 1;
+}
+
+static int stages_run(uint8_t slot, struct stages *st)
+{
+    slot_header_t hdr;
+    host_stats_t d;
+    double serial = 0, pipe, read = 0, prog = 0, setup;
+
+    memset(st, 0, sizeof(*st));
+    memset(host_fmc_mem() + USER_APP_START, 0x00, IMAGESIZE);
+    host_stats_reset();
+
+    // header and bank 0 erases, before the first chunk either way
+    if (slot_header_read(slot, &hdr) ||
+        flash_erase_app_defer(hdr.load, IMAGESIZE))
+        return 1;
+    d = stages_take(st);
+    setup = bench_spi_us(&d) + bench_fmc_us(&d);
+
+    st->dest = hdr.load;
+    if (w25q128jv_read_stream(buf0, CHUNK, slot_base(slot), hdr.size,
+                              stage_chunk, st) != 1 ||
+        flash_erase_flush() || st->sum != hdr.crc || st->n != CHUNKS)
+        return 1;
+
+    pipe = st->read[0];
+    for (uint32_t i = 0; i < CHUNKS; i++) {
+        double next = (i + 1 < CHUNKS) ? st->read[i + 1] : 0;
+
+        read += st->read[i];
+        prog += st->prog[i];
+        serial += st->read[i] + st->prog[i];
+        pipe += (st->prog[i] > next) ? st->prog[i] : next;
+    }
+
+    printf("  header, bank 0 erase %8.1f ms\n", setup / 1e3);
+    printf("  SPI read             %8.1f ms, %.1f us a chunk\n", read / 1e3,
+           read / CHUNKS);
+    printf("  FMC program, erase   %8.1f ms, %.1f us a chunk\n", prog / 1e3,
+           prog / CHUNKS);
+    printf("  CRC-32 (host)        %8.3f ms\n", st->crc * 1e3);
+    printf("  one buffer           %8.1f ms\n", (setup + serial) / 1e3);
+    printf("  two buffers          %8.1f ms, %.1f ms hidden\n",
+           (setup + pipe) / 1e3, (serial - pipe) / 1e3);
+
+    return memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) ? 1 : 0;
+}
+
+static int install(const char *name, uint8_t *other)
+{
+    double t0;
+
+    memset(host_fmc_mem() + USER_APP_START, 0x00, IMAGESIZE);
+    host_stats_reset();
+    bench_set_pdma_overlap(1);
+    t0 = bench_now();
+    if (slot_install(SLOT, buf0, other, CHUNK))
+        return 1;
+    bench_report(name, IMAGESIZE, 0, bench_now() - t0);
+    printf("  %.1f ms SPI hidden\n", bench_pdma_hidden_us / 1e3);
+    bench_set_pdma_overlap(0);
+
+    return memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) ? 1 : 0;
+}
+
+int main()
+{
+    static struct stages st;
+    int fd;
+
+    printf("[bench_host_07]: stages of a %u KiB slot install ...\n",
+           IMAGESIZE / 1024);
+
+    srand(0x07);
+    for (uint32_t i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    if (host_fmc_open(NULL) || host_spi_flash_open(NULL))
+        return 1;
+    if ((fd = host_device_start()) < 0)
+        return 1;
+    if (host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) != ACK ||
+        host_prog_write_slot(fd, SLOT, USER_APP_START, image, IMAGESIZE))
+        return 1;
+    host_device_stop(fd);
+
+    for (int qe = 0; qe <= 1; qe++) {
+        host_spi_flash_set_qe(qe);
+        w25q128jv_probe_quad();
+        printf("%s SPI, %u B chunks:\n", qe ? "quad" : "single",
+               (unsigned) CHUNK);
+        if (stages_run(SLOT, &st))
+            return 1;
+
+        // the same results from the real thing, both buffer settings
+        if (install("slot_install, one buffer", NULL) ||
+            install("slot_install, two buffers", buf1))
+            return 1;
+    }
+
+    return 0;
+}
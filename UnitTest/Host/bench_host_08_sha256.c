@@ -0,0 +1,98 @@
+/**
+ * @file bench_host_08_sha256.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief mbedtls SHA-256 throughput, CRPT engine against software.
+ *
+ * Every message is hashed twice through the mbedtls API, once as
+ * sha256_alt.c picks the path and once kept in software. The host engine is
+ * software too, so the board time is modeled from the bytes and DMA parts
+ * counted in host_stats; the host column is the software path on the host.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "host_bench.h"
+#include "mbedtls/sha256.h"
+
+#define MAXSIZE (128 * 1024)
+#define ROUNDS  16
+
+static uint8_t msg[MAXSIZE + 4] __attribute__((__aligned__(4)));
+
+/**
+ * @brief ROUNDS digests of p, in parts of part bytes.
+ * @return double host seconds.
+ */
+static double hash(const uint8_t *p, uint32_t len, uint32_t part,
+                   int software, uint8_t out[32])
+{
+    mbedtls_sha256_context ctx;
+    double t0 = bench_now();
+
+    mbedtls_sha256_init(&ctx);
+    for (int r = 0; r < ROUNDS; r++) {
+        mbedtls_sha256_starts(&ctx, 0);
+        if (software)
+            sha256_alt_software(&ctx);
+        for (uint32_t ofs = 0; ofs < len; ofs += part)
+            mbedtls_sha256_update(&ctx, p + ofs,
+                                  (len - ofs < part) ? len - ofs : part);
+        mbedtls_sha256_finish(&ctx, out);
+    }
+    mbedtls_sha256_free(&ctx);
+    return bench_now() - t0;
+}
+
+static int run(const char *name, const uint8_t *p, uint32_t len,
+               uint32_t part)
+{
+    uint8_t crpt[32], sw[32];
+    double host, us_crpt, us_sw;
+
+    host_stats_reset();
+    hash(p, len, part, 0, crpt);
+    us_crpt = bench_sha_us(&host_stats, (uint64_t) len * ROUNDS) / ROUNDS;
+
+    host_stats_reset();
+    host = hash(p, len, part, 1, sw) / ROUNDS;
+    us_sw = bench_sha_us(&host_stats, (uint64_t) len * ROUNDS) / ROUNDS;
+
+    printf("%-14s %7u B  software %9.1f us (%7.1f KiB/s)  "
+           "CRPT %8.1f us (%8.1f KiB/s)  x%5.1f  host %8.1f us\n",
+           name, len, us_sw, len / 1024.0 / us_sw * 1e6, us_crpt,
+           len / 1024.0 / us_crpt * 1e6, us_sw / us_crpt, host * 1e6);
+
+    return memcmp(crpt, sw, sizeof(sw)) ? 1 : 0;
+}
+
+int main()
+{
+    static const uint32_t sizes[] = {32, 128, 129, 256, 1024, 4096, 65536,
+                                     MAXSIZE};
+    char name[32];
+
+    printf("[bench_host_08]: SHA-256, CRPT engine against software ...\n");
+
+    srand(0x08);
+    for (uint32_t i = 0; i < sizeof(msg); i++)
+        msg[i] = rand();
+
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (run("one update", msg, sizes[i], sizes[i]))
+            return 1;
+    }
+
+    // an image streamed in FMC pages, from an aligned and unaligned buffer
+    for (uint32_t part = 512; part <= 4096; part *= 8) {
+        snprintf(name, sizeof(name), "%u B parts", (unsigned) part);
+        if (run(name, msg, MAXSIZE, part))
+            return 1;
+        snprintf(name, sizeof(name), "%u B, +1", (unsigned) part);
+        if (run(name, msg + 1, MAXSIZE, part))
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file host_bench.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Board cost model for the host benchmarks.
+ *
+ * The emulated backends run at host speed, so the benchmarks count the
+ * operations in host_stats and convert them to board time with the figures
+ * below. The figures are assumptions; replace them with measurements from the
+ * board when comparing against real programming sessions.
+ */
+
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+#include "commuch.h"
+#include "host.h"
+
+#define BENCH_BAUDRATE      38400  /* UART0 default line rate */
+#define BENCH_UART_BITS     10     /* 8n1 */
+#define BENCH_TURNAROUND_US 16000  /* USB-UART latency timer per round trip */
+#define BENCH_FMC_PROG_US   20     /* one ISP program trigger */
+#define BENCH_FMC_MP_US     2      /* 8 bytes fed to a multi-word program */
+#define BENCH_FMC_ERASE_US  20000  /* one ISP page/block erase trigger */
+#define BENCH_FMC_READ_US   1      /* one ISP read trigger */
+#define BENCH_FMC_CKS_US    50     /* ISP checksum of a 4 KiB page */
+#define BENCH_SPI_HZ        20000000
+#define BENCH_SPI_CMD_US    1      /* /CS toggling and driver overhead */
+#define BENCH_UART_FIFO     16     /* UART0 RX FIFO depth */
+#define BENCH_SHA_SW_NS     260    /* a byte of software SHA-256, 192 MHz */
+#define BENCH_SHA_DMA_NS    6      /* a byte through the CRPT SHA-256 DMA */
+#define BENCH_SHA_PART_US   2      /* CRPT DMA part setup and completion */
+
+static int bench_overlap;
+static uint32_t bench_window;   // frames in flight at most, 0: no limit
+static uint64_t bench_frames;   // frames sent through the window
+static int bench_ramfunc = 1;
+static uint32_t bench_baudrate = BENCH_BAUDRATE;
+static double bench_pdma_hidden_us;  // SPI time under FMC work, see below
+
+/**
+ * @brief Select how the link and the device work are combined.
+ * @param overlap 0: stop-and-wait, link time and device time add up.
+ *                1: pipelined, the slower of the two dominates. FMC
+ *                   operations that stall the CPU still add up, see
+ *                   bench_set_ramfunc().
+ */
+static inline void bench_set_overlap(int overlap)
+{
+    bench_overlap = overlap;
+}
+
+/**
+ * @brief Pipeline through a sliding window: at most window frames in flight,
+ *        each answered on its own. 0 goes back to stop-and-wait.
+ *
+ * A frame's reply is in a round trip after the frame went out: the frame and
+ * the reply on the wire, the program between and BENCH_TURNAROUND_US. A
+ * window that does not cover that round trip leaves the line idle until the
+ * oldest reply is in, once per window.
+ */
+static inline void bench_set_window(uint32_t window, uint64_t frames)
+{
+    bench_overlap = (window != 0);
+    bench_window = window;
+    bench_frames = frames;
+}
+
+/**
+ * @brief Select where the receive and flash write paths run from.
+ * @param ramfunc 0: APROM bank 0, a bank 0 ISP program stalls the CPU and the
+ *                   RX ISR with it, the line only has the RX FIFO meanwhile.
+ *                1: SRAM (.ramfunc), the RX ISR keeps filling the ring buffer
+ *                   and the programs overlap with the line.
+ */
+static inline void bench_set_ramfunc(int ramfunc)
+{
+    bench_ramfunc = ramfunc;
+}
+
+/**
+ * @brief Select the line rate, after a CMD_SET_BAUD negotiation.
+ */
+static inline void bench_set_baudrate(uint32_t baud)
+{
+    bench_baudrate = baud;
+}
+
+/**
+ * @brief Modeled FMC time of the operations counted in s, microseconds.
+ */
+static inline double bench_fmc_us(const host_stats_t *s)
+{
+    return (double) s->fmc_isp_program * BENCH_FMC_PROG_US +
+           (double) s->fmc_isp_mp_data * BENCH_FMC_MP_US +
+           (double) s->fmc_isp_erase * BENCH_FMC_ERASE_US +
+           (double) s->fmc_isp_read * BENCH_FMC_READ_US +
+           (double) s->fmc_isp_cks * BENCH_FMC_CKS_US;
+}
+
+/**
+ * @brief Modeled SPI2/QSPI0 time of the transfers counted in s, microseconds.
+ */
+static inline double bench_spi_us(const host_stats_t *s)
+{
+    // 8 clocks a byte on one lane, 2 on four
+    uint64_t spi_clocks = (s->spi_bytes - s->spi_quad_bytes) * 8 +
+                          s->spi_quad_bytes * 2;
+    return (double) spi_clocks * 1e6 / BENCH_SPI_HZ +
+           (double) s->spi_commands * BENCH_SPI_CMD_US;
+}
+
+/**
+ * @brief Modeled SHA-256 time of bytes hashed, those counted in s by the CRPT
+ *        engine and the rest in software, microseconds.
+ */
+static inline double bench_sha_us(const host_stats_t *s, uint64_t bytes)
+{
+    return (double) (bytes - s->sha_dma_bytes) * BENCH_SHA_SW_NS / 1e3 +
+           (double) s->sha_dma_bytes * BENCH_SHA_DMA_NS / 1e3 +
+           (double) s->sha_dma_parts * BENCH_SHA_PART_US;
+}
+
+/**
+ * @brief A PDMA transfer overlaps FMC work the CPU did meanwhile, the shorter
+ *        of the two is hidden.
+ */
+static void bench_pdma_overlap(const host_stats_t *transfer,
+                               const host_stats_t *meanwhile)
+{
+    double spi = bench_spi_us(transfer);
+    double fmc = bench_fmc_us(meanwhile);
+
+    bench_pdma_hidden_us += (spi < fmc) ? spi : fmc;
+}
+
+/**
+ * @brief Take SPI time moved by PDMA beside FMC work off the model, from now
+ *        until the next call. Off by default, every transfer then adds up.
+ * @param on 1: overlap PDMA transfers with FMC work, 0: add them up.
+ */
+static inline void bench_set_pdma_overlap(int on)
+{
+    bench_pdma_hidden_us = 0;
+    host_pdma_set_overlap(on ? bench_pdma_overlap : NULL);
+}
+
+/**
+ * @brief Modeled board time of the operations counted in host_stats.
+ * @param round_trips number of command/response turnarounds.
+ * @return double seconds.
+ */
+static inline double bench_model_seconds(uint64_t round_trips)
+{
+    const host_stats_t *s = &host_stats;
+    double link = 0, dev = 0;
+
+    // UART is full duplex, the busier direction sets the link time
+    uint64_t wire = (s->uart_rx_bytes > s->uart_tx_bytes) ? s->uart_rx_bytes
+                                                          : s->uart_tx_bytes;
+    if (!bench_overlap)
+        wire = s->uart_rx_bytes + s->uart_tx_bytes;
+    link += (double) wire * BENCH_UART_BITS * 1e6 / bench_baudrate;
+
+    dev += bench_fmc_us(s);
+    dev += bench_spi_us(s) - bench_pdma_hidden_us;
+
+    // the bootloader waits for bank 0 erases with the link idle, and for
+    // bank 0 programs too unless it runs from SRAM
+    double stall = (double) s->fmc_bank0_erase * BENCH_FMC_ERASE_US;
+    if (!bench_ramfunc)
+        stall += (double) s->fmc_bank0_program * BENCH_FMC_PROG_US +
+                 (double) s->fmc_bank0_mp_data * BENCH_FMC_MP_US;
+    dev -= stall;
+
+    double us = bench_overlap ? ((link > dev) ? link : dev) : (link + dev);
+
+    // the line waits for the oldest reply whenever the window is short
+    if (bench_overlap && bench_window && bench_frames) {
+        double both = (double) (s->uart_rx_bytes + s->uart_tx_bytes) *
+                      BENCH_UART_BITS * 1e6 / bench_baudrate;
+        double trip = (both + dev) / bench_frames + BENCH_TURNAROUND_US;
+        double paced = trip * bench_frames / bench_window;
+        if (us < paced)
+            us = paced;
+    }
+    us += stall;
+    us += (double) round_trips * BENCH_TURNAROUND_US;
+    return us / 1e6;
+}
+
+/**
+ * @brief Modeled bytes lost to RX overruns, with the line busy during every
+ *        bank 0 program as in a windowed write.
+ *
+ * One ISP trigger stalls APROM for a multi-word burst, the RX ISR catches up
+ * between two. Whatever arrives meanwhile beyond the FIFO, or the ring buffer
+ * when the ISR runs from SRAM, is lost.
+ */
+static inline uint64_t bench_model_overruns(void)
+{
+    const host_stats_t *s = &host_stats;
+
+    if (!s->fmc_bank0_program)
+        return 0;
+
+    double us = ((double) s->fmc_bank0_program * BENCH_FMC_PROG_US +
+                 (double) s->fmc_bank0_mp_data * BENCH_FMC_MP_US) /
+                s->fmc_bank0_program;
+    double bytes = us * bench_baudrate / BENCH_UART_BITS / 1e6;
+    double room = bench_ramfunc ? COM_CHANNEL_RX_BUFSIZE : BENCH_UART_FIFO;
+    return (bytes > room) ? (uint64_t) ((bytes - room) * s->fmc_bank0_program)
+                          : 0;
+}
+
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline void bench_report(const char *name,
+                                uint32_t bytes,
+                                uint64_t round_trips,
+                                double host_seconds)
+{
+    double model = bench_model_seconds(round_trips);
+    printf("%-28s %7u B  wire %8llu B  rtt %6llu  isp %7llu  "
+           "model %8.2f s (%6.2f KiB/s)  host %6.3f s\n",
+           name, bytes,
+           (unsigned long long) (host_stats.uart_rx_bytes +
+                                 host_stats.uart_tx_bytes),
+           (unsigned long long) round_trips,
+           (unsigned long long) (host_stats.fmc_isp_program +
+                                 host_stats.fmc_isp_erase),
+           model, bytes / 1024.0 / model, host_seconds);
+}
+
+#endif /* HOST_BENCH_H */
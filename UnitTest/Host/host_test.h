@@ -0,0 +1,27 @@
+/**
+ * @file host_test.h
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Minimal assertion helpers for the host tests.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int host_test_failed;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);     \
+            host_test_failed++;                                            \
+        }                                                                  \
+    } while (0)
+
+#define TEST_RESULT(name)                                                  \
+    (printf("[%s]: %s\n", (name), host_test_failed ? "FAILED" : "OK"),     \
+     host_test_failed ? 1 : 0)
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,108 @@
+/**
+ * @file test_host_00_bootprotocol.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Program an image into the emulated APROM through the boot protocol.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define PAGESIZE  512
+#define IMAGESIZE (40 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t pac[4 + PAGESIZE];
+static uint8_t resp[1 + PAGESIZE];
+
+int main()
+{
+    uint16_t len;
+    int fd;
+
+    printf("[test_host_00]: bootprotocol ...\n");
+
+    srand(0x487);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == 1);
+
+    CHECK(host_prog_cmd(fd, CMD_CHK_DEVICE, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == D_NUM487KM_DEVB);
+
+    CHECK(host_prog_cmd(fd, CMD_FLASH_GET_PGSZ, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 3 && (resp[1] | (resp[2] << 8)) == PAGESIZE);
+
+    // bank 1 is only scheduled, reading the section completes the erase
+    memset(host_fmc_mem() + USER_APP_START, 0x00, IMAGESIZE);
+    host_fmc_mem()[USER_APP_END] = 0x00;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_fmc_mem()[USER_APP_END] == 0x00);
+    memcpy(pac, "\x00\x00\x01\x00\x00\x00\x07\x00", 8);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_VERIFY, pac, 8, NULL, NULL) == ACK);
+    for (uint32_t i = USER_APP_START; i <= USER_APP_END; i++) {
+        if (host_fmc_mem()[i] != 0xFF) {
+            CHECK(host_fmc_mem()[i] == 0xFF);
+            break;
+        }
+    }
+
+    // ********************************************************************** //
+
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(pac, &addr, 4);
+        memcpy(pac + 4, image + ofs, PAGESIZE);
+        CHECK(host_prog_cmd(fd, CMD_FLASH_WRITE, pac, sizeof(pac), NULL,
+                            NULL) == ACK);
+    }
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // the bootloader section is write protected
+    uint32_t addr = BOOTLOADER_START;
+    memcpy(pac, &addr, 4);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_WRITE, pac, sizeof(pac), NULL, NULL) ==
+          NACK);
+
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        addr = USER_APP_START + ofs;
+        memcpy(pac, &addr, 4);
+        CHECK(host_prog_cmd(fd, CMD_FLASH_READ, pac, 4, resp, &len) == ACK);
+        CHECK(len == 1 + PAGESIZE);
+        CHECK(memcmp(resp + 1, image + ofs, PAGESIZE) == 0);
+    }
+
+    // a truncated packet is dropped after the inter-byte timeout
+    const uint8_t partial[] = {HEADER, HEADER, HEADER, CMD_FLASH_WRITE,
+                               0x02, 0x04, 0x00, 0x00, 0x01};
+    CHECK(write(fd, partial, sizeof(partial)) == sizeof(partial));
+    usleep(700 * 1000);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == 1);
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+
+    printf("UART rx %llu bytes, tx %llu bytes, ISP program %llu, erase %llu\n",
+           (unsigned long long) host_stats.uart_rx_bytes,
+           (unsigned long long) host_stats.uart_tx_bytes,
+           (unsigned long long) host_stats.fmc_isp_program,
+           (unsigned long long) host_stats.fmc_isp_erase);
+
+    return TEST_RESULT("test_host_00");
+}
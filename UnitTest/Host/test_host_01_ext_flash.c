@@ -0,0 +1,85 @@
+/**
+ * @file test_host_01_ext_flash.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Store an image in the emulated W25Q128JV through LittleFS and boot it
+ *        into the emulated APROM.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+#include "w25q128jv.h"
+
+#define PAGESIZE  512
+#define RECSIZE   (4 + PAGESIZE)
+#define IMAGESIZE (24 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t rec[RECSIZE];
+static uint8_t buf[4096];
+
+int main()
+{
+    int fd;
+
+    printf("[test_host_01]: external flash ...\n");
+
+    srand(0x128);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+
+    // ********************************************************************** //
+
+    CHECK(w25q128jv_read_JEDEC_ID() == 0xEF4018);
+
+    for (int i = 0; i < 256; i++)
+        buf[i] = i;
+    w25q128jv_erase_sector(1);
+    w25q128jv_write_page(buf, 16, 0, 256);
+    memset(buf, 0, sizeof(buf));
+    w25q128jv_read_sector(buf, 1, 0, 4096);
+    for (int i = 0; i < 256; i++)
+        CHECK(buf[i] == i);
+    CHECK(buf[256] == 0xFF && buf[4095] == 0xFF);
+    w25q128jv_erase_sector(1);
+    w25q128jv_read_bytes(buf, 4096, 256);
+    CHECK(buf[0] == 0xFF && buf[255] == 0xFF);
+
+    // ********************************************************************** //
+
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) == ACK);
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(rec, &addr, 4);
+        memcpy(rec + 4, image + ofs, PAGESIZE);
+        CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL,
+                            NULL) == ACK);
+    }
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) == ACK);
+
+    host_stats_reset();
+    CHECK(host_prog_cmd(fd, CMD_PROG_EXT_FLASH_BOOT, NULL, 0, NULL, NULL) ==
+          ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    printf("boot_from_fs: SPI %llu bytes in %llu commands, ISP program %llu\n",
+           (unsigned long long) host_stats.spi_bytes,
+           (unsigned long long) host_stats.spi_commands,
+           (unsigned long long) host_stats.fmc_isp_program);
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+
+    return TEST_RESULT("test_host_01");
+}
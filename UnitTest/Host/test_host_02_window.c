@@ -0,0 +1,90 @@
+/**
+ * @file test_host_02_window.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Windowed flash write with selective retransmission.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define PAGESIZE  512
+#define IMAGESIZE (64 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t pac[8 + PAGESIZE];
+static uint8_t resp[16];
+
+int main()
+{
+    uint32_t syncs;
+    uint16_t len;
+    int fd;
+
+    printf("[test_host_02]: windowed flash write ...\n");
+
+    srand(0x02);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    pac[0] = 200;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_WINDOW_OPEN, pac, 1, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == BL_WINDOW_MAX);
+
+    // sequence number outside of the window
+    memset(pac, 0, sizeof(pac));
+    pac[0] = BL_WINDOW_MAX;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_WINDOW_WRITE, pac, sizeof(pac), resp,
+                        &len) == NACK);
+    CHECK(len == 3 && resp[1] == BL_WINDOW_MAX && resp[2] == 0);
+
+    // bootloader section is write protected
+    pac[0] = 0;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_WINDOW_WRITE, pac, sizeof(pac), resp,
+                        &len) == NACK);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 8, -1,
+                                 &syncs) == 0);
+    CHECK(syncs == 1);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // a corrupted packet in the middle is NACKed by the next one
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 8, 37,
+                                 &syncs) == 0);
+    CHECK(syncs == 1);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // a corrupted last packet is only found by the sync
+    uint32_t last = IMAGESIZE / PAGESIZE - 1;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 4, last,
+                                 &syncs) == 0);
+    CHECK(syncs == 2);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // the stop-and-wait commands still work after a windowed session
+    CHECK(host_prog_cmd(fd, CMD_CHK_DEVICE, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == D_NUM487KM_DEVB);
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+
+    return TEST_RESULT("test_host_02");
+}
@@ -0,0 +1,107 @@
+/**
+ * @file test_host_03_baud.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Baud rate negotiation.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "bootprotocol.h"
+#include "commuch.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+static uint8_t resp[16];
+static int fd;
+
+/**
+ * @brief Ask for a rate without switching.
+ * @return int ACK / NACK, exact, actual and error of the reply.
+ */
+static int query(uint32_t baud, uint8_t *exact, uint32_t *actual, int32_t *err)
+{
+    uint8_t pac[5];
+    uint16_t len;
+    int res;
+
+    memcpy(pac, &baud, 4);
+    pac[4] = 1;
+    res = host_prog_cmd(fd, CMD_SET_BAUD, pac, 5, resp, &len);
+    if (len != 10)
+        return -1;
+    *exact = resp[1];
+    memcpy(actual, resp + 2, 4);
+    memcpy(err, resp + 6, 4);
+    return res;
+}
+
+int main()
+{
+    uint8_t exact;
+    uint32_t actual;
+    int32_t err;
+    uint32_t baud;
+    uint16_t len;
+
+    printf("[test_host_03]: baud rate negotiation ...\n");
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(com_channel_get_baud() == COM_CHANNEL_BAUD_DEFAULT);
+
+    // ********************************************************************** //
+
+    // 12 MHz / 4, / 8 and / 12 are exact
+    CHECK(query(3000000, &exact, &actual, &err) == ACK);
+    CHECK(exact == 1 && actual == 3000000 && err == 0);
+    CHECK(query(1500000, &exact, &actual, &err) == ACK && exact == 1);
+    CHECK(query(1000000, &exact, &actual, &err) == ACK && exact == 1);
+
+    // the usual PC rates are slightly off
+    CHECK(query(115200, &exact, &actual, &err) == ACK);
+    CHECK(exact == 0 && actual == 115384 && err == 1597);
+    CHECK(query(921600, &exact, &actual, &err) == ACK);
+    CHECK(exact == 0 && actual == 923076 && err == 1601);
+
+    // 12 MHz / 5 is 4 % below 2.5 Mbaud
+    CHECK(query(2500000, &exact, &actual, &err) == NACK);
+    CHECK(actual == 2400000 && err == -40000);
+
+    // out of range
+    CHECK(query(4000000, &exact, &actual, &err) == NACK);
+    CHECK(query(9600, &exact, &actual, &err) == NACK);
+    CHECK(com_channel_get_baud() == COM_CHANNEL_BAUD_DEFAULT);
+
+    // ********************************************************************** //
+
+    // switch, confirmed by the ping
+    CHECK(host_prog_set_baud(fd, 1000000) == 0);
+    CHECK(com_channel_get_baud() == 1000000);
+
+    // switch without the ping falls back to the previous rate
+    baud = 3000000;
+    CHECK(host_prog_cmd(fd, CMD_SET_BAUD, (uint8_t *) &baud, 4, resp, &len) ==
+          ACK);
+    usleep(100 * 1000);
+    CHECK(com_channel_get_baud() == 3000000);
+    usleep((BL_BAUD_CONFIRM_MS + 200) * 1000);
+    CHECK(com_channel_get_baud() == 1000000);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    CHECK(host_prog_set_baud(fd, COM_CHANNEL_BAUD_DEFAULT) == 0);
+    CHECK(com_channel_get_baud() == COM_CHANNEL_BAUD_DEFAULT);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_03");
+}
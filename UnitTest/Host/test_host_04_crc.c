@@ -0,0 +1,110 @@
+/**
+ * @file test_host_04_crc.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Protocol v2 framing with CRC-32.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bootprotocol.h"
+#include "crc32.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define PAGESIZE  512
+#define IMAGESIZE (16 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t pac[8 + PAGESIZE];
+static uint8_t resp[4 + PAGESIZE];
+
+int main()
+{
+    const uint8_t check[] = "123456789";
+    uint32_t addr = USER_APP_START;
+    uint16_t len;
+    int fd;
+
+    printf("[test_host_04]: protocol v2 framing ...\n");
+
+    srand(0x04);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    // CRC-32/ISO-HDLC check value, in one go and in pieces
+    CHECK(crc32_update(0, check, 9) == 0xCBF43926);
+    CHECK(crc32_update(crc32_update(0, check, 4), check + 4, 5) == 0xCBF43926);
+    CHECK(crc32_update(0, NULL, 0) == 0);
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+
+    // both framings are served, the reply tells which one was used
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == BL_PROTOCOL_V1);
+    host_prog_set_version(BL_PROTOCOL_V2);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2 && resp[1] == BL_PROTOCOL_V2);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+
+    // swapped bytes keep sum8 but break the CRC, the packet is dropped
+    uint8_t head[6] = {HEADER_V2, HEADER_V2, HEADER_V2, CMD_FLASH_WRITE,
+                       (4 + PAGESIZE) >> 8, (4 + PAGESIZE) & 0xFF};
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, image, PAGESIZE);
+    uint32_t crc = crc32_update(crc32_update(0, head, 6), pac, 4 + PAGESIZE);
+    uint8_t tmp = pac[10];
+    pac[10] = pac[11];
+    pac[11] = tmp;
+    CHECK(pac[10] != pac[11]);
+    CHECK(write(fd, head, 6) == 6);
+    CHECK(write(fd, pac, 4 + PAGESIZE) == 4 + PAGESIZE);
+    CHECK(write(fd, &crc, 4) == 4);
+
+    // the first reply is the one of the next command
+    CHECK(host_prog_cmd(fd, CMD_CHK_DEVICE, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 2);
+    CHECK(host_fmc_mem()[USER_APP_START + 10] == 0xFF);
+
+    // ********************************************************************** //
+
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        addr = USER_APP_START + ofs;
+        memcpy(pac, &addr, 4);
+        memcpy(pac + 4, image + ofs, PAGESIZE);
+        CHECK(host_prog_cmd(fd, CMD_FLASH_WRITE, pac, 4 + PAGESIZE, NULL,
+                            NULL) == ACK);
+    }
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // page read replies carry the CRC-32 behind the page
+    addr = USER_APP_START + PAGESIZE;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_READ, (uint8_t *) &addr, 4, resp, &len) ==
+          ACK);
+    CHECK(len == 1 + PAGESIZE);
+    CHECK(memcmp(resp + 1, image + PAGESIZE, PAGESIZE) == 0);
+
+    // windowed write with a corrupted packet
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 8, 5,
+                                 NULL) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_04");
+}
@@ -0,0 +1,136 @@
+/**
+ * @file test_host_05_delta.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Delta update reconstruction.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "crc32.h"
+#include "delta.h"
+#include "device.h"
+#include "host.h"
+#include "host_delta.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define OLDSIZE (96 * 1024)
+#define NEWSIZE (OLDSIZE + 100 - 50 + 2048)
+#define APPSIZE (USER_APP_SIZE - USER_APP_START)
+#define FMCPAGE 4096
+
+static uint8_t old_image[OLDSIZE];
+static uint8_t new_image[NEWSIZE];
+static uint8_t ops[HOST_DELTA_BOUND(NEWSIZE)];
+static uint8_t pac[16];
+
+static int erased(uint32_t from, uint32_t to)
+{
+    for (uint32_t addr = from; addr < to; addr++) {
+        if (host_fmc_mem()[addr] != 0xFF)
+            return 0;
+    }
+    return 1;
+}
+
+int main()
+{
+    uint32_t len, crc;
+    uint16_t rewritten;
+    int fd;
+
+    printf("[test_host_05]: delta update ...\n");
+
+    // new = old with a patch, 100 bytes inserted, 50 removed and a tail
+    srand(0x05);
+    for (int i = 0; i < OLDSIZE; i++)
+        old_image[i] = rand();
+    memcpy(new_image, old_image, 40000);
+    for (int i = 40000; i < 40100; i++)
+        new_image[i] = rand();
+    memcpy(new_image + 40100, old_image + 40000, 30000);
+    memcpy(new_image + 70100, old_image + 70050, OLDSIZE - 70050);
+    for (int i = OLDSIZE + 50; i < NEWSIZE; i++)
+        new_image[i] = rand();
+    new_image[1000] ^= 0x5A;
+    new_image[90000] ^= 0xA5;
+
+    len = host_delta_encode(old_image, OLDSIZE, new_image, NEWSIZE, ops);
+    printf("  %u byte image, %u byte delta\n", NEWSIZE, len);
+    CHECK(len > 0 && len < NEWSIZE / 20);
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, old_image, OLDSIZE, 16, -1,
+                                 NULL) == 0);
+
+    // ********************************************************************** //
+
+    // a wrong image CRC is caught before APROM is touched
+    crc = crc32_update(0, new_image, NEWSIZE);
+    CHECK(host_prog_write_delta(fd, ops, len, NEWSIZE, ~crc, NULL) == -1);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, old_image, OLDSIZE) == 0);
+
+    CHECK(host_prog_write_delta(fd, ops, len, NEWSIZE, crc, &rewritten) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, new_image, NEWSIZE) == 0);
+    CHECK(erased(USER_APP_START + NEWSIZE, USER_APP_SIZE));
+
+    // page 0 and the pages from offset 40000 up to the end of the new image
+    printf("  %u FMC pages rewritten\n", rewritten);
+    CHECK(rewritten == 1 + (NEWSIZE - 1) / FMCPAGE - 40000 / FMCPAGE + 1);
+
+    // the same image again changes nothing
+    len = host_delta_encode(new_image, NEWSIZE, new_image, NEWSIZE, ops);
+    CHECK(len == DELTA_COPY_SIZE);
+    CHECK(host_prog_write_delta(fd, ops, len, NEWSIZE, crc, &rewritten) == 0);
+    CHECK(rewritten == 0);
+
+    // ********************************************************************** //
+
+    // a retransmitted packet is applied once, pages past the image are erased
+    crc = crc32_update(0, (const uint8_t *) "abcd", 4);
+    memcpy(pac, &(uint32_t){4}, 4);
+    memcpy(pac + 4, &crc, 4);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_BEGIN, pac, 8, NULL, NULL) == ACK);
+    memset(pac, 0, 4);
+    memcpy(pac + 4, (uint8_t[]){DELTA_OP_INSERT, 4, 0, 'a', 'b', 'c', 'd'}, 7);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_DATA, pac, 11, NULL, NULL) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_DATA, pac, 11, NULL, NULL) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_END, NULL, 0, NULL, NULL) == ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, "abcd", 4) == 0);
+    CHECK(erased(USER_APP_START + 4, USER_APP_SIZE));
+
+    // empty image, malformed op, out of range COPY
+    memset(pac, 0, 8);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_BEGIN, pac, 8, NULL, NULL) == NACK);
+    memcpy(pac, &(uint32_t){4}, 4);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_BEGIN, pac, 8, NULL, NULL) == ACK);
+    memset(pac, 0, 4);
+    pac[4] = 0x7F;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_DATA, pac, 5, NULL, NULL) == NACK);
+    memcpy(pac, &(uint32_t){4}, 4);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_BEGIN, pac, 8, NULL, NULL) == ACK);
+    memset(pac, 0, 4);
+    pac[4] = DELTA_OP_COPY;
+    memcpy(pac + 5, &(uint32_t){APPSIZE - 2}, 4);
+    memcpy(pac + 9, &(uint32_t){4}, 4);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_DATA, pac, 13, NULL, NULL) == NACK);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_DELTA_END, NULL, 0, NULL, NULL) == NACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, "abcd", 4) == 0);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_05");
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_host_06_sync.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Page sync by FMC checksum.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "crc32.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define OLDSIZE (200 * 1024)
+#define NEWSIZE (OLDSIZE + 1000)
+#define FMCPAGE HOST_SYNC_PAGE
+
+static uint8_t old_image[OLDSIZE];
+static uint8_t new_image[NEWSIZE];
+static uint8_t pac[4 + 4 * (BL_SYNC_PAGES_MAX + 1)];
+static uint8_t resp[32];
+
+static int erased(uint32_t from, uint32_t to)
+{
+    for (uint32_t addr = from; addr < to; addr++) {
+        if (host_fmc_mem()[addr] != 0xFF)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Send a manifest of count pages at addr, all CRCs of erased pages.
+ */
+static int manifest(int fd, uint32_t addr, uint16_t count, uint16_t len)
+{
+    uint8_t page[FMCPAGE];
+    uint32_t crc;
+
+    memset(page, 0xFF, FMCPAGE);
+    crc = crc32_update(0, page, FMCPAGE);
+    memcpy(pac, &addr, 4);
+    for (uint16_t i = 0; i < count; i++)
+        memcpy(pac + 4 + i * 4, &crc, 4);
+    if (!len)
+        len = 4 + count * 4;
+    return host_prog_cmd(fd, CMD_FLASH_SYNC_PAGE, pac, len, resp, NULL);
+}
+
+int main()
+{
+    uint16_t rewritten;
+    int fd;
+
+    printf("[test_host_06]: page sync ...\n");
+
+    // new = old with a patch in page 3, two bytes across pages 20 / 21 and a
+    // tail in a new partial page
+    srand(0x06);
+    for (int i = 0; i < OLDSIZE; i++)
+        old_image[i] = rand();
+    memcpy(new_image, old_image, OLDSIZE);
+    for (int i = 3 * FMCPAGE + 100; i < 3 * FMCPAGE + 300; i++)
+        new_image[i] = rand();
+    new_image[21 * FMCPAGE - 1] ^= 0x01;
+    new_image[21 * FMCPAGE] ^= 0x80;
+    for (int i = OLDSIZE; i < NEWSIZE; i++)
+        new_image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    CHECK(host_prog_erase(fd, USER_APP_START, OLDSIZE) == 0);
+    CHECK(host_prog_write_window(fd, USER_APP_START, old_image, OLDSIZE, 16, -1,
+                                 NULL) == 0);
+
+    // ********************************************************************** //
+
+    // only the changed pages are erased and programmed
+    host_stats_reset();
+    CHECK(host_prog_sync_app(fd, new_image, NEWSIZE, &rewritten) == 0);
+    printf("  %u pages rewritten, %llu checksums, %llu erases\n", rewritten,
+           (unsigned long long) host_stats.fmc_isp_cks,
+           (unsigned long long) host_stats.fmc_isp_erase);
+    CHECK(rewritten == 4);
+    CHECK(host_stats.fmc_isp_erase == 4);
+    CHECK(host_stats.fmc_isp_cks == (USER_APP_SIZE - USER_APP_START) / FMCPAGE);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, new_image, NEWSIZE) == 0);
+    CHECK(erased(USER_APP_START + NEWSIZE, USER_APP_SIZE));
+
+    // the same image again touches nothing
+    host_stats_reset();
+    CHECK(host_prog_sync_app(fd, new_image, NEWSIZE, &rewritten) == 0);
+    CHECK(rewritten == 0);
+    CHECK(host_stats.fmc_isp_erase == 0 && host_stats.fmc_isp_program == 0);
+
+    // a shorter image erases the pages it no longer covers
+    CHECK(host_prog_sync_app(fd, old_image, 10 * FMCPAGE, &rewritten) == 0);
+    CHECK(rewritten == (NEWSIZE + FMCPAGE - 1) / FMCPAGE - 10 + 1);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, old_image, 10 * FMCPAGE) ==
+          0);
+    CHECK(erased(USER_APP_START + 10 * FMCPAGE, USER_APP_SIZE));
+
+    // ********************************************************************** //
+
+    // the reply bitmap covers the pages of the request, pages 8 and 9 differ
+    // from an erased page
+    CHECK(manifest(fd, USER_APP_START + 8 * FMCPAGE, 4, 0) == ACK);
+    CHECK(resp[1] == 0x03);
+
+    // malformed manifests touch nothing
+    host_stats_reset();
+    CHECK(manifest(fd, USER_APP_START + 512, 1, 0) == NACK);
+    CHECK(manifest(fd, BOOTLOADER_START, 1, 0) == NACK);
+    CHECK(manifest(fd, USER_APP_SIZE - FMCPAGE, 2, 0) == NACK);
+    CHECK(manifest(fd, USER_APP_START, BL_SYNC_PAGES_MAX + 1, 0) == NACK);
+    CHECK(manifest(fd, USER_APP_START, 1, 6) == NACK);
+    CHECK(manifest(fd, USER_APP_START, 0, 4) == NACK);
+    CHECK(host_stats.fmc_isp_erase == 0 && host_stats.fmc_isp_cks == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, old_image, 8 * FMCPAGE) ==
+          0);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_06");
+}
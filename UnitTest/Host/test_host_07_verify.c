@@ -0,0 +1,111 @@
+/**
+ * @file test_host_07_verify.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Flash verify by range checksum.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define APPSIZE   (USER_APP_SIZE - USER_APP_START)
+#define IMAGESIZE (100 * 1024 + 3)
+
+static uint8_t image[APPSIZE];
+
+/**
+ * @brief Send CMD_FLASH_VERIFY for a raw range.
+ */
+static int verify(int fd, uint32_t addr, uint32_t len, uint16_t pac_len)
+{
+    uint8_t pac[8];
+
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &len, 4);
+    return host_prog_cmd(fd, CMD_FLASH_VERIFY, pac, pac_len, NULL, NULL);
+}
+
+int main()
+{
+    int fd;
+
+    printf("[test_host_07]: flash verify ...\n");
+
+    srand(0x07);
+    for (int i = 0; i < APPSIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, APPSIZE, 16, -1,
+                                 NULL) == 0);
+
+    // ********************************************************************** //
+
+    // the whole user app in one round trip, no readback
+    host_stats_reset();
+    CHECK(host_prog_verify(fd, USER_APP_START, image, APPSIZE) == 0);
+    CHECK(host_stats.uart_rx_bytes + host_stats.uart_tx_bytes < 32);
+    CHECK(host_stats.fmc_isp_read == 0);
+    CHECK(host_stats.fmc_isp_cks == APPSIZE / 4096);
+
+    // a single flipped bit is caught
+    host_fmc_mem()[USER_APP_START + APPSIZE - 1] ^= 0x10;
+    CHECK(host_prog_verify(fd, USER_APP_START, image, APPSIZE) == 1);
+    CHECK(host_prog_verify(fd, USER_APP_START, image, APPSIZE - 512) == 0);
+
+    // an image whose length is not a multiple of 512 is padded with 0xFF
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE & ~511,
+                                 16, -1, NULL) == 0);
+    CHECK(host_prog_verify(fd, USER_APP_START, image, IMAGESIZE & ~511) == 0);
+    CHECK(host_prog_verify(fd, USER_APP_START, image, IMAGESIZE) == 1);
+    memcpy(host_fmc_mem() + USER_APP_START + (IMAGESIZE & ~511),
+           image + (IMAGESIZE & ~511), IMAGESIZE % 512);
+    CHECK(host_prog_verify(fd, USER_APP_START, image, IMAGESIZE) == 0);
+
+    // ********************************************************************** //
+
+    // ranges the FMC engine cannot check, or outside the user app
+    CHECK(verify(fd, USER_APP_START + 4, 512, 8) == NACK);
+    CHECK(verify(fd, USER_APP_START, 500, 8) == NACK);
+    CHECK(verify(fd, USER_APP_START, 0, 8) == NACK);
+    CHECK(verify(fd, BOOTLOADER_START, 512, 8) == NACK);
+    CHECK(verify(fd, USER_APP_SIZE - 512, 1024, 8) == NACK);
+    CHECK(verify(fd, USER_APP_START, 512, 4) == NACK);
+    CHECK(verify(fd, USER_APP_START, 512, 8) == ACK);
+
+    // part of a page is read by the CPU, the engine takes whole pages only
+    host_stats_reset();
+    CHECK(host_prog_verify(fd, USER_APP_START + 512, image + 512, 4096) == 0);
+    CHECK(host_stats.fmc_isp_cks == 0 && host_stats.fmc_isp_read == 1024);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+
+    // the engine against zlib crc32() values, not against crc32_update()
+    memset(host_fmc_mem() + USER_APP_START, 0xFF, 4096);
+    CHECK(FMC_GetChkSum(USER_APP_START, 4096) == 0xF154670A);
+    for (int i = 0; i < 8192; i++)
+        host_fmc_mem()[USER_APP_START + i] = i;
+    CHECK(FMC_GetChkSum(USER_APP_START, 4096) == 0xA2912082);
+    CHECK(FMC_GetChkSum(USER_APP_START, 8192) == 0xB6675307);
+    CHECK(FMC_GetChkSum(USER_APP_START, 512) == 0 && g_FMC_i32ErrCode == 0);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_07");
+}
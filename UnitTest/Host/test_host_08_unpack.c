@@ -0,0 +1,191 @@
+/**
+ * @file test_host_08_unpack.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Compressed flash write.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_pack.h"
+#include "host_prog.h"
+#include "host_test.h"
+#include "unpack.h"
+
+#define IMAGESIZE (96 * 1024 + 333)
+#define NOISESIZE 5000
+
+static uint8_t image[IMAGESIZE];
+static uint8_t stream[HOST_PACK_BOUND(IMAGESIZE)];
+static uint8_t pac[4 + 512];
+static uint8_t resp[16];
+
+static int erased(uint32_t from, uint32_t to)
+{
+    for (uint32_t addr = from; addr < to; addr++) {
+        if (host_fmc_mem()[addr] != 0xFF)
+            return 0;
+    }
+    return 1;
+}
+
+static int begin(int fd, uint32_t addr, uint32_t size)
+{
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &size, 4);
+    return host_prog_cmd(fd, CMD_FLASH_UNPACK_BEGIN, pac, 8, NULL, NULL);
+}
+
+/**
+ * @brief Send stream[ofs, ofs + len), the reply carries the bytes written.
+ */
+static int data(int fd, uint32_t ofs, uint32_t len, uint32_t *written)
+{
+    uint16_t resp_len;
+    int res;
+
+    memcpy(pac, &ofs, 4);
+    memcpy(pac + 4, stream + ofs, len);
+    res = host_prog_cmd(fd, CMD_FLASH_UNPACK_DATA, pac, 4 + len, resp,
+                        &resp_len);
+    if (resp_len != 5)
+        return -1;
+    memcpy(written, resp + 1, 4);
+    return res;
+}
+
+/**
+ * @brief Something like a linked image: code, strings, zeroed tables and
+ *        0xFF padding between sections.
+ */
+static void make_image(void)
+{
+    static const char *strings[] = {"flash_write_app_page failed\n",
+                                    "lfs_mount: corrupted dir pair\n",
+                                    "UART0 overrun\n", "NuM487BOOT v2\n"};
+    uint32_t pos = 0;
+
+    srand(0x08);
+    while (pos < IMAGESIZE) {
+        uint32_t n = 256 + rand() % 2048;
+        int kind = rand() % 4;
+
+        if (n > IMAGESIZE - pos)
+            n = IMAGESIZE - pos;
+        for (uint32_t i = 0; i < n; i++) {
+            if (kind == 0)  // code: a few thumb opcodes and random operands
+                image[pos + i] = (i & 1) ? 0x46 + rand() % 4 : rand();
+            else if (kind == 1)
+                image[pos + i] = strings[(i / 32) % 4][i % 14];
+            else if (kind == 2)
+                image[pos + i] = 0x00;
+            else
+                image[pos + i] = 0xFF;
+        }
+        pos += n;
+    }
+}
+
+int main()
+{
+    uint32_t len, written;
+    int fd;
+
+    printf("[test_host_08]: compressed flash write ...\n");
+
+    make_image();
+    len = host_pack(image, IMAGESIZE, stream);
+    printf("  %u byte image, %u byte stream\n", IMAGESIZE, len);
+    CHECK(len > 0 && len < IMAGESIZE / 2);
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    // whole image, the last page is padded
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_packed(fd, USER_APP_START, stream, len, IMAGESIZE) ==
+          0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+    CHECK(host_prog_verify(fd, USER_APP_START, image, IMAGESIZE) == 0);
+
+    // the rest of the section is erased once it is read
+    memcpy(pac, "\x00\x00\x01\x00\x00\x00\x07\x00", 8);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_VERIFY, pac, 8, NULL, NULL) == ACK);
+    CHECK(erased(USER_APP_START + IMAGESIZE, USER_APP_SIZE));
+
+    // incompressible data only costs the tokens
+    for (int i = 0; i < NOISESIZE; i++)
+        image[i] = rand();
+    len = host_pack(image, NOISESIZE, stream);
+    CHECK(len > 0 && len <= HOST_PACK_BOUND(NOISESIZE));
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_packed(fd, USER_APP_START + 0x8000, stream, len,
+                                 NOISESIZE) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START + 0x8000, image, NOISESIZE) ==
+          0);
+
+    // ********************************************************************** //
+
+    // retransmitted and overlapping packets are applied once, a gap is NACKed
+    // without aborting
+    make_image();
+    len = host_pack(image, IMAGESIZE, stream);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(begin(fd, USER_APP_START, IMAGESIZE) == ACK);
+    CHECK(data(fd, 0, 512, &written) == ACK);
+    CHECK(data(fd, 0, 512, &written) == ACK);
+    CHECK(data(fd, 1024, 512, &written) == NACK);
+    CHECK(data(fd, 256, 512, &written) == ACK);
+    for (uint32_t ofs = 768; ofs < len; ofs += 512)
+        CHECK(data(fd, ofs, (len - ofs < 512) ? len - ofs : 512, &written) ==
+              ACK);
+    CHECK(written == IMAGESIZE);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // nothing is accepted past the end of the image
+    CHECK(data(fd, len - 1, 2, &written) == NACK);
+
+    // ********************************************************************** //
+
+    // a match reaching before the image aborts the write
+    CHECK(begin(fd, USER_APP_START, 4096) == ACK);
+    memcpy(stream, "\x10\xAA\x02\x00", 4);
+    CHECK(data(fd, 0, 4, &written) == NACK);
+    CHECK(data(fd, 4, 1, &written) == NACK);
+
+    // a match offset beyond the window, after UNPACK_WINDOW + 1 literals
+    memset(stream, 0, 4115 + 2);
+    stream[0] = 0xF0;
+    memset(stream + 1, 255, 16);
+    stream[17] = UNPACK_WINDOW + 1 - 15 - 255 * 16;
+    stream[4115] = (UNPACK_WINDOW + 1) & 0xFF;
+    stream[4116] = (UNPACK_WINDOW + 1) >> 8;
+    CHECK(begin(fd, USER_APP_START, 8192) == ACK);
+    for (uint32_t ofs = 0; ofs < 4096; ofs += 512)
+        CHECK(data(fd, ofs, 512, &written) == ACK);
+    CHECK(data(fd, 4096, 4117 - 4096, &written) == NACK);
+    CHECK(written == UNPACK_WINDOW + 1);
+
+    // bad ranges
+    CHECK(begin(fd, USER_APP_START + 4, 512) == NACK);
+    CHECK(begin(fd, USER_APP_START, 0) == NACK);
+    CHECK(begin(fd, BOOTLOADER_START, 512) == NACK);
+    CHECK(begin(fd, USER_APP_SIZE - 512, 1024) == NACK);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_08");
+}
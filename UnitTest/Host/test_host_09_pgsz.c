@@ -0,0 +1,130 @@
+/**
+ * @file test_host_09_pgsz.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Negotiated flash page size.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_pack.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define IMAGESIZE (48 * 1024)  // whole pages of every size tested
+
+static uint8_t image[IMAGESIZE];
+static uint8_t stream[HOST_PACK_BOUND(IMAGESIZE)];
+static uint8_t pac[BL_DATA_MAX + 16];
+static uint8_t resp[65536];
+
+static int set_pgsz(int fd, uint16_t size)
+{
+    return host_prog_cmd(fd, CMD_FLASH_SET_PGSZ, (uint8_t *) &size, 2, NULL,
+                         NULL);
+}
+
+/**
+ * @brief Program, read back and check the image with pages of pgsz bytes.
+ */
+static int round_trip(int fd, uint16_t pgsz)
+{
+    uint16_t len;
+
+    if (host_prog_set_pgsz(fd, pgsz) ||
+        host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) != ACK ||
+        host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 8, -1,
+                               NULL) ||
+        memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE))
+        return -1;
+
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += pgsz) {
+        uint32_t addr = USER_APP_START + ofs;
+        if (host_prog_cmd(fd, CMD_FLASH_READ, (uint8_t *) &addr, 4, resp,
+                          &len) != ACK ||
+            len != 1 + pgsz || memcmp(resp + 1, image + ofs, pgsz))
+            return -1;
+    }
+    return 0;
+}
+
+int main()
+{
+    uint32_t addr = USER_APP_START;
+    uint16_t len, rewritten;
+    int fd;
+
+    printf("[test_host_09]: flash page size ...\n");
+
+    srand(0x09);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    // 256 * N up to the FMC page
+    CHECK(host_prog_cmd(fd, CMD_FLASH_GET_PGSZ, NULL, 0, resp, &len) == ACK);
+    CHECK(len == 3 && resp[1] == 0x00 && resp[2] == 0x02);
+    CHECK(set_pgsz(fd, 0) == NACK);
+    CHECK(set_pgsz(fd, 100) == NACK);
+    CHECK(set_pgsz(fd, 257) == NACK);
+    CHECK(set_pgsz(fd, 4096 + 256) == NACK);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_GET_PGSZ, NULL, 0, resp, &len) == ACK);
+    CHECK(resp[1] == 0x00 && resp[2] == 0x02);
+
+    CHECK(round_trip(fd, 256) == 0);
+    CHECK(round_trip(fd, 768) == 0);
+    CHECK(round_trip(fd, 4096) == 0);
+
+    // a page of the wrong size is refused
+    memcpy(pac, &addr, 4);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_WRITE, pac, 4 + 512, NULL, NULL) ==
+          NACK);
+
+    // page sync writes rows of the page size
+    image[5000] ^= 0xFF;
+    CHECK(host_prog_sync_app(fd, image, IMAGESIZE, &rewritten) == 0);
+    CHECK(rewritten == 1);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    // compressed writes do not depend on the page size
+    CHECK(host_prog_set_pgsz(fd, 768) == 0);
+    CHECK(host_prog_sync_app(fd, image, IMAGESIZE, NULL) == -1);
+    len = host_pack(image, IMAGESIZE - 100, stream);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_packed(fd, USER_APP_START, stream, len,
+                                 IMAGESIZE - 100) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE - 100) ==
+          0);
+
+    // ********************************************************************** //
+
+    // a packet longer than the buffer is dropped, the next one is served
+    memset(pac, 0x5A, sizeof(pac));
+    CHECK(host_prog_put(fd, CMD_CHK_PROTOCOL, pac, BL_DATA_MAX + 1) == 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+    host_prog_set_version(BL_PROTOCOL_V2);
+    CHECK(host_prog_put(fd, CMD_CHK_PROTOCOL, pac, BL_DATA_MAX + 16) == 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+    host_prog_set_version(BL_PROTOCOL_V1);
+
+    CHECK(host_prog_set_pgsz(fd, 512) == 0);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_09");
+}
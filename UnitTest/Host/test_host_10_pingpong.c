@@ -0,0 +1,168 @@
+/**
+ * @file test_host_10_pingpong.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Windowed writes received ahead into the other packet buffer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define PAGESIZE  512
+#define IMAGESIZE (64 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t burst[2 * (8 + 8 + PAGESIZE)];
+static uint8_t resp[65536];
+
+/**
+ * @brief Append a v1 frame to the burst.
+ */
+static uint32_t frame(uint32_t pos, uint8_t cmd, const uint8_t *data,
+                      uint16_t len)
+{
+    uint8_t chksum = 0;
+
+    memset(burst + pos, HEADER, 3);
+    burst[pos + 3] = cmd;
+    burst[pos + 4] = len >> 8;
+    burst[pos + 5] = len & 0xFF;
+    memcpy(burst + pos + 6, data, len);
+    for (uint16_t i = 0; i < len; i++)
+        chksum += data[i];
+    burst[pos + 6 + len] = chksum;
+    return pos + 7 + len;
+}
+
+/**
+ * @brief Window write of the first image page with sequence number 0.
+ */
+static uint32_t frame_page(uint32_t pos)
+{
+    uint8_t pac[8 + PAGESIZE] = {0};
+    uint32_t addr = USER_APP_START;
+
+    memcpy(pac + 4, &addr, 4);
+    memcpy(pac + 8, image, PAGESIZE);
+    return frame(pos, CMD_FLASH_WINDOW_WRITE, pac, sizeof(pac));
+}
+
+static int get_reply(int fd, uint8_t cmd)
+{
+    uint8_t rcmd;
+    uint16_t len;
+
+    if (host_prog_get(fd, &rcmd, resp, &len) || rcmd != cmd || len == 0)
+        return -1;
+    return resp[0];
+}
+
+static int open_window(int fd)
+{
+    uint8_t n = 4;
+    return host_prog_cmd(fd, CMD_FLASH_WINDOW_OPEN, &n, 1, NULL, NULL);
+}
+
+int main()
+{
+    uint32_t pos;
+    int fd;
+
+    printf("[test_host_10]: ping-pong packet buffers ...\n");
+
+    srand(0x10);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    // the pages in flight are taken into the other buffer
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    host_stats_reset();
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 16, 41,
+                                 NULL) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+    printf("  %llu of %llu bytes received ahead\n",
+           (unsigned long long) host_stats.uart_rx_async,
+           (unsigned long long) host_stats.uart_rx_bytes);
+    CHECK(host_stats.uart_rx_async > 0);
+
+    // also with v2 framing and whole FMC pages
+    host_prog_set_version(BL_PROTOCOL_V2);
+    CHECK(host_prog_set_pgsz(fd, 4096) == 0);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 16, 5,
+                                 NULL) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+    CHECK(host_prog_set_pgsz(fd, PAGESIZE) == 0);
+    host_prog_set_version(BL_PROTOCOL_V1);
+
+    // ********************************************************************** //
+
+    // any command may follow a page in the same burst
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(open_window(fd) == ACK);
+    pos = frame_page(0);
+    pos = frame(pos, CMD_CHK_DEVICE, NULL, 0);
+    CHECK(write(fd, burst, pos) == pos);
+    CHECK(get_reply(fd, CMD_FLASH_WINDOW_WRITE) == ACK);
+    CHECK(get_reply(fd, CMD_CHK_DEVICE) == ACK);
+    CHECK(resp[1] == D_NUM487KM_DEVB);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, PAGESIZE) == 0);
+
+    // garbage after a page is skipped as before
+    CHECK(open_window(fd) == ACK);
+    pos = frame_page(0);
+    memcpy(burst + pos, "\x00\x11\xA5\x22", 4);
+    pos = frame(pos + 4, CMD_CHK_PROTOCOL, NULL, 0);
+    CHECK(write(fd, burst, pos) == pos);
+    CHECK(get_reply(fd, CMD_FLASH_WINDOW_WRITE) == ACK);
+    CHECK(get_reply(fd, CMD_CHK_PROTOCOL) == ACK);
+
+    // a packet received ahead that stalls is dropped after the timeout
+    CHECK(open_window(fd) == ACK);
+    pos = frame_page(0);
+    pos = frame(pos, CMD_CHK_DEVICE, image, 64) - 32;
+    CHECK(write(fd, burst, pos) == pos);
+    CHECK(get_reply(fd, CMD_FLASH_WINDOW_WRITE) == ACK);
+    usleep(700 * 1000);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // so is one with a bad checksum, and one too long for the buffers
+    CHECK(open_window(fd) == ACK);
+    pos = frame_page(0);
+    pos = frame(pos, CMD_CHK_DEVICE, image, 64);
+    burst[pos - 1] ^= 0xFF;
+    CHECK(write(fd, burst, pos) == pos);
+    CHECK(get_reply(fd, CMD_FLASH_WINDOW_WRITE) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    CHECK(open_window(fd) == ACK);
+    pos = frame_page(0);
+    CHECK(write(fd, burst, pos) == pos);
+    CHECK(host_prog_put(fd, CMD_FLASH_WINDOW_WRITE, resp, BL_DATA_MAX + 1) ==
+          0);
+    CHECK(get_reply(fd, CMD_FLASH_WINDOW_WRITE) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_10");
+}
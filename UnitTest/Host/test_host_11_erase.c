@@ -0,0 +1,130 @@
+/**
+ * @file test_host_11_erase.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Deferred flash erase.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+
+#define FMCPAGE   4096
+#define IMAGESIZE (40 * 1024)
+#define APPSIZE   (USER_APP_SIZE - USER_APP_START)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t resp[65536];
+
+static int filled(uint32_t from, uint32_t to, uint8_t value)
+{
+    for (uint32_t addr = from; addr < to; addr++) {
+        if (host_fmc_mem()[addr] != value)
+            return 0;
+    }
+    return 1;
+}
+
+static int erase(int fd, uint32_t addr, uint32_t len, uint16_t pac_len)
+{
+    uint8_t pac[8];
+
+    memcpy(pac, &addr, 4);
+    memcpy(pac + 4, &len, 4);
+    return host_prog_cmd(fd, CMD_FLASH_ERASE_SECTOR, pac, pac_len, NULL,
+                         NULL);
+}
+
+int main()
+{
+    uint32_t addr;
+    uint16_t len;
+    int fd;
+
+    printf("[test_host_11]: deferred flash erase ...\n");
+
+    srand(0x11);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    // whole FMC pages inside the user app section
+    CHECK(erase(fd, USER_APP_START + 512, FMCPAGE, 8) == NACK);
+    CHECK(erase(fd, USER_APP_START, 1000, 8) == NACK);
+    CHECK(erase(fd, USER_APP_START, 0, 8) == NACK);
+    CHECK(erase(fd, BOOTLOADER_START, FMCPAGE, 8) == NACK);
+    CHECK(erase(fd, USER_APP_SIZE - FMCPAGE, 2 * FMCPAGE, 8) == NACK);
+    CHECK(erase(fd, USER_APP_START, FMCPAGE, 4) == NACK);
+
+    // an old app all over the section, only the pages of the image go
+    memset(host_fmc_mem() + USER_APP_START, 0x00, APPSIZE);
+    host_stats_reset();
+    CHECK(host_prog_erase(fd, USER_APP_START, IMAGESIZE) == 0);
+    CHECK(filled(USER_APP_START, USER_APP_START + IMAGESIZE, 0xFF));
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 16, 7,
+                                 NULL) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+    CHECK(filled(USER_APP_START + IMAGESIZE, USER_APP_SIZE, 0x00));
+
+    // 10 pages: two blocks in one trigger each, then two single pages
+    CHECK(host_stats.fmc_isp_erase == 4);
+
+    // ********************************************************************** //
+
+    // bank 0 pages go before the reply, bank 1 pages are deferred
+    memset(host_fmc_mem() + USER_APP_START, 0x00, APPSIZE);
+    CHECK(erase(fd, APROM_BANK1_START - 4 * FMCPAGE, 8 * FMCPAGE, 8) == ACK);
+    CHECK(filled(APROM_BANK1_START - 4 * FMCPAGE, APROM_BANK1_START, 0xFF));
+    CHECK(filled(APROM_BANK1_START, APROM_BANK1_START + 4 * FMCPAGE, 0x00));
+
+    // and bank 1 is programmed without stalling the bootloader
+    host_stats_reset();
+    CHECK(host_prog_write_window(fd, APROM_BANK1_START, image, 4 * FMCPAGE,
+                                 16, -1, NULL) == 0);
+    CHECK(memcmp(host_fmc_mem() + APROM_BANK1_START, image, 4 * FMCPAGE) ==
+          0);
+    CHECK(host_stats.fmc_isp_erase == 1);
+    CHECK(host_stats.fmc_bank0_erase == 0 && host_stats.fmc_bank0_program == 0);
+
+    // ********************************************************************** //
+
+    // erase all only schedules, the pages left are erased when read ...
+    memset(host_fmc_mem() + USER_APP_START, 0x00, APPSIZE);
+    CHECK(host_prog_cmd(fd, CMD_FLASH_ERASE_ALL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_write_window(fd, USER_APP_START, image, IMAGESIZE, 16, -1,
+                                 NULL) == 0);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+    CHECK(filled(USER_APP_SIZE - FMCPAGE, USER_APP_SIZE, 0x00));
+
+    addr = USER_APP_SIZE - 512;
+    CHECK(host_prog_cmd(fd, CMD_FLASH_READ, (uint8_t *) &addr, 4, resp,
+                        &len) == ACK);
+    CHECK(len == 1 + 512);
+    for (int i = 1; i <= 512; i++)
+        CHECK(resp[i] == 0xFF);
+    CHECK(filled(USER_APP_SIZE - FMCPAGE, USER_APP_SIZE, 0xFF));
+
+    // ... or at the end of the session
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+    CHECK(filled(USER_APP_START + IMAGESIZE, USER_APP_SIZE, 0xFF));
+
+    // ********************************************************************** //
+
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_11");
+}
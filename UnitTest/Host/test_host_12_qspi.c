@@ -0,0 +1,153 @@
+/**
+ * @file test_host_12_qspi.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief W25Q128JV quad read and program on QSPI0.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "NuMicro.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+#include "w25q128jv.h"
+
+#define PAGESIZE  512
+#define RECSIZE   (4 + PAGESIZE)
+#define IMAGESIZE (24 * 1024)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t rec[RECSIZE];
+static uint8_t buf[4096];
+
+/**
+ * @brief Program a pattern over a page boundary and read it back unaligned.
+ */
+static int round_trip(uint8_t seed)
+{
+    for (int i = 0; i < 512; i++)
+        buf[i] = seed + i * 7;
+    w25q128jv_erase_sector(2);
+    w25q128jv_write_sector(buf, 2, 100, 512);
+    if (host_spi_flash_mem()[2 * 4096 + 99] != 0xFF ||
+        memcmp(host_spi_flash_mem() + 2 * 4096 + 100, buf, 512))
+        return -1;
+
+    memset(buf, 0, sizeof(buf));
+    w25q128jv_read_bytes(buf, 2 * 4096 + 99, 514);
+    if (buf[0] != 0xFF || buf[513] != 0xFF)
+        return -1;
+    for (int i = 0; i < 512; i++) {
+        if (buf[1 + i] != (uint8_t) (seed + i * 7))
+            return -1;
+    }
+    w25q128jv_read_byte(buf, 2 * 4096 + 101);
+    return (buf[0] == (uint8_t) (seed + 7)) ? 0 : -1;
+}
+
+/**
+ * @brief Store the image in LittleFS and boot it, the SPI clocks it took.
+ */
+static uint64_t boot_clocks(int fd)
+{
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) == ACK);
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(rec, &addr, 4);
+        memcpy(rec + 4, image + ofs, PAGESIZE);
+        CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL,
+                            NULL) == ACK);
+    }
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) == ACK);
+
+    memset(host_fmc_mem() + USER_APP_START, 0x00, IMAGESIZE);
+    host_stats_reset();
+    CHECK(host_prog_cmd(fd, CMD_PROG_EXT_FLASH_BOOT, NULL, 0, NULL, NULL) ==
+          ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, IMAGESIZE) == 0);
+
+    return (host_stats.spi_bytes - host_stats.spi_quad_bytes) * 8 +
+           host_stats.spi_quad_bytes * 2;
+}
+
+int main()
+{
+    uint64_t single, quad;
+    int fd;
+
+    printf("[test_host_12]: quad SPI flash ...\n");
+
+    srand(0x12);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+
+    // ********************************************************************** //
+
+    // QE clear: single SPI only
+    CHECK(w25q128jv_probe_quad() == 0);
+    host_stats_reset();
+    CHECK(round_trip(0x11) == 0);
+    CHECK(host_stats.spi_quad_bytes == 0);
+
+    // QE set: the data phases go over 4 lanes, reads the address too
+    host_spi_flash_set_qe(1);
+    CHECK(w25q128jv_probe_quad() == 1);
+    host_stats_reset();
+    CHECK(round_trip(0x22) == 0);
+    CHECK(host_stats.spi_quad_bytes >= 512 + 514 + 6 + 1 + 6);
+    CHECK(w25q128jv_read_JEDEC_ID() == 0xEF4018);
+
+    // a flash that lost QE ignores the quad instructions
+    host_spi_flash_set_qe(0);
+    w25q128jv_read_bytes(buf, 2 * 4096 + 100, 16);
+    CHECK(buf[0] == 0xFF && buf[15] == 0xFF);
+    CHECK(w25q128jv_probe_quad() == 0);
+    CHECK(round_trip(0x33) == 0);
+
+    // the flash on SPI2: found there, single SPI even with QE set
+    CHECK(w25q128jv_on_qspi() == 1);
+    host_spi_flash_wire(SPI2);
+    host_spi_flash_set_qe(1);
+    CHECK(w25q128jv_probe_port() == 0);
+    CHECK(w25q128jv_on_qspi() == 0);
+    CHECK(w25q128jv_read_JEDEC_ID() == 0xEF4018);
+    host_stats_reset();
+    CHECK(round_trip(0x44) == 0);
+    CHECK(host_stats.spi_quad_bytes == 0 && host_stats.spi_pdma_bytes > 0);
+
+    // and back on QSPI0
+    host_spi_flash_wire(QSPI0);
+    CHECK(w25q128jv_probe_port() == 1);
+    host_stats_reset();
+    CHECK(round_trip(0x55) == 0);
+    CHECK(host_stats.spi_quad_bytes > 0);
+    host_spi_flash_set_qe(0);
+    CHECK(w25q128jv_probe_quad() == 0);
+
+    // ********************************************************************** //
+
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    single = boot_clocks(fd);
+    host_spi_flash_set_qe(1);
+    w25q128jv_probe_quad();
+    quad = boot_clocks(fd);
+    printf("  boot_from_fs: %llu SPI clocks single, %llu quad\n",
+           (unsigned long long) single, (unsigned long long) quad);
+    CHECK(quad * 2 < single);
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_12");
+}
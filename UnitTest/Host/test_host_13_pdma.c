@@ -0,0 +1,102 @@
+/**
+ * @file test_host_13_pdma.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief W25Q128JV data phases moved by PDMA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "boot_system.h"
+#include "host.h"
+#include "host_test.h"
+#include "w25q128jv.h"
+
+#define SECTOR 4096
+#define BIG    40000
+
+static uint8_t pattern[BIG];
+static uint8_t buf[BIG];
+static uint32_t other_irqs;
+
+static void other_done(void)
+{
+    other_irqs++;
+}
+
+/**
+ * @brief Program and read back one sector, single or quad.
+ */
+static void sector_round_trip(void)
+{
+    w25q128jv_erase_sector(3);
+
+    host_stats_reset();
+    w25q128jv_write_sector(pattern, 3, 0, SECTOR);
+    CHECK(memcmp(host_spi_flash_mem() + 3 * SECTOR, pattern, SECTOR) == 0);
+    CHECK(host_stats.spi_pdma_bytes == SECTOR);
+
+    // the data by PDMA, only the instruction is polled
+    host_stats_reset();
+    memset(buf, 0, SECTOR);
+    w25q128jv_read_sector(buf, 3, 0, SECTOR);
+    CHECK(memcmp(buf, pattern, SECTOR) == 0);
+    CHECK(host_stats.spi_pdma_bytes == SECTOR);
+    CHECK(host_stats.spi_bytes - host_stats.spi_pdma_bytes <= 7);
+}
+
+int main()
+{
+    printf("[test_host_13]: PDMA flash transfers ...\n");
+
+    srand(0x13);
+    for (int i = 0; i < BIG; i++)
+        pattern[i] = rand();
+
+    CHECK(host_spi_flash_open(NULL) == 0);
+    system_pdma_attach(0, other_done);
+
+    // ********************************************************************** //
+
+    w25q128jv_probe_quad();
+    sector_round_trip();
+    CHECK(host_stats.spi_quad_bytes == 0);
+
+    host_spi_flash_set_qe(1);
+    CHECK(w25q128jv_probe_quad() == 1);
+    sector_round_trip();
+    CHECK(host_stats.spi_quad_bytes >= SECTOR);
+
+    // ********************************************************************** //
+
+    // short data phases are polled
+    host_stats_reset();
+    w25q128jv_read_bytes(buf, 3 * SECTOR + 5, W25Q128JV_PDMA_MIN - 1);
+    CHECK(memcmp(buf, pattern + 5, W25Q128JV_PDMA_MIN - 1) == 0);
+    CHECK(host_stats.spi_pdma_bytes == 0);
+
+    host_stats_reset();
+    w25q128jv_read_bytes(buf, 3 * SECTOR + 5, W25Q128JV_PDMA_MIN);
+    CHECK(memcmp(buf, pattern + 5, W25Q128JV_PDMA_MIN) == 0);
+    CHECK(host_stats.spi_pdma_bytes == W25Q128JV_PDMA_MIN);
+
+    // longer than one PDMA transfer count
+    memcpy(host_spi_flash_mem() + 0x100000, pattern, BIG);
+    host_stats_reset();
+    memset(buf, 0, BIG);
+    w25q128jv_read_bytes(buf, 0x100000, BIG);
+    CHECK(memcmp(buf, pattern, BIG) == 0);
+    CHECK(host_stats.spi_pdma_bytes == BIG);
+    CHECK(host_stats.spi_commands == 1);
+
+    // the shared PDMA interrupt only calls the handler of the channel done
+    CHECK(other_irqs == 0);
+    system_pdma_attach(0, NULL);
+
+    // ********************************************************************** //
+
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_13");
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_host_14_stream.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief W25Q128JV reads across pages with one Fast Read, one or two buffers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "host_test.h"
+#include "w25q128jv.h"
+
+#define BASE  0x20000
+#define RANGE (3 * 65536)
+#define CHUNK 1000
+
+static uint8_t pattern[RANGE];
+static uint8_t buf[RANGE];
+static uint8_t chunk_buf[CHUNK];
+static uint8_t chunk_buf1[CHUNK];
+
+struct sink {
+    uint32_t next;   // flash address expected next
+    uint32_t chunks;
+    uint32_t stop;   // stop after this many chunks, 0: never
+    int mismatch;
+    const uint8_t *last;  // buffer of the chunk before
+    int swaps;
+};
+
+static uint8_t sink_chunk(void *ctx, const uint8_t *pbuf, uint32_t addr,
+                          uint32_t bytes)
+{
+    struct sink *sink = ctx;
+
+    if (addr != sink->next || bytes > CHUNK ||
+        memcmp(pbuf, pattern + addr - BASE, bytes))
+        sink->mismatch = 1;
+    sink->next = addr + bytes;
+    sink->chunks++;
+    if (sink->last && pbuf != sink->last)
+        sink->swaps++;
+    sink->last = pbuf;
+    return (sink->stop && sink->chunks == sink->stop) ? 0 : 1;
+}
+
+int main()
+{
+    struct sink sink;
+
+    printf("[test_host_14]: streaming flash read ...\n");
+
+    srand(0x14);
+    for (int i = 0; i < RANGE; i++)
+        pattern[i] = rand();
+
+    // ********************************************************************** //
+
+    // the first read probes QE before it selects the flash
+    CHECK(host_spi_flash_open(NULL) == 0);
+    memcpy(host_spi_flash_mem() + BASE, pattern, RANGE);
+    w25q128jv_read_bytes(buf, BASE, 16);
+    CHECK(memcmp(buf, pattern, 16) == 0);
+
+    // a sector and a block, one instruction each
+    host_stats_reset();
+    w25q128jv_read_sector(buf, BASE / 4096, 100, 4096);
+    CHECK(memcmp(buf, pattern + 100, 4096 - 100) == 0);
+    CHECK(host_stats.spi_commands == 1);
+
+    host_stats_reset();
+    w25q128jv_read_block(buf, BASE / 65536, 0, 0);
+    CHECK(memcmp(buf, pattern, 65536) == 0);
+    CHECK(host_stats.spi_commands == 1);
+    CHECK(host_stats.spi_bytes == 65536 + 5);
+
+    // ********************************************************************** //
+
+    // any range, chunk by chunk, across blocks
+    memset(&sink, 0, sizeof(sink));
+    sink.next = BASE + 7;
+    host_stats_reset();
+    CHECK(w25q128jv_read_stream(chunk_buf, CHUNK, BASE + 7, RANGE - 7,
+                                sink_chunk, &sink) == 1);
+    CHECK(!sink.mismatch);
+    CHECK(sink.next == BASE + RANGE);
+    CHECK(sink.chunks == (RANGE - 7 + CHUNK - 1) / CHUNK);
+    CHECK(host_stats.spi_commands == 1);
+
+    // the handler stops the read
+    memset(&sink, 0, sizeof(sink));
+    sink.next = BASE;
+    sink.stop = 3;
+    CHECK(w25q128jv_read_stream(chunk_buf, CHUNK, BASE, RANGE, sink_chunk,
+                                &sink) == 0);
+    CHECK(!sink.mismatch && sink.chunks == 3);
+
+    // the flash is deselected, the next instruction decodes
+    CHECK(w25q128jv_read_JEDEC_ID() == 0xEF4018);
+    CHECK(w25q128jv_read_stream(chunk_buf, 0, BASE, RANGE, sink_chunk,
+                                &sink) == 0);
+
+    // ********************************************************************** //
+
+    // two buffers in turn, still one instruction, the short tail polled
+    memset(&sink, 0, sizeof(sink));
+    sink.next = BASE;
+    host_stats_reset();
+    CHECK(w25q128jv_read_pipe(chunk_buf, chunk_buf1, CHUNK, BASE,
+                              10 * CHUNK + 20, sink_chunk, &sink) == 1);
+    CHECK(!sink.mismatch && sink.chunks == 11 && sink.swaps == 10);
+    CHECK(host_stats.spi_commands == 1);
+    CHECK(host_stats.spi_pdma_bytes == 10 * CHUNK);
+
+    // a stop with the next chunk in flight still ends the read
+    memset(&sink, 0, sizeof(sink));
+    sink.next = BASE;
+    sink.stop = 2;
+    CHECK(w25q128jv_read_pipe(chunk_buf, chunk_buf1, CHUNK, BASE, RANGE,
+                              sink_chunk, &sink) == 0);
+    CHECK(!sink.mismatch && sink.chunks == 2);
+    CHECK(w25q128jv_read_JEDEC_ID() == 0xEF4018);
+
+    // one PDMA transfer per chunk
+    CHECK(w25q128jv_read_pipe(buf, buf + RANGE / 2, 16384 + 4, BASE, RANGE,
+                              sink_chunk, &sink) == 0);
+
+    // ********************************************************************** //
+
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_14");
+}
@@ -0,0 +1,150 @@
+/**
+ * @file test_host_15_async.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief W25Q128JV queued program and erase, reads suspending an erase.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+#include "w25q128jv.h"
+
+#define BLOCK     65536
+#define PAGESIZE  512
+#define RECSIZE   (4 + PAGESIZE)
+#define IMAGESIZE (16 * 1024)
+
+static uint8_t pattern[BLOCK];
+static uint8_t src[BLOCK];
+static uint8_t buf[BLOCK];
+static uint8_t rec[RECSIZE];
+
+static int all(const uint8_t *p, uint8_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++) {
+        if (p[i] != value)
+            return 0;
+    }
+    return 1;
+}
+
+int main()
+{
+    uint8_t *nor;
+    int fd;
+
+    printf("[test_host_15]: async flash program and erase ...\n");
+
+    srand(0x15);
+    for (int i = 0; i < BLOCK; i++)
+        pattern[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    host_spi_flash_set_timing(1);
+    nor = host_spi_flash_mem();
+
+    // ********************************************************************** //
+
+    // the erase runs after the call returns, the array changes at the end
+    memset(nor + 2 * BLOCK, 0x00, BLOCK);
+    w25q128jv_erase_block_async(2);
+    CHECK(host_spi_flash_busy());
+    CHECK(w25q128jv_poll() == 1);
+    CHECK(all(nor + 2 * BLOCK, 0x00, BLOCK));
+    host_spi_flash_elapse(150000);
+    CHECK(w25q128jv_poll() == 0);
+    CHECK(all(nor + 2 * BLOCK, 0xFF, BLOCK));
+
+    // a read elsewhere suspends the erase and resumes it
+    memset(nor + 2 * BLOCK, 0x00, BLOCK);
+    memcpy(nor + 4 * BLOCK, pattern, BLOCK);
+    w25q128jv_erase_block_async(2);
+    host_stats_reset();
+    memset(buf, 0, BLOCK);
+    w25q128jv_read_bytes(buf, 4 * BLOCK, 4096);
+    CHECK(memcmp(buf, pattern, 4096) == 0);
+    CHECK(host_stats.nor_suspend == 1);
+    CHECK(host_spi_flash_busy());
+    CHECK(w25q128jv_poll() == 1);
+    w25q128jv_flush();
+    CHECK(!host_spi_flash_busy());
+    CHECK(all(nor + 2 * BLOCK, 0xFF, BLOCK));
+
+    // reads back to back, the erase still gets tSUS after every resume
+    memset(nor + 2 * BLOCK, 0x00, 4096);
+    w25q128jv_erase_sector_async(2 * BLOCK / 4096);
+    host_stats_reset();
+    for (int i = 0; i < 10000 && host_spi_flash_busy(); i++)
+        w25q128jv_read_bytes(buf, 4 * BLOCK + i % 64, 4);
+    CHECK(!host_spi_flash_busy());
+    CHECK(host_stats.nor_suspend > 100);
+    CHECK(host_stats.nor_suspend_early == 0);
+    CHECK(all(nor + 2 * BLOCK, 0xFF, 4096));
+    CHECK(w25q128jv_poll() == 0);
+
+    // a read of the erased range waits for the erase instead
+    memset(nor + 2 * BLOCK, 0x00, 4096);
+    w25q128jv_erase_sector_async(2 * BLOCK / 4096);
+    host_stats_reset();
+    w25q128jv_read_bytes(buf, 2 * BLOCK + 100, 16);
+    CHECK(all(buf, 0xFF, 16));
+    CHECK(host_stats.nor_suspend == 0);
+    CHECK(!host_spi_flash_busy());
+
+    // ********************************************************************** //
+
+    // more pages than queue slots, the data is copied on the way in
+    memcpy(src, pattern, BLOCK);
+    w25q128jv_write_bytes_async(src, 2 * BLOCK + 200, 2000);
+    memset(src, 0, BLOCK);
+    CHECK(w25q128jv_poll() <= W25Q128JV_QUEUE_DEPTH);
+    w25q128jv_flush();
+    CHECK(all(nor + 2 * BLOCK, 0xFF, 200));
+    CHECK(memcmp(nor + 2 * BLOCK + 200, pattern, 2000) == 0);
+    CHECK(all(nor + 2 * BLOCK + 2200, 0xFF, 4096 - 2200));
+
+    // the blocking calls return with the queue empty, a block is a block
+    w25q128jv_erase_block(5);
+    w25q128jv_write_block(pattern, 5, 0, 4096);
+    CHECK(w25q128jv_poll() == 0);
+    CHECK(memcmp(nor + 5 * BLOCK, pattern, 4096) == 0);
+    CHECK(w25q128jv_read_JEDEC_ID() == 0xEF4018);
+
+    // ********************************************************************** //
+
+    // LittleFS through the protocol with the flash taking its time
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) == ACK);
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += PAGESIZE) {
+        uint32_t addr = USER_APP_START + ofs;
+        memcpy(rec, &addr, 4);
+        memcpy(rec + 4, pattern + ofs, PAGESIZE);
+        CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL,
+                            NULL) == ACK);
+    }
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) == ACK);
+    CHECK(!host_spi_flash_busy());
+
+    memset(host_fmc_mem() + USER_APP_START, 0x00, IMAGESIZE);
+    CHECK(host_prog_cmd(fd, CMD_PROG_EXT_FLASH_BOOT, NULL, 0, NULL, NULL) ==
+          ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, pattern, IMAGESIZE) == 0);
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+
+    // ********************************************************************** //
+
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_15");
+}
@@ -0,0 +1,252 @@
+/**
+ * @file test_host_16_xip.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Image slots on the W25Q128JV run in place through SPIM, next to a
+ *        LittleFS formatted before the slots.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "device.h"
+#include "NuMicro.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+#include "lfs.h"
+#include "lfs_port.h"
+#include "w25q128jv.h"
+
+#define SLOT      3
+#define IMAGESIZE (20 * 1024)
+#define CHUNK     4096
+#define PAGESIZE  512
+#define RECSIZE   (4 + PAGESIZE)
+
+static uint8_t image[IMAGESIZE];
+static uint8_t rec[4 + CHUNK];
+
+static uint32_t slot_addr(uint32_t slot)
+{
+    return EXT_FLASH_SLOT_START + slot * EXT_FLASH_SLOT_SIZE;
+}
+
+static uint8_t erase(int fd, uint32_t addr, uint32_t len)
+{
+    uint32_t req[2] = {addr, len};
+
+    return host_prog_cmd(fd, CMD_EXT_FLASH_ERASE_SECTOR, (uint8_t *) req,
+                         sizeof(req), NULL, NULL);
+}
+
+static uint8_t xip(int fd, uint8_t slot)
+{
+    return host_prog_cmd(fd, CMD_PROG_EXT_FLASH_XIP, &slot, 1, NULL, NULL);
+}
+
+static uint8_t xip_select(int fd, uint8_t slot)
+{
+    return host_prog_cmd(fd, CMD_EXT_FLASH_XIP_SELECT, &slot, 1, NULL, NULL);
+}
+
+static uint8_t boot(int fd)
+{
+    return host_prog_cmd(fd, CMD_PROG_EXT_FLASH_BOOT, NULL, 0, NULL, NULL);
+}
+
+/**
+ * @brief A LittleFS over the whole chip as formatted before the slots, /boot
+ *        loading one page of image and with other a second file.
+ */
+static void format_chip(int other)
+{
+    lfs_file_t file;
+
+    memset(host_spi_flash_mem(), 0xFF, EXT_FLASH_SIZE);
+    memcpy(rec, &(uint32_t) {USER_APP_START}, 4);
+    memcpy(rec + 4, image, PAGESIZE);
+
+    cfg.block_count = EXT_FLASH_SIZE / 4096;
+    CHECK(lfs_format(&lfs_w25q128jv, &cfg) == 0);
+    CHECK(lfs_mount(&lfs_w25q128jv, &cfg) == 0);
+    CHECK(lfs_file_open(&lfs_w25q128jv, &file, "/boot",
+                        LFS_O_WRONLY | LFS_O_CREAT) == 0);
+    CHECK(lfs_file_write(&lfs_w25q128jv, &file, rec, RECSIZE) == RECSIZE);
+    CHECK(lfs_file_close(&lfs_w25q128jv, &file) == 0);
+    if (other) {
+        CHECK(lfs_file_open(&lfs_w25q128jv, &file, "/boot_count",
+                            LFS_O_WRONLY | LFS_O_CREAT) == 0);
+        CHECK(lfs_file_write(&lfs_w25q128jv, &file, image, 4) == 4);
+        CHECK(lfs_file_close(&lfs_w25q128jv, &file) == 0);
+    }
+    CHECK(lfs_unmount(&lfs_w25q128jv) == 0);
+}
+
+int main()
+{
+    uint32_t base = slot_addr(SLOT);
+    uint32_t *vectors = (uint32_t *) image;
+    uint8_t *nor;
+    int fd;
+
+    printf("[test_host_16]: execute in place from a slot ...\n");
+
+    // an image linked to the SPIM window of the slot
+    srand(0x16);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+    vectors[0] = SRAM_START + 0x8000;
+    vectors[1] = EXT_FLASH_XIP_BASE + base + 0x401;
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    nor = host_spi_flash_mem();
+    memset(nor + base, 0x00, EXT_FLASH_SLOT_SIZE);
+
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    // no filesystem: nothing to boot, APROM and the flash left alone
+    memset(nor, 0xFF, EXT_FLASH_SIZE);
+    memset(host_fmc_mem() + USER_APP_START, 0x00, 4096);
+    CHECK(boot(fd) == NACK);
+    CHECK(host_fmc_mem()[USER_APP_START] == 0x00);
+    CHECK(nor[0] == 0xFF && nor[4096] == 0xFF);
+    CHECK(!host_system_led());
+
+    // a filesystem over the whole chip still boots, the slots are its blocks
+    format_chip(1);
+    CHECK(boot(fd) == ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, PAGESIZE) == 0);
+    CHECK(!host_system_led());
+    CHECK(erase(fd, base, 4096) == NACK);
+    memcpy(rec, &base, 4);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_SLOT_WRITE, rec, 4 + 16, NULL,
+                        NULL) == NACK);
+    CHECK(xip(fd, SLOT) == NACK);
+    CHECK(xip_select(fd, SLOT) == NACK);
+
+    // rewriting /boot keeps it while another file is in it
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) == ACK);
+    memcpy(rec, &(uint32_t) {USER_APP_START}, 4);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL, NULL) ==
+          ACK);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) == ACK);
+    CHECK(cfg.block_count == EXT_FLASH_SIZE / 4096);
+    CHECK(erase(fd, base, 4096) == NACK);
+    CHECK(boot(fd) == ACK);
+
+    // a filesystem without /boot has nothing to boot either
+    format_chip(1);
+    CHECK(lfs_mount(&lfs_w25q128jv, &cfg) == 0);
+    CHECK(lfs_remove(&lfs_w25q128jv, "/boot") == 0);
+    CHECK(lfs_unmount(&lfs_w25q128jv) == 0);
+    memset(host_fmc_mem() + USER_APP_START, 0x00, 4096);
+    CHECK(boot(fd) == NACK);
+    CHECK(host_fmc_mem()[USER_APP_START] == 0x00);
+    CHECK(!host_system_led());
+
+    // with /boot alone it moves below the slots
+    format_chip(0);
+    memset(host_fmc_mem() + USER_APP_START, 0x00, 4096);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FOPEN, NULL, 0, NULL, NULL) == ACK);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_WRITE, rec, RECSIZE, NULL, NULL) ==
+          ACK);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_FCLOSE, NULL, 0, NULL, NULL) == ACK);
+    CHECK(cfg.block_count == EXT_FLASH_LFS_SIZE / 4096);
+    CHECK(boot(fd) == ACK);
+    CHECK(memcmp(host_fmc_mem() + USER_APP_START, image, PAGESIZE) == 0);
+    memset(nor + EXT_FLASH_SLOT_START, 0xFF,
+           EXT_FLASH_SIZE - EXT_FLASH_SLOT_START);
+    memset(nor + base, 0x00, EXT_FLASH_SLOT_SIZE);
+
+    // ********************************************************************** //
+
+    // slots only, whole sectors
+    CHECK(erase(fd, EXT_FLASH_SLOT_START - 4096, 4096) == NACK);
+    CHECK(erase(fd, base + 100, 4096) == NACK);
+    CHECK(erase(fd, base, 0) == NACK);
+    CHECK(erase(fd, slot_addr(EXT_FLASH_SLOT_COUNT) - 4096, 2 * 4096) == NACK);
+    memcpy(rec, &(uint32_t) {EXT_FLASH_LFS_SIZE - 4}, 4);
+    CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_SLOT_WRITE, rec, 4 + 16, NULL,
+                        NULL) == NACK);
+
+    // an erased slot has no vector table
+    host_stats_reset();
+    CHECK(erase(fd, base, 64 * 1024 + 4096) == ACK);
+    CHECK(xip(fd, SLOT) == NACK);
+    CHECK(host_stats.nor_erase == 2);
+    CHECK(nor[base + 64 * 1024 + 4095] == 0xFF);
+    CHECK(nor[base + 64 * 1024 + 4096] == 0x00);
+
+    for (uint32_t ofs = 0; ofs < IMAGESIZE; ofs += CHUNK) {
+        uint32_t addr = base + ofs;
+        memcpy(rec, &addr, 4);
+        memcpy(rec + 4, image + ofs, CHUNK);
+        CHECK(host_prog_cmd(fd, CMD_EXT_FLASH_SLOT_WRITE, rec, 4 + CHUNK, NULL,
+                            NULL) == ACK);
+    }
+
+    // linked for another slot, or no slot at all
+    CHECK(xip(fd, EXT_FLASH_SLOT_COUNT) == NACK);
+    CHECK(xip(fd, SLOT + 1) == NACK);
+    CHECK(!host_system_jumped());
+
+    // selected for RUN mode after reset, APROM until then
+    CHECK(xip_select(fd, EXT_FLASH_SLOT_COUNT) == NACK);
+    CHECK(xip_select(fd, SLOT + 1) == NACK);
+    CHECK(xip_select(fd, BL_XIP_NONE) == ACK);
+    CHECK(xip_select(fd, SLOT) == ACK);
+    CHECK(!host_system_jumped());
+
+    // nothing copied to APROM, the core goes to the SPIM window
+    host_stats_reset();
+    CHECK(xip(fd, SLOT) == ACK);
+    host_device_stop(fd);
+    CHECK(host_system_jumped());
+    CHECK(host_system_jump_vectors() == EXT_FLASH_XIP_BASE + base);
+    CHECK(memcmp(nor + base, image, IMAGESIZE) == 0);
+    CHECK(host_stats.fmc_isp_program == 0 && host_stats.fmc_isp_erase == 0);
+
+    // ********************************************************************** //
+
+    // RUN mode after reset: the selected slot in place, nothing on APROM
+    host_stats_reset();
+    CHECK(boot_from_xip() == 0);
+    CHECK(host_system_jump_vectors() == EXT_FLASH_XIP_BASE + base);
+    CHECK(host_stats.fmc_isp_program == 0 && host_stats.fmc_isp_erase == 0);
+
+    // a slot erased since falls back to APROM
+    memset(nor + base, 0xFF, 8);
+    CHECK(boot_from_xip() == 1);
+    memcpy(nor + base, image, 8);
+
+    // the flash on SPI2 has no XIP, the filesystem is not even mounted
+    host_spi_flash_wire(SPI2);
+    CHECK(w25q128jv_probe_port() == 0);
+    host_stats_reset();
+    CHECK(boot_from_xip() == 1);
+    CHECK(host_stats.spi_commands == 0);
+    host_spi_flash_wire(QSPI0);
+    CHECK(w25q128jv_probe_port() == 1);
+    CHECK(boot_from_xip() == 0);
+
+    // cleared, APROM again
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+    CHECK(xip_select(fd, BL_XIP_NONE) == ACK);
+    host_device_stop(fd);
+    CHECK(boot_from_xip() == 1);
+
+    // ********************************************************************** //
+
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_16");
+}
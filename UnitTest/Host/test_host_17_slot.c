@@ -0,0 +1,144 @@
+/**
+ * @file test_host_17_slot.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief Images installed from raw W25Q128JV slots, verified on the way.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bootprotocol.h"
+#include "crc32.h"
+#include "device.h"
+#include "host.h"
+#include "host_prog.h"
+#include "host_test.h"
+#include "mbedtls/sha256.h"
+#include "slot.h"
+
+#define IMAGESIZE (40 * 1024 + 12)
+#define LOAD      (APROM_BANK1_START - 8 * 1024)  // across the banks
+
+static uint8_t image[IMAGESIZE];
+
+static int install(int fd, uint8_t slot)
+{
+    return host_prog_cmd(fd, CMD_PROG_EXT_FLASH_SLOT, &slot, 1, NULL, NULL);
+}
+
+static int all(const uint8_t *p, uint8_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++) {
+        if (p[i] != value)
+            return 0;
+    }
+    return 1;
+}
+
+int main()
+{
+    mbedtls_sha256_context sha;
+    uint8_t *aprom, *nor, digest[32];
+    slot_header_t *hdr;
+    int fd;
+
+    printf("[test_host_17]: raw image slots ...\n");
+
+    srand(0x17);
+    for (int i = 0; i < IMAGESIZE; i++)
+        image[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    CHECK(host_spi_flash_open(NULL) == 0);
+    aprom = host_fmc_mem();
+    nor = host_spi_flash_mem();
+
+    fd = host_device_start();
+    CHECK(fd >= 0);
+    CHECK(host_prog_cmd(fd, CMD_CHK_PROTOCOL, NULL, 0, NULL, NULL) == ACK);
+
+    // ********************************************************************** //
+
+    // the image with one Fast Read, only its own FMC pages erased
+    memset(aprom + USER_APP_START, 0x00, USER_APP_SIZE - USER_APP_START);
+    CHECK(host_prog_write_slot(fd, 5, LOAD, image, IMAGESIZE) == 0);
+    host_stats_reset();
+    CHECK(install(fd, 5) == ACK);
+    CHECK(memcmp(aprom + LOAD, image, IMAGESIZE) == 0);
+    CHECK(aprom[LOAD - 1] == 0x00);
+    CHECK(aprom[LOAD + IMAGESIZE] == 0xFF);
+    CHECK(aprom[LOAD + 44 * 1024] == 0x00);
+    CHECK(host_stats.spi_commands <= 3);  // header, image, a status poll
+    CHECK(host_stats.spi_bytes < IMAGESIZE + 128);
+    CHECK(host_stats.sha_dma_bytes == IMAGESIZE);
+
+    // ********************************************************************** //
+
+    // a flipped bit fails, the pages are erased again
+    nor[slot_base(5) + 1000] ^= 0x04;
+    CHECK(install(fd, 5) == NACK);
+    CHECK(all(aprom + LOAD, 0xFF, 44 * 1024));
+    nor[slot_base(5) + 1000] ^= 0x04;
+    CHECK(install(fd, 5) == ACK);
+
+    // a digest of something else, with the CRC-32 still right
+    hdr = (slot_header_t *) (nor + slot_base(5) + SLOT_HEADER_OFS);
+    hdr->sha256[31] ^= 0x80;
+    hdr->hdr_crc = crc32_update(0, (const uint8_t *) hdr,
+                                offsetof(slot_header_t, hdr_crc));
+    host_stats_reset();
+    CHECK(install(fd, 5) == NACK);
+    CHECK(all(aprom + LOAD, 0xFF, 44 * 1024));
+    CHECK(host_stats.spi_bytes < IMAGESIZE + 128);  // no second pass
+    hdr->sha256[31] ^= 0x80;
+    hdr->hdr_crc = crc32_update(0, (const uint8_t *) hdr,
+                                offsetof(slot_header_t, hdr_crc));
+    CHECK(install(fd, 5) == ACK);
+    CHECK(memcmp(aprom + LOAD, image, IMAGESIZE) == 0);
+
+    // the commit itself fails, rolled back the same way
+    host_fmc_set_fail(LOAD);
+    CHECK(install(fd, 5) == NACK);
+    CHECK(all(aprom + LOAD, 0xFF, 44 * 1024));
+    host_fmc_set_fail(0xFFFFFFFF);
+    CHECK(install(fd, 5) == ACK);
+    CHECK(memcmp(aprom + LOAD, image, IMAGESIZE) == 0);
+
+    // an mbedtls message holds the CRPT engine, the install is refused
+    mbedtls_sha256_init(&sha);
+    CHECK(mbedtls_sha256_starts(&sha, 0) == 0);
+    CHECK(mbedtls_sha256_update(&sha, image, 4096) == 0);
+    CHECK(sha.path == SHA256_ALT_CRPT);
+    host_stats_reset();
+    CHECK(install(fd, 5) == NACK);
+    CHECK(host_stats.spi_bytes < 128 && host_stats.sha_dma_bytes == 0);
+    CHECK(host_stats.fmc_isp_erase == 0 && host_stats.fmc_isp_program == 0);
+    CHECK(mbedtls_sha256_finish(&sha, digest) == 0);
+    mbedtls_sha256_free(&sha);
+    CHECK(install(fd, 5) == ACK);
+
+    // no header, a damaged header, no slot
+    CHECK(install(fd, 6) == NACK);
+    nor[slot_base(5) + SLOT_HEADER_OFS + 8] ^= 0x01;
+    CHECK(install(fd, 5) == NACK);
+    CHECK(install(fd, EXT_FLASH_SLOT_COUNT) == NACK);
+
+    // the bootloader and beyond APROM are not for images
+    CHECK(host_prog_write_slot(fd, 6, BOOTLOADER_START, image, 4096) == 0);
+    CHECK(install(fd, 6) == NACK);
+    CHECK(host_prog_write_slot(fd, 6, USER_APP_SIZE - 4096, image, 8192) == 0);
+    CHECK(install(fd, 6) == NACK);
+    CHECK(host_prog_write_slot(fd, 6, USER_APP_SIZE - 4096, image, 4096) == 0);
+    CHECK(install(fd, 6) == ACK);
+    CHECK(memcmp(aprom + USER_APP_SIZE - 4096, image, 4096) == 0);
+
+    // ********************************************************************** //
+
+    CHECK(host_prog_cmd(fd, CMD_PROG_END, NULL, 0, NULL, NULL) == ACK);
+    host_device_stop(fd);
+    host_fmc_close();
+    host_spi_flash_close();
+
+    return TEST_RESULT("test_host_17");
+}
@@ -0,0 +1,199 @@
+/**
+ * @file test_host_18_sha256.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief mbedtls SHA-256 through sha256_alt.c, software and CRPT paths.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "host_test.h"
+#include "mbedtls/error.h"
+#include "mbedtls/sha256.h"
+#include "sha256_dma.h"
+
+#define BIGSIZE 1000000
+
+static uint8_t big[BIGSIZE + 4] __attribute__((__aligned__(4)));
+
+static const uint8_t abc256[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40,
+    0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17,
+    0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+static const uint8_t abc224[28] = {
+    0x23, 0x09, 0x7d, 0x22, 0x34, 0x05, 0xd8, 0x22, 0x86, 0x42,
+    0xa4, 0x77, 0xbd, 0xa2, 0x55, 0xb3, 0x2a, 0xad, 0xbc, 0xe4,
+    0xbd, 0xa0, 0xb3, 0xf7, 0xe3, 0x6c, 0x9d, 0xa7};
+static const uint8_t empty256[32] = {
+    0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4,
+    0xc8, 0x99, 0x6f, 0xb9, 0x24, 0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b,
+    0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55};
+static const uint8_t two256[32] = {  // the 56 byte FIPS 180-2 message
+    0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26,
+    0x93, 0x0c, 0x3e, 0x60, 0x39, 0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff,
+    0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1};
+static const uint8_t mil256[32] = {  // a million 'a'
+    0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7,
+    0xe2, 0x84, 0xd7, 0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97,
+    0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0};
+
+/**
+ * @brief Digest of p in parts of the given lengths, over and over.
+ */
+static int hash_parts(const uint8_t *p, uint32_t len, const uint32_t *parts,
+                      uint32_t n, int software, uint8_t out[32])
+{
+    mbedtls_sha256_context ctx;
+    uint32_t i = 0;
+    int ret = 0;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    if (software)
+        sha256_alt_software(&ctx);
+    while (len && !ret) {
+        uint32_t part = parts[i++ % n];
+        if (part > len)
+            part = len;
+        ret = mbedtls_sha256_update(&ctx, p, part);
+        p += part;
+        len -= part;
+    }
+    if (!ret)
+        ret = mbedtls_sha256_finish(&ctx, out);
+    mbedtls_sha256_free(&ctx);
+    return ret;
+}
+
+int main()
+{
+    static const uint32_t whole[] = {0xFFFFFFFF};
+    static const uint32_t odd[] = {1, 63, 65, 127, 129, 1000, 3, 4096};
+    mbedtls_sha256_context a, b, c;
+    uint8_t out[32], ref[32], *rnd;
+
+    printf("[test_host_18]: SHA-256 on the CRPT engine ...\n");
+
+    // ********************************************************************** //
+    // known answers, short messages stay in software
+    host_stats_reset();
+    CHECK(mbedtls_sha256((const uint8_t *) "", 0, out, 0) == 0);
+    CHECK(!memcmp(out, empty256, 32));
+    CHECK(mbedtls_sha256((const uint8_t *) "abc", 3, out, 0) == 0);
+    CHECK(!memcmp(out, abc256, 32));
+    CHECK(mbedtls_sha256((const uint8_t *) "abc", 3, out, 1) == 0);
+    CHECK(!memcmp(out, abc224, 28));
+    CHECK(mbedtls_sha256((const uint8_t *) "abcdbcdecdefdefgefghfghighijhijk"
+                                           "ijkljklmklmnlmnomnopnopq",
+                         56, out, 0) == 0);
+    CHECK(!memcmp(out, two256, 32));
+    CHECK(host_stats.sha_dma_bytes == 0);
+
+    // ********************************************************************** //
+    // a long message goes to the engine, whole or in odd unaligned parts
+    memset(big, 'a', sizeof(big));
+    host_stats_reset();
+    CHECK(mbedtls_sha256(big, BIGSIZE, out, 0) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+    CHECK(host_stats.sha_dma_bytes == BIGSIZE);
+
+    host_stats_reset();
+    CHECK(hash_parts(big + 1, BIGSIZE, odd, 8, 0, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+    CHECK(host_stats.sha_dma_bytes == BIGSIZE);
+
+    host_stats_reset();
+    CHECK(hash_parts(big + 3, BIGSIZE, odd, 8, 1, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+    CHECK(host_stats.sha_dma_bytes == 0);
+
+    // ********************************************************************** //
+    // both paths agree on every length around the hold buffer and blocks
+    rnd = big + 1;
+    srand(0x18);
+    for (uint32_t i = 0; i < 4096; i++)
+        rnd[i] = rand();
+    for (uint32_t len = 0; len <= 4 * SHA256_ALT_BUFSIZE + 1; len++) {
+        host_stats_reset();
+        CHECK(hash_parts(big, len, whole, 1, 0, out) == 0);
+        CHECK(host_stats.sha_dma_bytes ==
+              (len > SHA256_ALT_BUFSIZE ? len : 0));
+        CHECK(hash_parts(big, len, whole, 1, 1, ref) == 0);
+        CHECK(!memcmp(out, ref, 32));
+        CHECK(hash_parts(rnd, len, odd, 8, 0, out) == 0);
+        CHECK(hash_parts(rnd, len, whole, 1, 1, ref) == 0);
+        CHECK(!memcmp(out, ref, 32));
+    }
+
+    // ********************************************************************** //
+    // one message in the engine at a time, the second one is software
+    memset(big, 'a', sizeof(big));
+    mbedtls_sha256_init(&a);
+    mbedtls_sha256_init(&b);
+    mbedtls_sha256_init(&c);
+    host_stats_reset();
+    CHECK(mbedtls_sha256_starts(&a, 0) == 0);
+    CHECK(mbedtls_sha256_starts(&b, 0) == 0);
+    CHECK(mbedtls_sha256_update(&a, big, BIGSIZE / 2) == 0);
+    CHECK(a.path == SHA256_ALT_CRPT);
+    CHECK(mbedtls_sha256_update(&b, big, BIGSIZE / 2) == 0);
+    CHECK(b.path == SHA256_ALT_SW);
+    CHECK(host_stats.sha_dma_bytes < BIGSIZE / 2);
+
+    // sha256_dma.h users are refused meanwhile
+    CHECK(sha256_dma_start() != 0);
+
+    // a copy of the engine's message fails every call, of software works
+    mbedtls_sha256_clone(&c, &a);
+    CHECK(c.path == SHA256_ALT_CLONE);
+    CHECK(mbedtls_sha256_update(&c, big, 1) ==
+          MBEDTLS_ERR_PLATFORM_FEATURE_UNSUPPORTED);
+    CHECK(mbedtls_sha256_finish(&c, out) ==
+          MBEDTLS_ERR_PLATFORM_FEATURE_UNSUPPORTED);
+    mbedtls_sha256_clone(&c, &b);
+    CHECK(mbedtls_sha256_update(&c, big, BIGSIZE / 2) == 0);
+    CHECK(mbedtls_sha256_finish(&c, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+
+    CHECK(mbedtls_sha256_update(&a, big, BIGSIZE / 2) == 0);
+    CHECK(mbedtls_sha256_update(&b, big, BIGSIZE / 2) == 0);
+    CHECK(mbedtls_sha256_finish(&a, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+    CHECK(mbedtls_sha256_finish(&b, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+    CHECK(host_stats.sha_dma_bytes == BIGSIZE);
+
+    // finished, the engine is free again
+    CHECK(sha256_dma_start() == 0);
+    sha256_dma_stop();
+    CHECK(mbedtls_sha256_starts(&b, 0) == 0);
+    CHECK(mbedtls_sha256_update(&b, big, BIGSIZE) == 0);
+    CHECK(b.path == SHA256_ALT_CRPT);
+    // dropped unfinished, free too
+    mbedtls_sha256_free(&b);
+    CHECK(sha256_dma_start() == 0);
+
+    // a message while a sha256_dma.h digest runs stays in software
+    CHECK(mbedtls_sha256_starts(&a, 0) == 0);
+    CHECK(mbedtls_sha256_update(&a, big, BIGSIZE) == 0);
+    CHECK(a.path == SHA256_ALT_SW);
+    CHECK(mbedtls_sha256_finish(&a, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+    sha256_dma_stop();
+
+    CHECK(mbedtls_sha256_starts(&a, 0) == 0);
+    CHECK(mbedtls_sha256_update(&a, big, BIGSIZE) == 0);
+    CHECK(a.path == SHA256_ALT_CRPT);
+    CHECK(mbedtls_sha256_finish(&a, out) == 0);
+    CHECK(!memcmp(out, mil256, 32));
+
+    // SHA-224 is not set up on the engine
+    CHECK(mbedtls_sha256_starts(&a, 1) == 0);
+    CHECK(mbedtls_sha256_update(&a, big, BIGSIZE) == 0);
+    CHECK(a.path == SHA256_ALT_SW);
+    mbedtls_sha256_free(&a);
+    mbedtls_sha256_free(&c);
+
+    return TEST_RESULT("test_host_18");
+}
@@ -0,0 +1,95 @@
+/**
+ * @file test_host_19_multiword.c
+ * @author cy023
+ * @date 2026.10.17
+ * @brief flash_write_app() through FMC_WriteMultiple(), odd lengths and
+ *        bursts cut short.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "NuMicro.h"
+#include "device.h"
+#include "flash.h"
+#include "host.h"
+#include "host_test.h"
+
+#define AREA (8 * 1024)
+
+static uint8_t data[AREA] __attribute__((__aligned__(4)));
+
+static int all(const uint8_t *p, uint8_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++) {
+        if (p[i] != value)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Program len bytes to a blank area, check them and nothing past.
+ */
+static int write(uint32_t len)
+{
+    uint8_t *aprom = host_fmc_mem() + USER_APP_START;
+
+    memset(aprom, 0xFF, AREA);
+    if (flash_write_app(USER_APP_START, data, len))
+        return 0;
+    return !memcmp(aprom, data, len) && all(aprom + len, 0xFF, AREA - len);
+}
+
+int main()
+{
+    static const uint32_t lens[] = {4,   8,   12,  16,   24,   504,  508, 512,
+                                    520, 524, 536, 1032, 4096, 4104, 4108};
+    static const uint32_t bursts[] = {0, 16, 40, 264};
+    uint32_t row[4];
+
+    printf("[test_host_19]: multi-word program ...\n");
+
+    srand(0x19);
+    for (uint32_t i = 0; i < AREA; i++)
+        data[i] = rand();
+
+    CHECK(host_fmc_open(NULL) == 0);
+    FMC_Open();
+    FMC_ENABLE_AP_UPDATE();
+
+    // ********************************************************************** //
+    // the BSP's own behaviour: 8 bytes left at a row wrap the length around
+    memset(host_fmc_mem() + USER_APP_START, 0xFF, AREA);
+    memset(row, 0, sizeof(row));
+    CHECK(FMC_WriteMultiple(USER_APP_START, row, 8) < 0);
+    CHECK(!all(host_fmc_mem() + USER_APP_START + 8, 0xFF, 8));
+    CHECK(FMC_WriteMultiple(USER_APP_START + 8, row, 16) < 0);
+
+    // ********************************************************************** //
+    // every length, whole bursts and bursts cut short by an interrupt
+    for (uint32_t b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+        host_fmc_set_mp_burst(bursts[b]);
+        for (uint32_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            host_stats_reset();
+            CHECK(write(lens[i]));
+            if (!bursts[b])
+                CHECK(host_stats.fmc_isp_program ==
+                      (lens[i] & ~15UL) / FMC_MULTI_WORD_PROG_LEN +
+                          !!((lens[i] & ~15UL) % FMC_MULTI_WORD_PROG_LEN) +
+                          (lens[i] % 16) / 4);
+        }
+    }
+    host_fmc_set_mp_burst(0);
+
+    // unaligned buffer, word by word
+    host_stats_reset();
+    memmove(data + 1, data, 600);
+    memset(host_fmc_mem() + USER_APP_START, 0xFF, AREA);
+    CHECK(flash_write_app(USER_APP_START, data + 1, 600) == 0);
+    CHECK(!memcmp(host_fmc_mem() + USER_APP_START, data + 1, 600));
+    CHECK(host_stats.fmc_isp_program == 150);
+
+    FMC_DISABLE_AP_UPDATE();
+    FMC_Close();
+    return TEST_RESULT("test_host_19");
+}
@@ -14,11 +14,35 @@
 #include "NuMicro.h"
 #include "boot_system.h"
 #include "device.h"
+#include "crc32.h"
 #include "flash.h"
 
 #define BUFFSIZE 512
 uint8_t page_buffer[BUFFSIZE] = {0};
 
+#define TIMESIZE (4 * FMC_FLASH_PAGE_SIZE)
+static uint8_t time_buffer[TIMESIZE] __attribute__((__aligned__(4)));
+
+/**
+ * @brief The FMC checksum engine against the CRC engine's CRC-32, the one the
+ *        programmer's zlib crc32() matches in the v2 framing.
+ */
+static void check_checksum(const char *name, const uint8_t *buf)
+{
+    uint32_t fmc = 0, crc = crc32_update(0, buf, FMC_FLASH_PAGE_SIZE);
+    uint8_t ret = flash_checksum_app(USER_APP_START, FMC_FLASH_PAGE_SIZE, &fmc);
+
+    printf("checksum of %s: FMC 0x%08x, CRC-32 0x%08x, %s\n", name,
+           (unsigned) fmc, (unsigned) crc,
+           (!ret && fmc == crc) ? "OK" : "MISMATCH");
+}
+
+static void erase_time_area(void)
+{
+    for (uint32_t ofs = 0; ofs < TIMESIZE; ofs += FMC_FLASH_PAGE_SIZE)
+        FMC_Erase(USER_APP_START + ofs);
+}
+
 void printPage(char *s)
 {
     printf("\n\t[%s]\n", s);
@@ -78,6 +102,50 @@ int main()
     printf("verify_app_page after change one byte: %d\n",
            flash_verify_app_page(0, page_buffer));
 
+    // ********************************************************************** //
+
+    uint32_t t0, ms_word, ms_multi;
+
+    for (int i = 0; i < TIMESIZE; i++)
+        time_buffer[i] = i * 7;
+
+    erase_time_area();
+    t0 = system_get_tick();
+    for (uint32_t i = 0; i < TIMESIZE; i += 4)
+        FMC_Write(USER_APP_START + i, *(uint32_t *) (time_buffer + i));
+    ms_word = system_get_tick() - t0;
+
+    erase_time_area();
+    t0 = system_get_tick();
+    flash_write_app(USER_APP_START, time_buffer, TIMESIZE);
+    ms_multi = system_get_tick() - t0;
+
+    printf("%u KiB word by word: %u ms, multi-word: %u ms\n",
+           (unsigned) (TIMESIZE / 1024), (unsigned) ms_word,
+           (unsigned) ms_multi);
+    printf("verify multi-word: %d\n",
+           flash_verify_app(USER_APP_START, time_buffer, TIMESIZE));
+
+    // CMD_FLASH_SYNC_PAGE and CMD_FLASH_VERIFY rely on these being equal
+    check_checksum("a written page", time_buffer);
+    erase_time_area();
+    memset(time_buffer, 0xFF, FMC_FLASH_PAGE_SIZE);
+    check_checksum("an erased page", time_buffer);
+    for (int i = 0; i < TIMESIZE; i++)
+        time_buffer[i] = i * 7;
+
+    // 8 bytes past the last whole row, 4 past the last 16 byte unit
+    erase_time_area();
+    printf("write 520 B: %d, ",
+           flash_write_app(USER_APP_START, time_buffer, 520));
+    printf("verify: %d, ", flash_verify_app(USER_APP_START, time_buffer, 520));
+    printf("next word 0x%08x\n", (unsigned) FMC_Read(USER_APP_START + 520));
+    erase_time_area();
+    printf("write 4108 B: %d, ",
+           flash_write_app(USER_APP_START, time_buffer, 4108));
+    printf("verify: %d, ", flash_verify_app(USER_APP_START, time_buffer, 4108));
+    printf("next word 0x%08x\n", (unsigned) FMC_Read(USER_APP_START + 4108));
+
     printf("\t===================== earase all ======================\n");
     printPage("Before Erase all");
     // This action will erase all the app section !
@@ -14,20 +14,13 @@
 // entry point
 void lfs_test(void)
 {
-    // mount the filesystem
-    int err = lfs_mount(&lfs_w25q128jv, &cfg);
-
-    // reformat if we can't mount the filesystem
-    // this should only happen on the first boot
-    if (err) {
-        lfs_format(&lfs_w25q128jv, &cfg);
-        lfs_mount(&lfs_w25q128jv, &cfg);
-    }
+    // mount the filesystem, formatted on the first boot
+    lfs_port_mount_write("/boot_count");
 
     // read current count
     uint32_t boot_count = 0;
-    lfs_file_open(&lfs_w25q128jv, &lfs_file_w25q128jv, "boot_count",
-                  LFS_O_RDWR | LFS_O_CREAT);
+    lfs_file_opencfg(&lfs_w25q128jv, &lfs_file_w25q128jv, "boot_count",
+                     LFS_O_RDWR | LFS_O_CREAT, &lfs_file_cfg_w25q128jv);
     lfs_file_read(&lfs_w25q128jv, &lfs_file_w25q128jv, &boot_count,
                   sizeof(boot_count));
 